@@ -33,3 +33,12 @@
 # Don't use -pedantic flag in gcc command
 # NOPEDANTIC = yes
 
+# Measure time spent in phases of learning (see gng/stats.h)
+# STATS = yes
+
+
+# Build also single precision libgng-f32.a (and bin/*-f32) against
+# boruvka compiled with float as bor_real_t
+# F32 = yes
+# BORUVKA_F32_CFLAGS = -I/path/to/boruvka-f32
+# BORUVKA_F32_LIB = /path/to/boruvka-f32/libboruvka.a
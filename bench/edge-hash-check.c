@@ -0,0 +1,264 @@
+/**
+ * Checks edge hash table (gng/edge-hash.h) against reference set.
+ *
+ * Edges between N nodes are randomly added to, removed from and looked up
+ * in the table (both orders of ids are used) and every result is compared
+ * with a reference matrix of connected pairs. Edges are first mostly added
+ * so that the table grows several times and then mostly removed. After
+ * every CHECK_PERIOD operations (and at the end of each phase) all pairs
+ * are looked up, and it is checked that the number of occupied slots
+ * equals the number of stored edges.
+ *
+ * Then clusters wrapping around the end of the table are checked: pairs
+ * whose home slot is one of the last WRAP_SLOTS slots or one of the first
+ * WRAP_SLOTS slots are added to an empty table in random order, so that
+ * their cluster continues at the beginning of the table, and removed
+ * again in random order with all these pairs looked up after each
+ * removal.
+ * Prints one line per phase and exits with non-zero status if any check
+ * fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boruvka/alloc.h>
+#include "gng/edge-hash.h"
+#include "gng/rng.h"
+
+/** Number of nodes */
+#define N 200
+/** Number of random operations in each phase */
+#define OPS 200000
+/** Period of full checks in number of operations */
+#define CHECK_PERIOD 5000
+/** Number of slots at each end of table used by check of wrapping */
+#define WRAP_SLOTS 4
+/** Number of rounds of check of wrapping */
+#define WRAP_ROUNDS 1000
+
+static svo_rng_t rng;
+static char conn[N][N]; /*!< Reference set, conn[a][b] for a < b */
+static size_t conn_len;
+
+/** Unique fake edge of pair {a}, {b} */
+static void *edgeOf(uint32_t a, uint32_t b)
+{
+    if (a > b)
+        return edgeOf(b, a);
+    return (void *)(uintptr_t)(a * N + b + 1);
+}
+
+/** Returns true if lookup of pair {a}, {b} (in both orders) agrees with
+ *  the reference set */
+static int pairCheck(const svo_edge_hash_t *h, uint32_t a, uint32_t b)
+{
+    void *e;
+
+    e = (conn[BOR_MIN(a, b)][BOR_MAX(a, b)] ? edgeOf(a, b) : NULL);
+    return svoEdgeHashFind(h, a, b) == e && svoEdgeHashFind(h, b, a) == e;
+}
+
+/** Returns true if number of stored edges and occupied slots of {h}
+ *  agree with the reference set */
+static int lenCheck(const svo_edge_hash_t *h)
+{
+    size_t i, used;
+
+    used = 0;
+    for (i = 0; i < h->size; i++){
+        if (h->keys[i] != SVO_EDGE_HASH_EMPTY)
+            ++used;
+    }
+    return h->len == conn_len && used == h->len && 2 * h->len <= h->size;
+}
+
+/** Returns true if table {h} contains exactly the reference set */
+static int fullCheck(const svo_edge_hash_t *h)
+{
+    uint32_t a, b;
+
+    if (!lenCheck(h))
+        return 0;
+
+    for (a = 0; a < N; a++){
+        for (b = a + 1; b < N; b++){
+            if (!pairCheck(h, a, b))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/** Returns true if table {h} agrees with the reference set on all {len}
+ *  {pairs} */
+static int pairsCheck(const svo_edge_hash_t *h, const uint32_t *pairs,
+                      size_t len)
+{
+    size_t i;
+
+    if (!lenCheck(h))
+        return 0;
+
+    for (i = 0; i < len; i++){
+        if (!pairCheck(h, pairs[2 * i], pairs[2 * i + 1]))
+            return 0;
+    }
+    return 1;
+}
+
+static void add(svo_edge_hash_t *h, uint32_t a, uint32_t b)
+{
+    svoEdgeHashAdd(h, a, b, edgeOf(a, b));
+    conn[BOR_MIN(a, b)][BOR_MAX(a, b)] = 1;
+    ++conn_len;
+}
+
+static void removeEdge(svo_edge_hash_t *h, uint32_t a, uint32_t b)
+{
+    svoEdgeHashRemove(h, a, b);
+    conn[BOR_MIN(a, b)][BOR_MAX(a, b)] = 0;
+    --conn_len;
+}
+
+/** Performs OPS random operations, new edges are added with probability
+ *  {add_prob} if the random pair isn't connected yet */
+static int randomOps(svo_edge_hash_t *h, double add_prob, const char *name)
+{
+    size_t op, size;
+    uint32_t a, b;
+    int ok, grown;
+
+    ok = 1;
+    grown = 0;
+    for (op = 1; op <= OPS && ok; op++){
+        a = svoRngRange(&rng, N);
+        b = svoRngRange(&rng, N);
+        if (a == b)
+            continue;
+
+        if (conn[BOR_MIN(a, b)][BOR_MAX(a, b)]){
+            if (svoEdgeHashFind(h, a, b) != edgeOf(a, b))
+                ok = 0;
+            if (svoRngUniform(&rng) >= add_prob)
+                removeEdge(h, a, b);
+        }else{
+            if (svoEdgeHashFind(h, a, b) != NULL)
+                ok = 0;
+            if (svoRngUniform(&rng) < add_prob){
+                size = h->size;
+                add(h, a, b);
+                if (h->size != size)
+                    ++grown;
+            }
+        }
+
+        if (h->len != conn_len
+                || (op % CHECK_PERIOD == 0 && !fullCheck(h)))
+            ok = 0;
+    }
+    if (!fullCheck(h))
+        ok = 0;
+
+    printf("%s: edges %5lu, slots %6lu, grown %d times: %s\n", name,
+           (unsigned long)h->len, (unsigned long)h->size, grown,
+           (ok ? "ok" : "FAIL"));
+    return ok;
+}
+
+/** Shuffles {len} pairs stored in {pairs} */
+static void shuffle(uint32_t *pairs, size_t len)
+{
+    uint32_t t;
+    size_t i, j;
+
+    for (i = len; i > 1; i--){
+        j = svoRngRange(&rng, i);
+        t = pairs[2 * (i - 1)];
+        pairs[2 * (i - 1)] = pairs[2 * j];
+        pairs[2 * j] = t;
+        t = pairs[2 * (i - 1) + 1];
+        pairs[2 * (i - 1) + 1] = pairs[2 * j + 1];
+        pairs[2 * j + 1] = t;
+    }
+}
+
+static int wrapCheck(void)
+{
+    svo_edge_hash_t h;
+    uint32_t *pairs, a, b;
+    size_t pairs_len, slot, round, i, wrapped;
+    int ok;
+
+    svoEdgeHashInit(&h);
+
+    // pairs with home slot near either end of table
+    pairs = BOR_ALLOC_ARR(uint32_t, N * N);
+    pairs_len = 0;
+    for (a = 0; a < N; a++){
+        for (b = a + 1; b < N; b++){
+            slot = __svoEdgeHashSlot(&h, __svoEdgeHashKey(a, b));
+            if (slot < WRAP_SLOTS || slot >= h.size - WRAP_SLOTS){
+                pairs[2 * pairs_len]     = a;
+                pairs[2 * pairs_len + 1] = b;
+                ++pairs_len;
+            }
+        }
+    }
+    // all of them must fit into table without growing
+    if (2 * pairs_len > h.size)
+        pairs_len = h.size / 2;
+
+    ok = 1;
+    wrapped = 0;
+    for (round = 0; round < WRAP_ROUNDS && ok; round++){
+        shuffle(pairs, pairs_len);
+        for (i = 0; i < pairs_len; i++)
+            add(&h, pairs[2 * i], pairs[2 * i + 1]);
+
+        // count rounds where cluster really continues at the beginning
+        slot = (h.keys[0] == SVO_EDGE_HASH_EMPTY ? 0
+                    : __svoEdgeHashSlot(&h, h.keys[0]));
+        if (slot >= h.size - WRAP_SLOTS)
+            ++wrapped;
+        if (!pairsCheck(&h, pairs, pairs_len))
+            ok = 0;
+
+        shuffle(pairs, pairs_len);
+        for (i = 0; i < pairs_len && ok; i++){
+            removeEdge(&h, pairs[2 * i + 1], pairs[2 * i]);
+            if (!pairsCheck(&h, pairs, pairs_len))
+                ok = 0;
+        }
+    }
+    if (wrapped == 0)
+        ok = 0;
+
+    printf("wrap:   pairs %lu, rounds with wrapped cluster %lu/%lu: %s\n",
+           (unsigned long)pairs_len, (unsigned long)wrapped,
+           (unsigned long)round, (ok ? "ok" : "FAIL"));
+
+    BOR_FREE(pairs);
+    svoEdgeHashFree(&h);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    svo_edge_hash_t h;
+    int ok;
+
+    svoRngInit(&rng, 1);
+
+    svoEdgeHashInit(&h);
+    ok = randomOps(&h, 0.9, "grow  ");
+    ok &= randomOps(&h, 0.1, "shrink");
+    svoEdgeHashFree(&h);
+
+    memset(conn, 0, sizeof(conn));
+    conn_len = 0;
+    ok &= wrapCheck();
+
+    printf("%s\n", (ok ? "OK" : "FAILED"));
+    return (ok ? 0 : 1);
+}
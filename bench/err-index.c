@@ -0,0 +1,207 @@
+/**
+ * Compares structures for finding node with highest error counter
+ * (SVO_ERR_INDEX_HEAP vs. SVO_ERR_INDEX_TREE).
+ *
+ * First the structures alone are exercised with the access pattern of
+ * GNG, i.e., {lambda} updates of error counter of random node followed
+ * by one query for maximum, then whole GNG-Eu is run on uniformly
+ * distributed input signals with each of them.
+ * Results are printed to stdout as CSV.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <boruvka/alloc.h>
+#include <boruvka/pairheap.h>
+#include "gng/err-tree.h"
+#include "gng/gng-eu.h"
+
+struct _el_t {
+    bor_real_t err;
+    bor_pairheap_node_t heap;
+    svo_err_tree_el_t tree;
+};
+typedef struct _el_t el_t;
+
+static int dim;
+static size_t max_nodes;
+static bor_vec_t *is;
+static svo_gng_eu_t *gng;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
+
+static bor_real_t rnd(void)
+{
+    return (bor_real_t)rand() / (bor_real_t)RAND_MAX;
+}
+
+static int heapLT(const bor_pairheap_node_t *n1,
+                  const bor_pairheap_node_t *n2, void *data)
+{
+    el_t *e1 = bor_container_of(n1, el_t, heap);
+    el_t *e2 = bor_container_of(n2, el_t, heap);
+    return e1->err > e2->err;
+}
+
+static void benchIndex(int type, size_t len, size_t lambda, size_t queries)
+{
+    el_t *els;
+    bor_pairheap_t *heap = NULL;
+    svo_err_tree_t tree;
+    size_t i, j;
+    el_t *e;
+    double start, elapsed;
+
+    els = BOR_ALLOC_ARR(el_t, len);
+    srand(1);
+
+    if (type == SVO_ERR_INDEX_TREE){
+        svoErrTreeInit(&tree);
+    }else{
+        heap = borPairHeapNew(heapLT, NULL);
+    }
+
+    for (i = 0; i < len; i++){
+        els[i].err = rnd();
+        if (type == SVO_ERR_INDEX_TREE){
+            svoErrTreeAdd(&tree, &els[i].tree, els[i].err);
+        }else{
+            borPairHeapAdd(heap, &els[i].heap);
+        }
+    }
+
+    start = now();
+    for (i = 0; i < queries; i++){
+        for (j = 0; j < lambda; j++){
+            e = &els[rand() % len];
+            e->err += rnd();
+            if (type == SVO_ERR_INDEX_TREE){
+                svoErrTreeUpdate(&tree, &e->tree, e->err);
+            }else{
+                borPairHeapUpdate(heap, &e->heap);
+            }
+        }
+
+        // node with highest error is found and its error decreased as
+        // in svoGNGEuNewNode()
+        if (type == SVO_ERR_INDEX_TREE){
+            e = bor_container_of(svoErrTreeMax(&tree), el_t, tree);
+            e->err *= BOR_REAL(0.5);
+            svoErrTreeUpdate(&tree, &e->tree, e->err);
+        }else{
+            e = bor_container_of(borPairHeapMin(heap), el_t, heap);
+            e->err *= BOR_REAL(0.5);
+            borPairHeapUpdate(heap, &e->heap);
+        }
+    }
+    elapsed = now() - start;
+
+    printf("index,%s,0,%d,%d,%f,%f\n",
+           (type == SVO_ERR_INDEX_TREE ? "tree" : "heap"),
+           (int)len, (int)lambda, elapsed,
+           (double)(queries * (lambda + 1)) / elapsed);
+
+    if (type == SVO_ERR_INDEX_TREE){
+        svoErrTreeFree(&tree);
+    }else{
+        borPairHeapDel(heap);
+    }
+    BOR_FREE(els);
+}
+
+
+static int terminate(void *data)
+{
+    return svoGNGEuNodesLen(gng) >= max_nodes;
+}
+
+static const bor_vec_t *inputSignal(void *data)
+{
+    int i;
+
+    for (i = 0; i < dim; i++)
+        borVecSet(is, i, rnd());
+    return is;
+}
+
+static void benchGNGEu(int type)
+{
+    svo_gng_eu_params_t params;
+    svo_gng_eu_ops_t ops;
+    bor_real_t aabb[2 * 64];
+    double start, elapsed;
+    int i;
+
+    srand(1);
+
+    svoGNGEuParamsInit(&params);
+    params.dim = dim;
+    params.err_index = type;
+    params.nn.type = BOR_NN_GUG;
+    params.nn.gug.num_cells = 0;
+    params.nn.gug.max_dens = 0.1;
+    params.nn.gug.expand_rate = 1.5;
+    for (i = 0; i < dim; i++){
+        aabb[2 * i]     = BOR_ZERO;
+        aabb[2 * i + 1] = BOR_ONE;
+    }
+    params.nn.gug.aabb = aabb;
+
+    svoGNGEuOpsInit(&ops);
+    ops.terminate    = terminate;
+    ops.input_signal = inputSignal;
+
+    start = now();
+    gng = svoGNGEuNew(&ops, &params);
+    svoGNGEuRun(gng);
+    elapsed = now() - start;
+
+    printf("gng-eu,%s,%d,%d,%d,%f,%f\n",
+           (type == SVO_ERR_INDEX_TREE ? "tree" : "heap"),
+           dim, (int)max_nodes, (int)params.lambda, elapsed,
+           (double)max_nodes / elapsed);
+
+    svoGNGEuDel(gng);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t len;
+
+    if (argc != 1 && argc != 3){
+        fprintf(stderr, "Usage: %s [dim max_nodes]\n", argv[0]);
+        return -1;
+    }
+
+    dim = 3;
+    max_nodes = 10000;
+    if (argc == 3){
+        dim = atoi(argv[1]);
+        max_nodes = atoi(argv[2]);
+    }
+    if (dim < 1 || dim > 64){
+        fprintf(stderr, "Error: dim must be between 1 and 64\n");
+        return -1;
+    }
+    is = borVecNew(dim);
+
+    // rate is number of updates of error counters per second for "index"
+    // rows and number of created nodes per second for "gng-eu" rows
+    printf("bench,index,dim,nodes,lambda,time_s,rate\n");
+    for (len = 1000; len <= max_nodes * 10; len *= 10){
+        benchIndex(SVO_ERR_INDEX_HEAP, len, 200, 10000);
+        benchIndex(SVO_ERR_INDEX_TREE, len, 200, 10000);
+    }
+
+    benchGNGEu(SVO_ERR_INDEX_HEAP);
+    benchGNGEu(SVO_ERR_INDEX_TREE);
+
+    borVecDel(is);
+    return 0;
+}
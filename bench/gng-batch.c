@@ -0,0 +1,403 @@
+/**
+ * Checks batched learning of GNG (svoGNGLearnBatch(), gng/gng.h).
+ *
+ * Net of 2-D nodes (linear nearest neighbor search) learns from uniformly
+ * distributed input signals until it has {max_nodes} nodes (-n, default
+ * 300). Input signals are returned in one reused buffer, as most users of
+ * ops.input_signal do. The same learning is run in several variants with
+ * the same seed:
+ *   - learn:      params.lambda times svoGNGLearn() per cycle (reference),
+ *   - batch:      svoGNGLearnBatch() without any batched operation,
+ *   - batch-is:   svoGNGLearnBatch() with ops.input_signal_batch,
+ *   - batch-many: svoGNGLearnBatch() with ops.move_towards_many,
+ *   - batch-nearest: svoGNGRun() with ops.nearest_batch (and
+ *                 ops.input_signal returning signals that stay valid for
+ *                 the whole batch).
+ * It is checked that all variants without ops.nearest_batch end with the
+ * same net as the reference, i.e., the same nodes with the same weights
+ * and error counters in the same order and the same edges. The net learned
+ * with ops.nearest_batch is different, so it is only checked that it has
+ * {max_nodes} nodes, each edge connects two different nodes of the net
+ * and no node is isolated.
+ * Prints one line per variant and exits with non-zero status if any check
+ * fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boruvka/alloc.h>
+#include "gng/gng.h"
+#include "gng/rng.h"
+
+/** Number of input signals valid at once for ops.nearest_batch, must
+ *  not be lower than params.lambda */
+#define POOL_LEN 1024
+
+struct _node_t {
+    svo_gng_node_t gng;
+    bor_real_t w[2];
+    size_t id; /*!< Order of creation */
+};
+typedef struct _node_t node_t;
+
+#define NODE(n) bor_container_of((n), node_t, gng)
+
+/** Summary of learned net used for comparison */
+struct _net_t {
+    size_t nodes_len;
+    size_t *ids;       /*!< Ids of nodes in order of svoGNGNodes() */
+    bor_real_t *w;     /*!< Weights of nodes in the same order */
+    bor_real_t *err;   /*!< Error counters in the same order */
+    size_t edges_len;
+    size_t *edges;     /*!< Pairs of node ids in order of svoGNGEdges() */
+};
+typedef struct _net_t net_t;
+
+static size_t max_nodes = 300;
+static svo_gng_t *gng;
+static svo_rng_t rng;
+static size_t next_id;
+static bor_real_t is_buf[2];
+static bor_real_t pool[2 * POOL_LEN];
+static size_t pool_pos;
+
+static node_t *nodeNew(const bor_real_t *w)
+{
+    node_t *n;
+
+    n = BOR_ALLOC(node_t);
+    n->w[0] = w[0];
+    n->w[1] = w[1];
+    n->id = next_id++;
+    return n;
+}
+
+static svo_gng_node_t *newNode(const void *is, void *data)
+{
+    return &nodeNew((const bor_real_t *)is)->gng;
+}
+
+static svo_gng_node_t *newNodeBetween(const svo_gng_node_t *n1,
+                                      const svo_gng_node_t *n2, void *data)
+{
+    bor_real_t w[2];
+
+    w[0] = (NODE(n1)->w[0] + NODE(n2)->w[0]) * BOR_REAL(0.5);
+    w[1] = (NODE(n1)->w[1] + NODE(n2)->w[1]) * BOR_REAL(0.5);
+    return &nodeNew(w)->gng;
+}
+
+static void delNode(svo_gng_node_t *n, void *data)
+{
+    BOR_FREE(NODE(n));
+}
+
+/** Returns signal in reused buffer */
+static const void *inputSignal(void *data)
+{
+    is_buf[0] = svoRngUniform(&rng);
+    is_buf[1] = svoRngUniform(&rng);
+    return is_buf;
+}
+
+static void inputSignalBatch(const void **is, size_t k, void *data)
+{
+    size_t i;
+
+    for (i = 0; i < k; i++)
+        is[i] = inputSignal(data);
+}
+
+/** Returns signal that stays valid for next POOL_LEN - 1 calls */
+static const void *inputSignalPool(void *data)
+{
+    bor_real_t *is;
+
+    is = pool + 2 * pool_pos;
+    pool_pos = (pool_pos + 1) % POOL_LEN;
+    is[0] = svoRngUniform(&rng);
+    is[1] = svoRngUniform(&rng);
+    return is;
+}
+
+static bor_real_t dist2(const void *is, const svo_gng_node_t *n, void *data)
+{
+    const bor_real_t *v = (const bor_real_t *)is;
+    bor_real_t dx, dy;
+
+    dx = v[0] - NODE(n)->w[0];
+    dy = v[1] - NODE(n)->w[1];
+    return dx * dx + dy * dy;
+}
+
+static void nearest(const void *is, svo_gng_node_t **n1,
+                    svo_gng_node_t **n2, void *data)
+{
+    bor_list_t *list, *item;
+    svo_gng_node_t *n;
+    bor_real_t d, d1, d2;
+
+    *n1 = *n2 = NULL;
+    d1 = d2 = BOR_REAL_MAX;
+
+    list = svoGNGNodes(gng);
+    BOR_LIST_FOR_EACH(list, item){
+        n = svoGNGNodeFromList(item);
+        d = dist2(is, n, data);
+        if (d < d1){
+            *n2 = *n1;
+            d2 = d1;
+            *n1 = n;
+            d1 = d;
+        }else if (d < d2){
+            *n2 = n;
+            d2 = d;
+        }
+    }
+}
+
+static void nearestBatch(const void **is, size_t k, svo_gng_node_t **n,
+                         void *data)
+{
+    size_t i;
+
+    for (i = 0; i < k; i++)
+        nearest(is[i], &n[2 * i], &n[2 * i + 1], data);
+}
+
+static void moveTowards(svo_gng_node_t *n, const void *is,
+                        bor_real_t fraction, void *data)
+{
+    const bor_real_t *v = (const bor_real_t *)is;
+
+    NODE(n)->w[0] += fraction * (v[0] - NODE(n)->w[0]);
+    NODE(n)->w[1] += fraction * (v[1] - NODE(n)->w[1]);
+}
+
+static void moveTowardsMany(svo_gng_node_t *winner,
+                            svo_gng_node_t **neighbors, size_t len,
+                            const void *is, bor_real_t eb, bor_real_t en,
+                            void *data)
+{
+    size_t i;
+
+    moveTowards(winner, is, eb, data);
+    for (i = 0; i < len; i++)
+        moveTowards(neighbors[i], is, en, data);
+}
+
+static int terminate(void *data)
+{
+    return svoGNGNodesLen(gng) >= max_nodes;
+}
+
+/** Same loop as svoGNGRun(), learns by svoGNGLearnBatch() if {batch} is
+ *  true and by svoGNGLearn() otherwise */
+static void run(int batch)
+{
+    size_t i, lambda;
+
+    lambda = gng->params.lambda;
+    svoGNGInit(gng);
+    do {
+        if (batch){
+            svoGNGLearnBatch(gng, lambda);
+        }else{
+            for (i = 0; i < lambda; i++)
+                svoGNGLearn(gng);
+        }
+        svoGNGNewNode(gng);
+    } while (!terminate(NULL));
+}
+
+static void netSummary(net_t *net)
+{
+    bor_list_t *list, *item;
+    svo_gng_node_t *n;
+    svo_gng_edge_t *e;
+    bor_net_edge_t *ne;
+    size_t i;
+
+    net->nodes_len = svoGNGNodesLen(gng);
+    net->ids = BOR_ALLOC_ARR(size_t, net->nodes_len);
+    net->w   = BOR_ALLOC_ARR(bor_real_t, 2 * net->nodes_len);
+    net->err = BOR_ALLOC_ARR(bor_real_t, net->nodes_len);
+    i = 0;
+    list = svoGNGNodes(gng);
+    BOR_LIST_FOR_EACH(list, item){
+        n = svoGNGNodeFromList(item);
+        net->ids[i] = NODE(n)->id;
+        net->w[2 * i]     = NODE(n)->w[0];
+        net->w[2 * i + 1] = NODE(n)->w[1];
+        net->err[i] = svoGNGNodeErr(gng, n);
+        ++i;
+    }
+
+    net->edges_len = svoGNGEdgesLen(gng);
+    net->edges = BOR_ALLOC_ARR(size_t, 2 * net->edges_len);
+    i = 0;
+    list = svoGNGEdges(gng);
+    BOR_LIST_FOR_EACH(list, item){
+        e = svoGNGEdgeFromList(item);
+        ne = svoGNGEdgeToNet(e);
+        net->edges[2 * i]
+            = NODE(svoGNGNodeFromNet(borNetEdgeNode(ne, 0)))->id;
+        net->edges[2 * i + 1]
+            = NODE(svoGNGNodeFromNet(borNetEdgeNode(ne, 1)))->id;
+        ++i;
+    }
+}
+
+static void netFree(net_t *net)
+{
+    BOR_FREE(net->ids);
+    BOR_FREE(net->w);
+    BOR_FREE(net->err);
+    BOR_FREE(net->edges);
+}
+
+static int netEq(const net_t *a, const net_t *b)
+{
+    if (a->nodes_len != b->nodes_len || a->edges_len != b->edges_len)
+        return 0;
+    return memcmp(a->ids, b->ids, sizeof(size_t) * a->nodes_len) == 0
+            && memcmp(a->w, b->w, sizeof(bor_real_t) * 2 * a->nodes_len) == 0
+            && memcmp(a->err, b->err,
+                      sizeof(bor_real_t) * a->nodes_len) == 0
+            && memcmp(a->edges, b->edges,
+                      sizeof(size_t) * 2 * a->edges_len) == 0;
+}
+
+/** Checks that net has {max_nodes} nodes and no invalid edge or isolated
+ *  node */
+static int netValid(const net_t *net)
+{
+    char *connected;
+    size_t i, j, a, b;
+    int ok;
+
+    if (net->nodes_len != max_nodes)
+        return 0;
+
+    connected = BOR_ALLOC_ARR(char, next_id);
+    memset(connected, 0, next_id);
+    ok = 1;
+    for (i = 0; i < net->edges_len; i++){
+        a = net->edges[2 * i];
+        b = net->edges[2 * i + 1];
+        for (j = 0; j < net->nodes_len && net->ids[j] != a; j++);
+        if (j == net->nodes_len)
+            ok = 0;
+        for (j = 0; j < net->nodes_len && net->ids[j] != b; j++);
+        if (j == net->nodes_len || a == b)
+            ok = 0;
+        connected[a] = connected[b] = 1;
+    }
+    for (i = 0; i < net->nodes_len; i++){
+        if (!connected[net->ids[i]])
+            ok = 0;
+    }
+    BOR_FREE(connected);
+    return ok;
+}
+
+/** Learns net using {ops} and stores its summary into {net}. Negative
+ *  {batch} means learning by svoGNGRun(), see run() otherwise. */
+static void learn(const svo_gng_ops_t *ops, int batch, net_t *net)
+{
+    svo_gng_params_t params;
+
+    svoGNGParamsInit(&params);
+    svoRngInit(&rng, 1);
+    next_id = 0;
+    pool_pos = 0;
+
+    gng = svoGNGNew(ops, &params);
+    if (batch < 0){
+        svoGNGRun(gng);
+    }else{
+        run(batch);
+    }
+    netSummary(net);
+    svoGNGDel(gng);
+}
+
+int main(int argc, char *argv[])
+{
+    svo_gng_ops_t ops;
+    net_t ref, net;
+    int ok, ret;
+
+    if (argc == 3 && strcmp(argv[1], "-n") == 0)
+        max_nodes = strtoul(argv[2], NULL, 10);
+    if (max_nodes < 3)
+        max_nodes = 3;
+
+    svoGNGOpsInit(&ops);
+    ops.new_node         = newNode;
+    ops.new_node_between = newNodeBetween;
+    ops.del_node         = delNode;
+    ops.input_signal     = inputSignal;
+    ops.nearest          = nearest;
+    ops.dist2            = dist2;
+    ops.move_towards     = moveTowards;
+    ops.terminate        = terminate;
+
+    ret = 0;
+
+    learn(&ops, 0, &ref);
+    ok = netValid(&ref);
+    printf("learn:         nodes %5lu, edges %5lu: %s\n",
+           (unsigned long)ref.nodes_len, (unsigned long)ref.edges_len,
+           (ok ? "ok" : "FAIL"));
+    if (!ok)
+        ret = -1;
+
+    learn(&ops, 1, &net);
+    ok = netEq(&ref, &net);
+    printf("batch:         nodes %5lu, edges %5lu: %s\n",
+           (unsigned long)net.nodes_len, (unsigned long)net.edges_len,
+           (ok ? "ok" : "FAIL"));
+    if (!ok)
+        ret = -1;
+    netFree(&net);
+
+    ops.input_signal_batch = inputSignalBatch;
+    learn(&ops, 1, &net);
+    ok = netEq(&ref, &net);
+    printf("batch-is:      nodes %5lu, edges %5lu: %s\n",
+           (unsigned long)net.nodes_len, (unsigned long)net.edges_len,
+           (ok ? "ok" : "FAIL"));
+    if (!ok)
+        ret = -1;
+    netFree(&net);
+    ops.input_signal_batch = NULL;
+
+    ops.move_towards_many = moveTowardsMany;
+    learn(&ops, 1, &net);
+    ok = netEq(&ref, &net);
+    printf("batch-many:    nodes %5lu, edges %5lu: %s\n",
+           (unsigned long)net.nodes_len, (unsigned long)net.edges_len,
+           (ok ? "ok" : "FAIL"));
+    if (!ok)
+        ret = -1;
+    netFree(&net);
+    ops.move_towards_many = NULL;
+
+    ops.input_signal  = inputSignalPool;
+    ops.nearest_batch = nearestBatch;
+    learn(&ops, -1, &net);
+    ok = netValid(&net);
+    printf("batch-nearest: nodes %5lu, edges %5lu: %s\n",
+           (unsigned long)net.nodes_len, (unsigned long)net.edges_len,
+           (ok ? "ok" : "FAIL"));
+    if (!ok)
+        ret = -1;
+    netFree(&net);
+
+    netFree(&ref);
+
+    printf("%s\n", (ret == 0 ? "OK" : "FAILED"));
+    return (ret == 0 ? 0 : 1);
+}
@@ -0,0 +1,161 @@
+/**
+ * Builds and checks C++ wrapper svo::Gng (gng/gng.hpp).
+ *
+ * svo::Gng is instantiated with 2-D points as Traits, the default
+ * svo::GngLinearIndex and a counting allocator, run() learns from
+ * uniformly distributed input signals until net has {max_nodes} nodes
+ * (-n, default 500) and then it is checked that:
+ *   - number of nodes is {max_nodes} and equals number of nodes allocated
+ *     by the allocator,
+ *   - each edge connects two different nodes of the net,
+ *   - no two edges connect the same pair of nodes,
+ *   - edgesLen() equals number of edges visited by forEachEdge(),
+ *   - no node is isolated.
+ * Prints elapsed time and exits with non-zero status if any check fails.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <set>
+#include <utility>
+#include <gng/gng.hpp>
+
+struct Point {
+    bor_real_t x, y;
+};
+
+struct PointTraits {
+    using node_type   = Point;
+    using weight_type = Point;
+
+    static weight_type &weight(node_type &n) { return n; }
+    static const weight_type &weight(const node_type &n) { return n; }
+
+    static bor_real_t dist2(const weight_type &a, const weight_type &b)
+    {
+        bor_real_t dx = a.x - b.x, dy = a.y - b.y;
+        return dx * dx + dy * dy;
+    }
+
+    static void move(weight_type &w, const weight_type &is,
+                     bor_real_t fraction)
+    {
+        w.x += fraction * (is.x - w.x);
+        w.y += fraction * (is.y - w.y);
+    }
+};
+
+/** Number of live elements allocated by CountingAlloc */
+static long alloc_live = 0;
+
+template <typename T>
+struct CountingAlloc {
+    using value_type = T;
+
+    CountingAlloc() = default;
+    template <typename U>
+    CountingAlloc(const CountingAlloc<U> &) {}
+
+    T *allocate(std::size_t n)
+    {
+        alloc_live += (long)n;
+        return static_cast<T *>(std::malloc(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        alloc_live -= (long)n;
+        std::free(p);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAlloc<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const CountingAlloc<U> &) const { return false; }
+};
+
+using Net = svo::Gng<PointTraits, svo::GngLinearIndex<PointTraits>,
+                     CountingAlloc<svo::GngNode<PointTraits>>>;
+
+static int fails = 0;
+
+static void check(bool cond, const char *msg)
+{
+    if (!cond){
+        std::fprintf(stderr, "FAIL: %s\n", msg);
+        ++fails;
+    }
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t max_nodes = 500;
+    std::set<const Point *> nodes;
+    std::set<std::pair<const Point *, const Point *>> edges;
+    std::set<const Point *> connected;
+    std::size_t edges_visited = 0;
+    bool edges_valid = true, edges_unique = true;
+    svo_rng_t rng;
+    Point is;
+    double start;
+
+    if (argc == 3 && std::strcmp(argv[1], "-n") == 0)
+        max_nodes = std::strtoul(argv[2], NULL, 10);
+    if (max_nodes < 2)
+        max_nodes = 2;
+
+    svoRngInit(&rng, 1);
+
+    start = now();
+    {
+        Net gng;
+
+        gng.run([&]() -> const Point & {
+                    is.x = (bor_real_t)svoRngUniform(&rng);
+                    is.y = (bor_real_t)svoRngUniform(&rng);
+                    return is;
+                },
+                [&](const Net &g){ return g.nodesLen() >= max_nodes; });
+
+        gng.forEachNode([&](const Point &n){ nodes.insert(&n); });
+        gng.forEachEdge([&](const Point &a, const Point &b){
+            const Point *p1 = &a, *p2 = &b;
+
+            ++edges_visited;
+            if (p1 == p2 || !nodes.count(p1) || !nodes.count(p2))
+                edges_valid = false;
+            if (p2 < p1)
+                std::swap(p1, p2);
+            if (!edges.insert(std::make_pair(p1, p2)).second)
+                edges_unique = false;
+            connected.insert(p1);
+            connected.insert(p2);
+        });
+
+        check(gng.nodesLen() == max_nodes, "number of nodes");
+        check(nodes.size() == gng.nodesLen(), "nodes visited");
+        check(alloc_live == (long)gng.nodesLen(), "nodes allocated");
+        check(edges_valid, "edge connects two different nodes of net");
+        check(edges_unique, "edges are unique");
+        check(edges_visited == gng.edgesLen(), "edges visited");
+        check(connected.size() == nodes.size(), "no isolated node");
+
+        std::printf("nodes: %lu, edges: %lu, time: %f s\n",
+                    (unsigned long)gng.nodesLen(),
+                    (unsigned long)gng.edgesLen(), now() - start);
+    }
+    check(alloc_live == 0, "all nodes released");
+
+    if (fails == 0)
+        std::printf("OK\n");
+    return fails == 0 ? 0 : 1;
+}
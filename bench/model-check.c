@@ -0,0 +1,339 @@
+/**
+ * Checks trained model (gng/model.h) against brute force.
+ *
+ * For several dimensions and numbers of nodes random net (nodes uniformly
+ * distributed in unit hypercube, each node connected to the next one) is
+ * exported by svoModelWrite(), re-opened by svoModelOpen() and it is
+ * checked that:
+ *   - weight vectors and neighbors of nodes survive the round trip,
+ *   - svoModelNearest() finds node at the same distance as linear search
+ *     over all nodes for random points,
+ *   - svoModelQuantize() in several threads gives the same results as
+ *     svoModelNearest().
+ * Then the model file is corrupted in several ways (split axis out of
+ * dimension, decreasing or too large CSR offset, neighbor index out of
+ * range, zero number of nodes) and it is checked that svoModelOpen()
+ * refuses each such file.
+ * Model is written into file given by -o (default model-check.mdl in
+ * current directory) which is removed at the end.
+ * Prints one line per configuration and exits with non-zero status if any
+ * check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <boruvka/alloc.h>
+#include "gng/model.h"
+#include "gng/rng.h"
+
+/** Number of random query points per configuration */
+#define QUERIES 10000
+/** Number of threads used for svoModelQuantize() */
+#define THREADS 4
+
+static const int dims[] = { 1, 2, 3, 8 };
+#define DIMS_LEN (sizeof(dims) / sizeof(dims[0]))
+
+static const size_t lens[] = { 1, 2, 7, 100, 5000 };
+#define LENS_LEN (sizeof(lens) / sizeof(lens[0]))
+
+static const char *fn = "model-check.mdl";
+static svo_rng_t rng;
+
+static bor_real_t dist2(int dim, const bor_real_t *a, const bor_real_t *b)
+{
+    bor_real_t d, dist;
+    int i;
+
+    dist = BOR_ZERO;
+    for (i = 0; i < dim; i++){
+        d = a[i] - b[i];
+        dist += d * d;
+    }
+    return dist;
+}
+
+static bor_real_t linearNearest(int dim, size_t len, const bor_real_t **w,
+                                const bor_real_t *v)
+{
+    bor_real_t d, best;
+    size_t i;
+
+    best = BOR_REAL_MAX;
+    for (i = 0; i < len; i++){
+        d = dist2(dim, w[i], v);
+        if (d < best)
+            best = d;
+    }
+    return best;
+}
+
+static int hasNeighbor(const svo_model_t *m, size_t i, uint32_t j)
+{
+    const uint32_t *neigh;
+    size_t len, k;
+
+    neigh = svoModelNeighbors(m, i, &len);
+    for (k = 0; k < len; k++){
+        if (neigh[k] == j)
+            return 1;
+    }
+    return 0;
+}
+
+/** Returns true if {a} and {b} are equal up to rounding */
+static int eq(bor_real_t a, bor_real_t b)
+{
+    return fabs(a - b) <= 1E-5 * (1. + fabs(a));
+}
+
+/** Compares model {m} with net it was written from */
+static void checkModel(const svo_model_t *m, int dim, size_t len,
+                       const bor_real_t **w, size_t edges_len,
+                       const uint32_t *edges, const uint32_t *order,
+                       const bor_real_t *qs, size_t *bad)
+{
+    uint32_t *ids;
+    bor_real_t *qdist, d, lin;
+    const bor_real_t *q;
+    size_t i, id, a, b;
+
+    for (i = 0; i < len; i++){
+        if (memcmp(svoModelWeight(m, order[i]), w[i],
+                   sizeof(bor_real_t) * dim) != 0)
+            ++bad[0];
+    }
+
+    for (i = 0; i < edges_len; i++){
+        a = order[edges[2 * i]];
+        b = order[edges[2 * i + 1]];
+        if (!hasNeighbor(m, a, b) || !hasNeighbor(m, b, a))
+            ++bad[1];
+    }
+
+    ids   = BOR_ALLOC_ARR(uint32_t, QUERIES);
+    qdist = BOR_ALLOC_ARR(bor_real_t, QUERIES);
+    svoModelQuantize(m, qs, QUERIES, ids, qdist, THREADS);
+
+    for (i = 0; i < QUERIES; i++){
+        q = qs + i * dim;
+        id = svoModelNearest(m, q, &d);
+        lin = linearNearest(dim, len, w, q);
+        if (id >= len || !eq(d, lin)
+                || !eq(dist2(dim, svoModelWeight(m, id), q), lin))
+            ++bad[2];
+        if (ids[i] != id || qdist[i] != d)
+            ++bad[3];
+    }
+
+    BOR_FREE(ids);
+    BOR_FREE(qdist);
+}
+
+static int check(int dim, size_t len)
+{
+    bor_real_t *ws, *qs;
+    const bor_real_t **w;
+    uint32_t *edges, *order;
+    size_t i, edges_len, bad[4] = { 0, 0, 0, 0 };
+    svo_model_t m;
+    int j;
+
+    ws = BOR_ALLOC_ARR(bor_real_t, len * dim);
+    w  = BOR_ALLOC_ARR(const bor_real_t *, len);
+    for (i = 0; i < len; i++){
+        for (j = 0; j < dim; j++)
+            ws[i * dim + j] = svoRngUniform(&rng);
+        w[i] = ws + i * dim;
+    }
+
+    edges_len = len - 1;
+    edges = BOR_ALLOC_ARR(uint32_t, 2 * len);
+    for (i = 0; i < edges_len; i++){
+        edges[2 * i]     = i;
+        edges[2 * i + 1] = i + 1;
+    }
+    order = BOR_ALLOC_ARR(uint32_t, len);
+
+    // query points also slightly outside of the hypercube
+    qs = BOR_ALLOC_ARR(bor_real_t, QUERIES * dim);
+    for (i = 0; i < QUERIES * dim; i++)
+        qs[i] = svoRngUniform(&rng) * 1.2 - 0.1;
+
+    if (svoModelWrite(fn, dim, len, w, edges_len, edges, order) != 0
+            || svoModelOpen(&m, fn) != 0){
+        bad[0] = bad[1] = bad[2] = bad[3] = 1;
+    }else{
+        if (m.dim != dim || m.len != len || m.edges_len != edges_len){
+            bad[0] = bad[1] = bad[2] = bad[3] = 1;
+        }else{
+            checkModel(&m, dim, len, w, edges_len, edges, order, qs, bad);
+        }
+        svoModelClose(&m);
+    }
+
+    printf("dim %d, len %5lu: weights %s, neighbors %s, nearest %s,"
+           " quantize %s\n", dim, (unsigned long)len,
+           (bad[0] ? "FAIL" : "ok"), (bad[1] ? "FAIL" : "ok"),
+           (bad[2] ? "FAIL" : "ok"), (bad[3] ? "FAIL" : "ok"));
+
+    BOR_FREE(ws);
+    BOR_FREE(w);
+    BOR_FREE(edges);
+    BOR_FREE(order);
+    BOR_FREE(qs);
+
+    return (bad[0] || bad[1] || bad[2] || bad[3]) ? -1 : 0;
+}
+
+/** Corruptions of model file checked by checkCorrupted() */
+enum {
+    CORRUPT_NONE = 0,
+    CORRUPT_AXIS,
+    CORRUPT_ADJ_PTR_DEC,
+    CORRUPT_ADJ_PTR_END,
+    CORRUPT_ADJ,
+    CORRUPT_EMPTY,
+    CORRUPT_LEN
+};
+
+static const char *corrupt_names[CORRUPT_LEN] = {
+    "none", "axis", "adj_ptr decreasing", "adj_ptr end", "adj", "empty"
+};
+
+/** Rewrites model file {fn} of {size} bytes {buf} with corruption {c} */
+static int corrupt(const char *buf, size_t size, int c)
+{
+    svo_model_header_t h;
+    char *b;
+    uint64_t u64;
+    uint32_t u32;
+    FILE *fout;
+    int ret;
+
+    b = BOR_ALLOC_ARR(char, size);
+    memcpy(b, buf, size);
+    memcpy(&h, b, sizeof(h));
+
+    if (c == CORRUPT_AXIS){
+        u32 = h.dim;
+        memcpy(b + h.axis_off + sizeof(uint32_t) * (h.len / 2), &u32, 4);
+    }else if (c == CORRUPT_ADJ_PTR_DEC){
+        u64 = 0;
+        memcpy(b + h.adj_ptr_off + sizeof(uint64_t) * (h.len / 2), &u64, 8);
+    }else if (c == CORRUPT_ADJ_PTR_END){
+        u64 = 2 * h.edges_len + 2;
+        memcpy(b + h.adj_ptr_off + sizeof(uint64_t) * h.len, &u64, 8);
+    }else if (c == CORRUPT_ADJ){
+        u32 = h.len;
+        memcpy(b + h.adj_off, &u32, 4);
+    }else if (c == CORRUPT_EMPTY){
+        h.len = 0;
+        memcpy(b, &h, sizeof(h));
+    }
+
+    ret = -1;
+    fout = fopen(fn, "wb");
+    if (fout){
+        ret = (fwrite(b, 1, size, fout) == size ? 0 : -1);
+        if (fclose(fout) != 0)
+            ret = -1;
+    }
+    BOR_FREE(b);
+    return ret;
+}
+
+/** Checks that svoModelOpen() refuses corrupted model files */
+static int checkCorrupted(void)
+{
+    const size_t len = 100;
+    const int dim = 2;
+    bor_real_t ws[100 * 2];
+    const bor_real_t *w[100];
+    uint32_t edges[2 * 99];
+    char *buf;
+    size_t i, size;
+    svo_model_t m;
+    FILE *fin;
+    int c, opened, ret;
+
+    for (i = 0; i < len; i++){
+        ws[i * dim]     = svoRngUniform(&rng);
+        ws[i * dim + 1] = svoRngUniform(&rng);
+        w[i] = ws + i * dim;
+    }
+    for (i = 0; i < len - 1; i++){
+        edges[2 * i]     = i;
+        edges[2 * i + 1] = i + 1;
+    }
+    if (svoModelWrite(fn, dim, len, w, len - 1, edges, NULL) != 0)
+        return -1;
+
+    buf = NULL;
+    size = 0;
+    fin = fopen(fn, "rb");
+    if (fin){
+        fseek(fin, 0, SEEK_END);
+        size = ftell(fin);
+        fseek(fin, 0, SEEK_SET);
+        buf = BOR_ALLOC_ARR(char, size);
+        if (fread(buf, 1, size, fin) != size)
+            size = 0;
+        fclose(fin);
+    }
+    if (size == 0){
+        if (buf)
+            BOR_FREE(buf);
+        return -1;
+    }
+
+    ret = 0;
+    for (c = CORRUPT_NONE; c < CORRUPT_LEN; c++){
+        opened = 0;
+        if (corrupt(buf, size, c) == 0 && svoModelOpen(&m, fn) == 0){
+            opened = 1;
+            svoModelClose(&m);
+        }
+
+        // only the intact file may be opened
+        if (opened != (c == CORRUPT_NONE))
+            ret = -1;
+        printf("corrupted %-18s: %s\n", corrupt_names[c],
+               (opened != (c == CORRUPT_NONE) ? "FAIL" : "ok"));
+    }
+
+    BOR_FREE(buf);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t di, li;
+    int ret;
+
+    if (argc == 3 && strcmp(argv[1], "-o") == 0){
+        fn = argv[2];
+    }else if (argc != 1){
+        fprintf(stderr, "Usage: %s [-o model-file]\n", argv[0]);
+        return -1;
+    }
+
+    svoRngInit(&rng, 1);
+
+    ret = 0;
+    for (di = 0; di < DIMS_LEN; di++){
+        for (li = 0; li < LENS_LEN; li++){
+            if (check(dims[di], lens[li]) != 0)
+                ret = -1;
+        }
+    }
+    if (checkCorrupted() != 0)
+        ret = -1;
+    unlink(fn);
+
+    printf("%s\n", (ret == 0 ? "OK" : "FAILED"));
+    return (ret == 0 ? 0 : 1);
+}
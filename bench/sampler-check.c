@@ -0,0 +1,190 @@
+/**
+ * Checks pseudo-random permutation and input signal sampler
+ * (gng/sampler.h) which snapshots of GNG-Eu, GSRM and GNG-T rely on.
+ *
+ * It is checked that:
+ *   - svoPermGet() is a bijection of [0, n) for several seeds and for n
+ *     equal to 1, 2, powers of two and their neighbors (so that both even
+ *     and odd numbers of bits are covered) up to 2^20 + 1,
+ *   - each epoch of svoSamplerNext() draws every signal exactly once,
+ *   - svoSamplerTell() returns number of signals drawn so far and a
+ *     sampler set by svoSamplerSeek() to that number continues with the
+ *     same signals as the original sampler, for positions around epoch
+ *     boundaries and for samplers with fewer signals than
+ *     SVO_SAMPLER_AHEAD.
+ * Prints one line per checked property and exits with non-zero status if
+ * any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boruvka/alloc.h>
+#include "gng/sampler.h"
+
+/** Largest exponent of checked sizes of permutation */
+#define PERM_MAX_BITS 20
+/** Number of epochs drawn by checks of sampler */
+#define EPOCHS 4
+
+static const uint64_t seeds[] = { 0, 1, 0xDEADBEEF, UINT64_MAX };
+#define SEEDS_LEN (sizeof(seeds) / sizeof(seeds[0]))
+
+static const size_t sampler_lens[] = { 1, 2, 3, SVO_SAMPLER_AHEAD - 1,
+                                       SVO_SAMPLER_AHEAD,
+                                       SVO_SAMPLER_AHEAD + 1, 100, 1000 };
+#define SAMPLER_LENS_LEN (sizeof(sampler_lens) / sizeof(sampler_lens[0]))
+
+/** Returns true if permutation of [0, n) given by {seed} is bijection */
+static int checkPerm(uint64_t n, uint64_t seed, char *seen)
+{
+    svo_perm_t p;
+    uint64_t i, j;
+
+    svoPermInit(&p, n, seed);
+    memset(seen, 0, n);
+    for (i = 0; i < n; i++){
+        j = svoPermGet(&p, i);
+        if (j >= n || seen[j])
+            return 0;
+        seen[j] = 1;
+    }
+    return 1;
+}
+
+static int checkPerms(void)
+{
+    char *seen;
+    uint64_t n, d;
+    size_t si;
+    int bits, ok, checked;
+
+    seen = BOR_ALLOC_ARR(char, (UINT64_C(1) << PERM_MAX_BITS) + 1);
+
+    ok = 1;
+    checked = 0;
+    for (si = 0; si < SEEDS_LEN; si++){
+        ok &= checkPerm(1, seeds[si], seen);
+        ++checked;
+        for (bits = 1; bits <= PERM_MAX_BITS; bits++){
+            for (d = 0; d < 3; d++){
+                // 2^bits - 1, 2^bits, 2^bits + 1
+                n = (UINT64_C(1) << bits) - 1 + d;
+                if (n < 2)
+                    continue;
+                ok &= checkPerm(n, seeds[si], seen);
+                ++checked;
+            }
+        }
+    }
+
+    printf("permutation is bijection (%d sizes and seeds): %s\n",
+           checked, (ok ? "ok" : "FAIL"));
+
+    BOR_FREE(seen);
+    return ok;
+}
+
+/** Returns index of signal {v} in {arr} */
+static size_t signalId(const bor_real_t *arr, const bor_vec_t *v)
+{
+    return (const bor_real_t *)v - arr;
+}
+
+/** Checks sampler over {len} signals, failed checks are recorded by
+ *  zeroing {epochs_ok} or {seek_ok} */
+static void checkSampler(size_t len, uint64_t seed, int *epochs_ok,
+                         int *seek_ok)
+{
+    bor_real_t *arr;
+    size_t *ref, ref_len, i, j, e;
+    char *seen;
+    svo_sampler_t a, b;
+    uint64_t t;
+
+    // dimension 1 is enough, signals are identified by their address
+    arr = BOR_ALLOC_ARR(bor_real_t, len);
+    for (i = 0; i < len; i++)
+        arr[i] = i;
+
+    // reference stream
+    ref_len = EPOCHS * len;
+    ref = BOR_ALLOC_ARR(size_t, ref_len);
+    svoSamplerInitArr(&a, arr, len, 1, seed);
+    for (i = 0; i < ref_len; i++)
+        ref[i] = signalId(arr, svoSamplerNext(&a));
+    svoSamplerFree(&a);
+
+    // each epoch is permutation of all signals
+    seen = BOR_ALLOC_ARR(char, len);
+    for (e = 0; e < EPOCHS; e++){
+        memset(seen, 0, len);
+        for (i = e * len; i < (e + 1) * len; i++){
+            if (ref[i] >= len || seen[ref[i]])
+                *epochs_ok = 0;
+            else
+                seen[ref[i]] = 1;
+        }
+    }
+    BOR_FREE(seen);
+
+    // Seek(Tell()) after any number of drawn signals of the first
+    // EPOCHS - 1 epochs continues the stream
+    for (t = 0; t < (EPOCHS - 1) * len; t++){
+        svoSamplerInitArr(&a, arr, len, 1, seed);
+        for (i = 0; i < t; i++)
+            svoSamplerNext(&a);
+        if (svoSamplerTell(&a) != t)
+            *seek_ok = 0;
+
+        // second sampler is seeked from different state
+        svoSamplerInitArr(&b, arr, len, 1, seed);
+        for (i = 0; i < len / 2 + 3; i++)
+            svoSamplerNext(&b);
+        svoSamplerSeek(&b, svoSamplerTell(&a));
+
+        for (j = t; j < ref_len; j++){
+            if (signalId(arr, svoSamplerNext(&a)) != ref[j]
+                    || signalId(arr, svoSamplerNext(&b)) != ref[j]){
+                *seek_ok = 0;
+                break;
+            }
+        }
+
+        svoSamplerFree(&a);
+        svoSamplerFree(&b);
+    }
+
+    BOR_FREE(arr);
+    BOR_FREE(ref);
+}
+
+static int checkSamplers(void)
+{
+    size_t li, si;
+    int epochs_ok, seek_ok, ok;
+
+    ok = 1;
+    for (li = 0; li < SAMPLER_LENS_LEN; li++){
+        epochs_ok = seek_ok = 1;
+        for (si = 0; si < SEEDS_LEN; si++)
+            checkSampler(sampler_lens[li], seeds[si], &epochs_ok, &seek_ok);
+
+        printf("sampler len %4lu: epochs %s, seek(tell) %s\n",
+               (unsigned long)sampler_lens[li],
+               (epochs_ok ? "ok" : "FAIL"), (seek_ok ? "ok" : "FAIL"));
+        ok &= epochs_ok && seek_ok;
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    int ok;
+
+    ok = checkPerms();
+    ok &= checkSamplers();
+
+    printf("%s\n", (ok ? "OK" : "FAILED"));
+    return (ok ? 0 : 1);
+}
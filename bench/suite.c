@@ -0,0 +1,686 @@
+/**
+ * Runs GNG-Eu, GNG, GNG-T and GSRM on synthetic input signals across
+ * distributions, dimensions, numbers of nodes and nearest neighbor search
+ * structures (GUG, VP-tree, linear).
+ *
+ * Input signals are drawn from deterministic generators (seeded by -s,
+ * default 1), so two runs of the same binary learn from the same data:
+ *   - cube:   uniform distribution in unit hypercube (any dim),
+ *   - gauss:  mixture of 8 Gaussians with centers in unit hypercube
+ *             (any dim),
+ *   - sphere: uniform distribution on unit hypersphere (dim >= 2),
+ *   - torus:  surface of torus with radii 1 and 0.3 (dim = 3),
+ *   - rings:  three concentric rings in plane (dim = 2).
+ *
+ * Each configuration is learned in its own forked process, so peak
+ * resident set size (ru_maxrss) belongs to that configuration only.
+ * Learning stops when net reaches given number of nodes (GNG-T is given
+ * zero target error, so it grows by one node per cycle as others do).
+ * Results are printed to stdout as CSV, one row per configuration.
+ *
+ * Variants gng-inline and gng-t-inline run GNG and GNG-T with learning
+ * loop expanded by SVO_GNG_DEFINE() and SVO_GNGT_DEFINE() (see
+ * gng/gng-algorithm.h). They consume the same input signals in the same
+ * order, so for the same seed they end with the same numbers of nodes and
+ * edges as gng and gng-t.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <boruvka/alloc.h>
+#include <boruvka/nn.h>
+#include "gng/gng-eu.h"
+#include "gng/gng.h"
+#include "gng/gng-t.h"
+#include "gng/gng-algorithm.h"
+#include "gng/gsrm.h"
+#include "gng/rng.h"
+
+/** Number of generated input signals */
+#define PTS_LEN 100000
+#define MAX_DIM 64
+
+struct _node_t {
+    svo_gng_node_t gng;
+    svo_gngt_node_t gngt;
+    bor_nn_el_t nn;
+    bor_vec_t *w;
+};
+typedef struct _node_t node_t;
+
+struct _conf_t {
+    const char *alg;
+    const char *dist;
+    int dim;
+    int nn;
+    size_t nodes;
+};
+typedef struct _conf_t conf_t;
+
+static const char *algs[] = { "gng-eu", "gng", "gng-inline",
+                               "gng-t", "gng-t-inline", "gsrm" };
+#define ALGS_LEN (sizeof(algs) / sizeof(algs[0]))
+
+static const char *dists[] = { "cube", "gauss", "sphere", "torus", "rings" };
+#define DISTS_LEN (sizeof(dists) / sizeof(dists[0]))
+
+static const int nns[] = { BOR_NN_GUG, BOR_NN_VPTREE, BOR_NN_LINEAR };
+#define NNS_LEN (sizeof(nns) / sizeof(nns[0]))
+
+static const int dims[] = { 2, 3, 8 };
+#define DIMS_LEN (sizeof(dims) / sizeof(dims[0]))
+
+static const size_t nodes_def[] = { 1000, 5000 };
+#define NODES_LEN (sizeof(nodes_def) / sizeof(nodes_def[0]))
+
+/** State of currently running configuration */
+static conf_t conf;
+static bor_real_t *pts;
+static bor_real_t aabb[2 * MAX_DIM];
+static bor_nn_t *nn;
+static bor_vec_t *tmpv;
+static uint64_t seed = 1;
+static svo_rng_t rng;
+static unsigned long cycles;
+static void *alg;
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
+
+static double rnd(void)
+{
+    return svoRngUniform(&rng);
+}
+
+/** Standard normal distribution (Box-Muller) */
+static double rndNormal(void)
+{
+    double u1, u2;
+
+    do {
+        u1 = rnd();
+    } while (u1 <= 0.);
+    u2 = rnd();
+    return sqrt(-2. * log(u1)) * cos(2. * M_PI * u2);
+}
+
+static int distValid(const char *dist, int dim)
+{
+    if (strcmp(dist, "sphere") == 0)
+        return dim >= 2;
+    if (strcmp(dist, "torus") == 0)
+        return dim == 3;
+    if (strcmp(dist, "rings") == 0)
+        return dim == 2;
+    return 1;
+}
+
+static void genPoint(const char *dist, int dim, const double *centers,
+                     bor_real_t *p)
+{
+    double len, u, v, r;
+    int i, c;
+
+    if (strcmp(dist, "cube") == 0){
+        for (i = 0; i < dim; i++)
+            p[i] = rnd();
+
+    }else if (strcmp(dist, "gauss") == 0){
+        c = svoRngRange(&rng, 8);
+        for (i = 0; i < dim; i++)
+            p[i] = centers[c * dim + i] + 0.05 * rndNormal();
+
+    }else if (strcmp(dist, "sphere") == 0){
+        do {
+            len = 0.;
+            for (i = 0; i < dim; i++){
+                p[i] = rndNormal();
+                len += p[i] * p[i];
+            }
+        } while (len < 1E-12);
+        len = sqrt(len);
+        for (i = 0; i < dim; i++)
+            p[i] /= len;
+
+    }else if (strcmp(dist, "torus") == 0){
+        // rejection sampling makes points uniform on surface
+        do {
+            u = 2. * M_PI * rnd();
+            v = 2. * M_PI * rnd();
+        } while (rnd() * 1.3 > 1. + 0.3 * cos(v));
+        p[0] = (1. + 0.3 * cos(v)) * cos(u);
+        p[1] = (1. + 0.3 * cos(v)) * sin(u);
+        p[2] = 0.3 * sin(v);
+
+    }else{ // rings
+        r = 0.3 * (1 + svoRngRange(&rng, 3)) + 0.01 * rndNormal();
+        u = 2. * M_PI * rnd();
+        p[0] = r * cos(u);
+        p[1] = r * sin(u);
+    }
+}
+
+static void genPoints(const char *dist, int dim)
+{
+    double centers[8 * MAX_DIM];
+    bor_real_t *p;
+    size_t i;
+    int j;
+
+    svoRngInit(&rng, seed);
+    for (i = 0; i < 8 * (size_t)dim; i++)
+        centers[i] = rnd();
+
+    pts = BOR_ALLOC_ARR(bor_real_t, PTS_LEN * dim);
+    for (j = 0; j < dim; j++){
+        aabb[2 * j]     = BOR_REAL_MAX;
+        aabb[2 * j + 1] = -BOR_REAL_MAX;
+    }
+
+    for (i = 0; i < PTS_LEN; i++){
+        p = pts + i * dim;
+        genPoint(dist, dim, centers, p);
+        for (j = 0; j < dim; j++){
+            aabb[2 * j]     = BOR_MIN(aabb[2 * j], p[j]);
+            aabb[2 * j + 1] = BOR_MAX(aabb[2 * j + 1], p[j]);
+        }
+    }
+}
+
+static const char *nnName(int type)
+{
+    if (type == BOR_NN_VPTREE)
+        return "vptree";
+    if (type == BOR_NN_LINEAR)
+        return "linear";
+    return "gug";
+}
+
+static void nnParams(bor_nn_params_t *p, int type, int dim)
+{
+    borNNParamsInit(p);
+    p->type = type;
+    p->gug.dim = dim;
+    p->gug.num_cells = 0;
+    p->gug.max_dens = 0.1;
+    p->gug.expand_rate = 1.5;
+    p->gug.aabb = aabb;
+    p->vptree.dim = dim;
+    p->linear.dim = dim;
+}
+
+
+/** Callbacks shared by GNG and GNG-T, nodes live in {nn} */
+static const void *inputSignal(void *data)
+{
+    return (const void *)(pts + svoRngRange(&rng, PTS_LEN) * conf.dim);
+}
+
+static node_t *nodeNew(const bor_vec_t *is)
+{
+    node_t *n;
+
+    n = BOR_ALLOC(node_t);
+    n->w = borVecNew(conf.dim);
+    borVecCopy(conf.dim, n->w, is);
+    borNNElInit(nn, &n->nn, n->w);
+    borNNAdd(nn, &n->nn);
+    return n;
+}
+
+static void nodeDel(node_t *n)
+{
+    borNNRemove(nn, &n->nn);
+    borVecDel(n->w);
+    BOR_FREE(n);
+}
+
+static void nodeBetween(const node_t *n1, const node_t *n2)
+{
+    borVecAdd2(conf.dim, tmpv, n1->w, n2->w);
+    borVecScale(conf.dim, tmpv, BOR_REAL(0.5));
+}
+
+static void nodeNearest(const void *is, node_t **n1, node_t **n2)
+{
+    bor_nn_el_t *els[2];
+
+    borNNNearest(nn, (const bor_vec_t *)is, 2, els);
+    *n1 = bor_container_of(els[0], node_t, nn);
+    *n2 = bor_container_of(els[1], node_t, nn);
+}
+
+static void nodeMove(node_t *n, const void *is, bor_real_t fraction)
+{
+    borVecSub2(conf.dim, tmpv, (const bor_vec_t *)is, n->w);
+    borVecScale(conf.dim, tmpv, fraction);
+    borVecAdd(conf.dim, n->w, tmpv);
+    borNNUpdate(nn, &n->nn);
+}
+
+/** Same callbacks with node_t for SVO_GNG_DEFINE and SVO_GNGT_DEFINE */
+static void inlNearest(const void *is, node_t **n1, node_t **n2, void *data)
+{
+    nodeNearest(is, n1, n2);
+}
+
+static bor_real_t inlDist2(const void *is, const node_t *n, void *data)
+{
+    return borVecDist2(conf.dim, (const bor_vec_t *)is, n->w);
+}
+
+static void inlMoveTowards(node_t *n, const void *is, bor_real_t fraction,
+                           void *data)
+{
+    nodeMove(n, is, fraction);
+}
+
+SVO_GNG_DEFINE(gngInline, node_t, gng,
+               inputSignal, inlNearest, inlDist2, inlMoveTowards)
+SVO_GNGT_DEFINE(gngtInline, node_t, gngt,
+                inputSignal, inlNearest, inlDist2, inlMoveTowards)
+
+
+/** GNG-Eu */
+static int euTerminate(void *data)
+{
+    ++cycles;
+    return svoGNGEuNodesLen((svo_gng_eu_t *)alg) >= conf.nodes;
+}
+
+static size_t runGNGEu(size_t *lambda, size_t *edges)
+{
+    svo_gng_eu_params_t params;
+    svo_gng_eu_ops_t ops;
+    svo_gng_eu_t *gng;
+    size_t len;
+
+    svoGNGEuParamsInit(&params);
+    params.dim = conf.dim;
+    params.seed = seed;
+    nnParams(&params.nn, conf.nn, conf.dim);
+
+    svoGNGEuOpsInit(&ops);
+    ops.terminate = euTerminate;
+
+    gng = svoGNGEuNew(&ops, &params);
+    alg = gng;
+    svoGNGEuInputSignalsArr(gng, pts, PTS_LEN);
+    svoGNGEuRun(gng);
+
+    *lambda = params.lambda;
+    len = svoGNGEuNodesLen(gng);
+    *edges = svoGNGEuEdgesLen(gng);
+    svoGNGEuDel(gng);
+    return len;
+}
+
+
+/** GNG */
+#define GNG_NODE(n) bor_container_of((n), node_t, gng)
+
+static svo_gng_node_t *gngNewNode(const void *is, void *data)
+{
+    return &nodeNew((const bor_vec_t *)is)->gng;
+}
+
+static svo_gng_node_t *gngNewNodeBetween(const svo_gng_node_t *n1,
+                                         const svo_gng_node_t *n2, void *data)
+{
+    nodeBetween(GNG_NODE(n1), GNG_NODE(n2));
+    return gngNewNode(tmpv, data);
+}
+
+static void gngDelNode(svo_gng_node_t *n, void *data)
+{
+    nodeDel(GNG_NODE(n));
+}
+
+static void gngNearest(const void *is, svo_gng_node_t **n1,
+                       svo_gng_node_t **n2, void *data)
+{
+    node_t *m1, *m2;
+
+    nodeNearest(is, &m1, &m2);
+    *n1 = &m1->gng;
+    *n2 = &m2->gng;
+}
+
+static bor_real_t gngDist2(const void *is, const svo_gng_node_t *n,
+                           void *data)
+{
+    return borVecDist2(conf.dim, (const bor_vec_t *)is, GNG_NODE(n)->w);
+}
+
+static void gngMoveTowards(svo_gng_node_t *n, const void *is,
+                           bor_real_t fraction, void *data)
+{
+    nodeMove(GNG_NODE(n), is, fraction);
+}
+
+static int gngTerminate(void *data)
+{
+    ++cycles;
+    return svoGNGNodesLen((svo_gng_t *)alg) >= conf.nodes;
+}
+
+static size_t runGNG(int inl, size_t *lambda, size_t *edges)
+{
+    svo_gng_params_t params;
+    svo_gng_ops_t ops;
+    svo_gng_t *gng;
+    size_t len;
+
+    svoGNGParamsInit(&params);
+
+    svoGNGOpsInit(&ops);
+    ops.new_node         = gngNewNode;
+    ops.new_node_between = gngNewNodeBetween;
+    ops.del_node         = gngDelNode;
+    ops.input_signal     = inputSignal;
+    ops.nearest          = gngNearest;
+    ops.dist2            = gngDist2;
+    ops.move_towards     = gngMoveTowards;
+    ops.terminate        = gngTerminate;
+
+    gng = svoGNGNew(&ops, &params);
+    alg = gng;
+    if (inl){
+        gngInlineRun(gng);
+    }else{
+        svoGNGRun(gng);
+    }
+
+    *lambda = params.lambda;
+    len = svoGNGNodesLen(gng);
+    *edges = svoGNGEdgesLen(gng);
+    svoGNGDel(gng);
+    return len;
+}
+
+
+/** GNG-T */
+#define GNGT_NODE(n) bor_container_of((n), node_t, gngt)
+
+static svo_gngt_node_t *gngtNewNode(const void *is, void *data)
+{
+    return &nodeNew((const bor_vec_t *)is)->gngt;
+}
+
+static svo_gngt_node_t *gngtNewNodeBetween(const svo_gngt_node_t *n1,
+                                           const svo_gngt_node_t *n2,
+                                           void *data)
+{
+    nodeBetween(GNGT_NODE(n1), GNGT_NODE(n2));
+    return gngtNewNode(tmpv, data);
+}
+
+static void gngtDelNode(svo_gngt_node_t *n, void *data)
+{
+    nodeDel(GNGT_NODE(n));
+}
+
+static void gngtNearest(const void *is, svo_gngt_node_t **n1,
+                        svo_gngt_node_t **n2, void *data)
+{
+    node_t *m1, *m2;
+
+    nodeNearest(is, &m1, &m2);
+    *n1 = &m1->gngt;
+    *n2 = &m2->gngt;
+}
+
+static bor_real_t gngtDist2(const void *is, const svo_gngt_node_t *n,
+                            void *data)
+{
+    return borVecDist2(conf.dim, (const bor_vec_t *)is, GNGT_NODE(n)->w);
+}
+
+static void gngtMoveTowards(svo_gngt_node_t *n, const void *is,
+                            bor_real_t fraction, void *data)
+{
+    nodeMove(GNGT_NODE(n), is, fraction);
+}
+
+static int gngtTerminate(void *data)
+{
+    ++cycles;
+    return svoGNGTNodesLen((svo_gngt_t *)alg) >= conf.nodes;
+}
+
+static size_t runGNGT(int inl, size_t *lambda, size_t *edges)
+{
+    svo_gngt_params_t params;
+    svo_gngt_ops_t ops;
+    svo_gngt_t *gng;
+    size_t len;
+
+    svoGNGTParamsInit(&params);
+    params.target = BOR_ZERO;
+
+    svoGNGTOpsInit(&ops);
+    ops.new_node         = gngtNewNode;
+    ops.new_node_between = gngtNewNodeBetween;
+    ops.del_node         = gngtDelNode;
+    ops.input_signal     = inputSignal;
+    ops.nearest          = gngtNearest;
+    ops.dist2            = gngtDist2;
+    ops.move_towards     = gngtMoveTowards;
+    ops.terminate        = gngtTerminate;
+
+    gng = svoGNGTNew(&ops, &params);
+    alg = gng;
+    if (inl){
+        gngtInlineRun(gng);
+    }else{
+        svoGNGTRun(gng);
+    }
+
+    *lambda = params.lambda;
+    len = svoGNGTNodesLen(gng);
+    *edges = svoGNGTEdgesLen(gng);
+    svoGNGTDel(gng);
+    return len;
+}
+
+
+/** GSRM */
+static size_t runGSRM(size_t *lambda, size_t *edges)
+{
+    svo_gsrm_params_t params;
+    svo_gsrm_t *gsrm;
+    size_t i, len;
+
+    svoGSRMParamsInit(&params);
+    params.seed = seed;
+    params.verbosity = 0;
+    params.max_nodes = conf.nodes;
+    params.nn.type   = conf.nn;
+
+    gsrm = svoGSRMNew(&params);
+    for (i = 0; i < PTS_LEN; i++)
+        borPCAdd(gsrm->is, (const bor_vec_t *)(pts + 3 * i));
+
+    len = *edges = 0;
+    if (svoGSRMRun(gsrm) == 0){
+        cycles = gsrm->cycle - 1;
+        len = borMesh3VerticesLen(svoGSRMMesh(gsrm));
+        *edges = borMesh3EdgesLen(svoGSRMMesh(gsrm));
+    }
+
+    *lambda = params.lambda;
+    svoGSRMDel(gsrm);
+    return len;
+}
+
+
+static void run(void)
+{
+    struct rusage usage;
+    bor_nn_params_t nnp;
+    size_t len, edges, lambda;
+    double start, elapsed, signals;
+
+    genPoints(conf.dist, conf.dim);
+    nn = NULL;
+    tmpv = borVecNew(conf.dim);
+    cycles = 0;
+
+    start = now();
+    if (strcmp(conf.alg, "gng-eu") == 0){
+        len = runGNGEu(&lambda, &edges);
+    }else if (strcmp(conf.alg, "gsrm") == 0){
+        len = runGSRM(&lambda, &edges);
+    }else{
+        // GNG and GNG-T keep nodes in NN structure of the benchmark
+        nnParams(&nnp, conf.nn, conf.dim);
+        nn = borNNNew(&nnp);
+
+        if (strcmp(conf.alg, "gng") == 0){
+            len = runGNG(0, &lambda, &edges);
+        }else if (strcmp(conf.alg, "gng-inline") == 0){
+            len = runGNG(1, &lambda, &edges);
+        }else if (strcmp(conf.alg, "gng-t") == 0){
+            len = runGNGT(0, &lambda, &edges);
+        }else{
+            len = runGNGT(1, &lambda, &edges);
+        }
+        borNNDel(nn);
+    }
+    elapsed = now() - start;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    // each cycle consists of {lambda} input signals followed by node
+    // insertion
+    signals = (double)cycles * (double)lambda;
+    printf("%s,%s,%d,%s,%d,%d,%.0f,%f,%f,%f,%ld\n",
+           conf.alg, conf.dist, conf.dim, nnName(conf.nn), (int)len,
+           (int)edges, signals, elapsed, signals / elapsed, (double)len / elapsed,
+           (long)usage.ru_maxrss);
+
+    borVecDel(tmpv);
+    BOR_FREE(pts);
+}
+
+static void runForked(void)
+{
+    pid_t pid;
+    int status;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0){
+        perror("fork");
+        exit(-1);
+    }
+
+    if (pid == 0){
+        run();
+        fflush(stdout);
+        _exit(0);
+    }
+
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)
+            || WEXITSTATUS(status) != 0){
+        fprintf(stderr, "Error: %s/%s/%d/%s/%d failed\n",
+                conf.alg, conf.dist, conf.dim, nnName(conf.nn),
+                (int)conf.nodes);
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-a alg] [-d dist] [-D dim] [-n nn]"
+                    " [-N nodes] [-s seed]\n", prog);
+    fprintf(stderr, "  Each option restricts the matrix of configurations"
+                    " to one value:\n");
+    fprintf(stderr, "    alg:  gng-eu, gng, gng-inline, gng-t, gng-t-inline,"
+                    " gsrm\n");
+    fprintf(stderr, "    dist: cube, gauss, sphere, torus, rings\n");
+    fprintf(stderr, "    dim:  1 .. %d (default 2, 3 and 8)\n", MAX_DIM);
+    fprintf(stderr, "    nn:   gug, vptree, linear\n");
+    fprintf(stderr, "    nodes: number of nodes (default 1000 and 5000)\n");
+    fprintf(stderr, "  -s seed: seed of input signals and of learning"
+                    " (default 1)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *only_alg = NULL, *only_dist = NULL, *only_nn = NULL;
+    int only_dim = 0;
+    size_t only_nodes = 0;
+    size_t ai, di, ni, ddi, nni;
+    int c;
+
+    while ((c = getopt(argc, argv, "a:d:D:n:N:s:h")) != -1){
+        switch (c){
+            case 'a': only_alg = optarg; break;
+            case 'd': only_dist = optarg; break;
+            case 'D': only_dim = atoi(optarg); break;
+            case 'n': only_nn = optarg; break;
+            case 'N': only_nodes = atol(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                usage(argv[0]);
+                return -1;
+        }
+    }
+    if (optind != argc || only_dim < 0 || only_dim > MAX_DIM){
+        usage(argv[0]);
+        return -1;
+    }
+
+    printf("alg,dist,dim,nn,nodes,edges,signals,time_s,signals_per_s,"
+           "nodes_per_s,peak_rss_kb\n");
+
+    for (ai = 0; ai < ALGS_LEN; ai++){
+        if (only_alg && strcmp(only_alg, algs[ai]) != 0)
+            continue;
+
+        for (di = 0; di < DISTS_LEN; di++){
+            if (only_dist && strcmp(only_dist, dists[di]) != 0)
+                continue;
+
+            for (ddi = 0; ddi < (only_dim ? 1 : DIMS_LEN); ddi++){
+                conf.dim = (only_dim ? only_dim : dims[ddi]);
+                if (!distValid(dists[di], conf.dim))
+                    continue;
+                // GSRM reconstructs surfaces in 3-D
+                if (strcmp(algs[ai], "gsrm") == 0
+                        && (conf.dim != 3
+                                || (strcmp(dists[di], "sphere") != 0
+                                        && strcmp(dists[di], "torus") != 0)))
+                    continue;
+
+                for (ni = 0; ni < NNS_LEN; ni++){
+                    if (only_nn && strcmp(only_nn, nnName(nns[ni])) != 0)
+                        continue;
+
+                    for (nni = 0; nni < (only_nodes ? 1 : NODES_LEN); nni++){
+                        conf.alg   = algs[ai];
+                        conf.dist  = dists[di];
+                        conf.nn    = nns[ni];
+                        conf.nodes = (only_nodes ? only_nodes
+                                                 : nodes_def[nni]);
+                        runForked();
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -1,35 +1,52 @@
 #include <stdio.h>
+#include <string.h>
 #include <boruvka/dbg.h>
 #include <boruvka/timer.h>
 #include "gng/gng-eu.h"
+#include "gng/gng-eu-shard.h"
+#include "gng/pts.h"
 
 size_t max_nodes;
 svo_gng_eu_t *gng;
 bor_timer_t timer;
 bor_pc_t *pc;
-bor_pc_it_t pcit;
+svo_pts_t pts;
 
 static int terminate(void *data);
 static void callback(void *data);
-static const bor_vec_t *input_signal(void *data);
 
 int main(int argc, char *argv[])
 {
     svo_gng_eu_params_t params;
+    svo_gng_eu_shard_params_t shard_params;
     svo_gng_eu_ops_t ops;
     size_t size;
     bor_real_t aabb[30];
+    int num_shards;
+    unsigned long seed = 0L;
+    char *prog = argv[0];
+
+    if (argc > 2 && strcmp(argv[1], "--seed") == 0){
+        seed = strtoul(argv[2], NULL, 10);
+        argc -= 2;
+        argv += 2;
+        argv[0] = prog;
+    }
 
     if (argc < 4){
-        fprintf(stderr, "Usage: %s dim file.pts max_nodes\n", argv[0]);
+        fprintf(stderr, "Usage: %s [--seed int] dim file.pts max_nodes [num_shards [model]]\n", argv[0]);
         return -1;
     }
 
     max_nodes = atoi(argv[3]);
+    num_shards = 1;
+    if (argc >= 5)
+        num_shards = atoi(argv[4]);
 
 
     svoGNGEuParamsInit(&params);
     params.dim = atoi(argv[1]);
+    params.seed = seed;
     params.nn.type = BOR_NN_GUG;
     params.nn.type = BOR_NN_VPTREE;
     params.nn.gug.num_cells = 0;
@@ -38,31 +55,50 @@ int main(int argc, char *argv[])
 
     svoGNGEuOpsInit(&ops);
     ops.terminate = terminate;
-    ops.input_signal = input_signal;
     ops.callback  = callback;
     ops.callback_period = 300;
     ops.data = NULL;
 
     pc = borPCNew(params.dim);
-    size = borPCAddFromFile(pc, argv[2]);
-    borPCAABB(pc, aabb);
+    if (svoPtsLoad(&pts, argv[2], params.dim, 0) != 0)
+        return -1;
+    size = pts.len;
+    svoPtsAABB(&pts, aabb);
+
+    // sharding needs point cloud
+    if (num_shards > 1){
+        svoPtsAddToPC(&pts, pc);
+        svoPtsClose(&pts);
+    }
     params.nn.gug.aabb = aabb;
     fprintf(stderr, "Added %d points from %s\n", (int)size, argv[2]);
 
-    borPCPermutate(pc);
-    borPCItInit(&pcit, pc);
-
-    gng = svoGNGEuNew(&ops, &params);
-
     borTimerStart(&timer);
-    svoGNGEuRun(gng);
+    if (num_shards > 1){
+        svoGNGEuShardParamsInit(&shard_params);
+        shard_params.gng = params;
+        shard_params.gng.num_threads = num_shards;
+        shard_params.num_shards = num_shards;
+        shard_params.max_nodes  = max_nodes;
+        gng = svoGNGEuShardTrain(&shard_params, NULL, pc);
+    }else{
+        gng = svoGNGEuNew(&ops, &params);
+        svoGNGEuInputSignalsArr(gng, pts.data, pts.len);
+        svoGNGEuRun(gng);
+    }
     callback(NULL);
     fprintf(stderr, "\n");
+#ifdef SVO_STATS
+    svoStatsPrint(svoGNGEuStats(gng), stderr);
+#endif /* SVO_STATS */
 
     svoGNGEuDumpSVT(gng, stdout, NULL);
+    if (argc >= 6 && svoGNGEuExportModel(gng, argv[5]) == 0)
+        fprintf(stderr, "Model written to %s\n", argv[5]);
 
     svoGNGEuDel(gng);
 
+    svoPtsClose(&pts);
     borPCDel(pc);
 
     return 0;
@@ -82,16 +118,3 @@ static void callback(void *data)
 
     borTimerStopAndPrintElapsed(&timer, stderr, " n: %d / %d\r", nodes_len, max_nodes);
 }
-
-static const bor_vec_t *input_signal(void *data)
-{
-    const bor_vec_t *v;
-
-    if (borPCItEnd(&pcit)){
-        borPCPermutate(pc);
-        borPCItInit(&pcit, pc);
-    }
-    v = borPCItGet(&pcit);
-    borPCItNext(&pcit);
-    return v;
-}
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 #include <signal.h>
 #include <boruvka/dbg.h>
 #include <boruvka/timer.h>
@@ -7,6 +8,8 @@
 #include <boruvka/alloc.h>
 #include <boruvka/vec3.h>
 #include "gng/gng-t.h"
+#include "gng/sampler.h"
+#include "gng/pts.h"
 
 struct _node_t {
     svo_gngt_node_t node;
@@ -32,8 +35,8 @@ bor_gug_t *gug;
 
 bor_timer_t timer;
 
-bor_pc_t *pc;
-bor_pc_it_t pcit;
+svo_pts_t pts;
+svo_sampler_t sampler;
 
 static int terminate(void *data);
 static void callback(void *data);
@@ -51,6 +54,10 @@ static void move_towards(svo_gngt_node_t *node,
                          const void *input_signal,
                          bor_real_t fraction, void *);
 static void dumpSVT(svo_gngt_t *gng, FILE *out, const char *name);
+static int saveNode(const svo_gngt_node_t *n, FILE *fout, void *);
+static svo_gngt_node_t *loadNode(FILE *fin, void *);
+static int save(const char *fn);
+static int load(const char *fn);
 
 static void sigDump(int sig);
 
@@ -58,9 +65,18 @@ int main(int argc, char *argv[])
 {
     size_t size;
     bor_real_t aabb[30];
+    char *prog = argv[0];
+
+    svoGNGTParamsInit(&params);
+    if (argc > 2 && strcmp(argv[1], "--seed") == 0){
+        params.seed = strtoul(argv[2], NULL, 10);
+        argc -= 2;
+        argv += 2;
+        argv[0] = prog;
+    }
 
     if (argc < 4){
-        fprintf(stderr, "Usage: %s dim file.pts target\n", argv[0]);
+        fprintf(stderr, "Usage: %s [--seed int] dim file.pts target [snapshot]\n", argv[0]);
         return -1;
     }
 
@@ -68,11 +84,11 @@ int main(int argc, char *argv[])
     target = atof(argv[3]);
 
     // read input points
-    pc = borPCNew(dim);
-    size = borPCAddFromFile(pc, argv[2]);
+    if (svoPtsLoad(&pts, argv[2], dim, 0) != 0)
+        return -1;
+    size = pts.len;
+    svoSamplerInitArr(&sampler, pts.data, pts.len, dim, params.seed);
     fprintf(stderr, "Added %d points from %s\n", (int)size, argv[2]);
-    borPCPermutate(pc);
-    borPCItInit(&pcit, pc);
 
 
     // create NN search structure
@@ -81,12 +97,11 @@ int main(int argc, char *argv[])
     gug_params.num_cells   = 0;
     gug_params.max_dens    = 0.1;
     gug_params.expand_rate = 1.5;
-    borPCAABB(pc, aabb);
+    svoPtsAABB(&pts, aabb);
     gug_params.aabb = aabb;
     gug = borGUGNew(&gug_params);
 
     // create GNG-T
-    svoGNGTParamsInit(&params);
     params.target = target;
     //params.age_max = 1000;
     //params.lambda = 10000;
@@ -105,6 +120,8 @@ int main(int argc, char *argv[])
     ops.data = NULL;
 
     gng = svoGNGTNew(&ops, &params);
+    if (argc > 4 && load(argv[4]) != 0)
+        return -1;
 
     signal(SIGINT, sigDump);
 
@@ -112,12 +129,16 @@ int main(int argc, char *argv[])
     svoGNGTRun(gng);
     callback(NULL);
     fprintf(stderr, "\n");
+#ifdef SVO_STATS
+    svoStatsPrint(svoGNGTStats(gng), stderr);
+#endif /* SVO_STATS */
 
     dumpSVT(gng, stdout, NULL);
 
     svoGNGTDel(gng);
     borGUGDel(gug);
-    borPCDel(pc);
+    svoSamplerFree(&sampler);
+    svoPtsClose(&pts);
 
     return 0;
 }
@@ -131,10 +152,13 @@ static int terminate(void *data)
     if (dump){
         dump = 0;
 
-        sprintf(fn, "gng-t-%06d.svt", dump_num++);
+        sprintf(fn, "gng-t-%06d.svt", dump_num);
         fout = fopen(fn, "w");
         dumpSVT(gng, fout, NULL);
         fclose(fout);
+
+        sprintf(fn, "gng-t-%06d.snap", dump_num++);
+        save(fn);
     }
 
     return 0;
@@ -153,15 +177,7 @@ static void callback(void *data)
 
 static const void *input_signal(void *data)
 {
-    const bor_vec_t *v;
-
-    if (borPCItEnd(&pcit)){
-        borPCPermutate(pc);
-        borPCItInit(&pcit, pc);
-    }
-    v = borPCItGet(&pcit);
-    borPCItNext(&pcit);
-    return (const void *)v;
+    return (const void *)svoSamplerNext(&sampler);
 }
 
 static svo_gngt_node_t *new_node(const void *is, void *_)
@@ -288,6 +304,69 @@ static void dumpSVT(svo_gngt_t *gng, FILE *out, const char *name)
     fprintf(out, "--------\n");
 }
 
+static int saveNode(const svo_gngt_node_t *_n, FILE *fout, void *_)
+{
+    const node_t *n = bor_container_of(_n, node_t, node);
+
+    if (fwrite(n->w, sizeof(bor_real_t), dim, fout) != (size_t)dim)
+        return -1;
+    return 0;
+}
+
+static svo_gngt_node_t *loadNode(FILE *fin, void *_)
+{
+    if (fread(tmpv, sizeof(bor_real_t), dim, fin) != (size_t)dim)
+        return NULL;
+    return new_node((const void *)tmpv, NULL);
+}
+
+static int save(const char *fn)
+{
+    FILE *fout;
+    uint64_t drawn;
+    int ret;
+
+    fout = fopen(fn, "wb");
+    if (!fout){
+        fprintf(stderr, "Can't open file `%s'\n", fn);
+        return -1;
+    }
+
+    // snapshot of GNG-T is followed by position of sampler
+    ret = svoGNGTSave(gng, fout, saveNode, NULL);
+    drawn = svoSamplerTell(&sampler);
+    if (ret == 0 && fwrite(&drawn, sizeof(drawn), 1, fout) != 1)
+        ret = -1;
+
+    fclose(fout);
+    return ret;
+}
+
+static int load(const char *fn)
+{
+    FILE *fin;
+    uint64_t drawn;
+    int ret;
+
+    fin = fopen(fn, "rb");
+    if (!fin){
+        fprintf(stderr, "Can't open file `%s'\n", fn);
+        return -1;
+    }
+
+    ret = svoGNGTLoad(gng, fin, loadNode, NULL);
+    if (ret == 0 && fread(&drawn, sizeof(drawn), 1, fin) != 1)
+        ret = -1;
+    if (ret == 0){
+        svoSamplerSeek(&sampler, drawn);
+        fprintf(stderr, "Restored %d nodes from %s\n",
+                (int)svoGNGTNodesLen(gng), fn);
+    }
+
+    fclose(fin);
+    return ret;
+}
+
 static void sigDump(int sig)
 {
     dump = 1;
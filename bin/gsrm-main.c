@@ -27,6 +27,7 @@ static const char *outfile_fn;
 static FILE *dump_triangles = NULL;
 static char dump_triangles_fn[DUMP_TRIANGLES_FN_LEN + 1] = "";
 static int no_postprocess = 0;
+static const char *restore_fn = NULL;
 
 static int pargc;
 static char **pargv;
@@ -34,6 +35,7 @@ static char **pargv;
 static void usage(int argc, char *argv[], const char *opt_msg);
 static void readOptions(int argc, char *argv[]);
 static void printAttrs(void);
+static int restore(const char *fn);
 
 int main(int argc, char *argv[])
 {
@@ -66,9 +68,15 @@ int main(int argc, char *argv[])
     borTimerStopAndPrintElapsed(&timer, stderr, "     --  Added %d input signals.\n", islen);
     fprintf(stderr, "\n");
 
+    if (restore_fn && restore(restore_fn) != 0)
+        return -1;
+
     if (svoGSRMRun(gsrm) == 0){
         if (!no_postprocess)
             svoGSRMPostprocess(gsrm);
+#ifdef SVO_STATS
+        svoStatsPrint(svoGSRMStats(gsrm), stderr);
+#endif /* SVO_STATS */
 
         borTimerStart(&timer);
 
@@ -132,6 +140,15 @@ static void optNN(const char *l, char s)
     }
 }
 
+static void optErrIndex(const char *l, char s)
+{
+    if (strcmp(l, "err-heap") == 0){
+        params.err_index = SVO_ERR_INDEX_HEAP;
+    }else if (strcmp(l, "err-tree") == 0){
+        params.err_index = SVO_ERR_INDEX_TREE;
+    }
+}
+
 static void optOutput(const char *l, char s, const char *val)
 {
     if (strcmp(val, "stdout") == 0){
@@ -174,6 +191,15 @@ static void readOptions(int argc, char *argv[])
     borOptsAdd("gug-max-dens",      0, BOR_OPTS_REAL,   (void *)&params.nn.gug.max_dens, NULL);
     borOptsAdd("gug-expand-rate",   0, BOR_OPTS_REAL,   (void *)&params.nn.gug.expand_rate, NULL);
     borOptsAdd("unoptimized-err",   0, BOR_OPTS_NONE,   (void *)&params.unoptimized_err, NULL);
+    borOptsAdd("err-heap",          0, BOR_OPTS_NONE,   NULL, BOR_OPTS_CB(optErrIndex));
+    borOptsAdd("err-tree",          0, BOR_OPTS_NONE,   NULL, BOR_OPTS_CB(optErrIndex));
+    borOptsAdd("compact-adj",       0, BOR_OPTS_NONE,   (void *)&params.compact_adj, NULL);
+    borOptsAdd("edge-hash",         0, BOR_OPTS_NONE,   (void *)&params.edge_hash, NULL);
+    borOptsAdd("perm-sampler",      0, BOR_OPTS_NONE,   (void *)&params.perm_sampler, NULL);
+    borOptsAdd("seed",              0, BOR_OPTS_LONG,   (void *)&params.seed, NULL);
+    borOptsAdd("checkpoint",        0, BOR_OPTS_STR,    (void *)&params.checkpoint, NULL);
+    borOptsAdd("checkpoint-period", 0, BOR_OPTS_LONG,   (void *)&params.checkpoint_period, NULL);
+    borOptsAdd("restore",           0, BOR_OPTS_STR,    (void *)&restore_fn, NULL);
     borOptsAdd("no-postprocess",    0, BOR_OPTS_NONE,   (void *)&no_postprocess, NULL);
     borOptsAdd("output",           'o', BOR_OPTS_STR,   NULL, BOR_OPTS_CB(optOutput));
 
@@ -215,6 +241,15 @@ static void usage(int argc, char *argv[], const char *opt_msg)
     fprintf(stderr, "            --angle-merge-edges float  Minimal angle between edges to merge them\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "            --unoptimized-err   Turn off optimization of error handling\n");
+    fprintf(stderr, "            --err-heap          Use pairing heap for error counters (default choise)\n");
+    fprintf(stderr, "            --err-tree          Use tournament tree for error counters\n");
+    fprintf(stderr, "            --compact-adj       Keep compact arrays of neighbors of nodes\n");
+    fprintf(stderr, "            --edge-hash         Keep hash table of edges\n");
+    fprintf(stderr, "            --perm-sampler      Draw input signals by pseudo-random permutation instead of reshuffling\n");
+    fprintf(stderr, "            --seed      int     Seed of order of input signals (default 0)\n");
+    fprintf(stderr, "            --checkpoint filename     Periodically save training state into file\n");
+    fprintf(stderr, "            --checkpoint-period int   Cycles between checkpoints (default 10000)\n");
+    fprintf(stderr, "            --restore    filename     Continue training from saved state\n");
     fprintf(stderr, "            --no-postprocess    Turn off postprocessing\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "            --nn-gug                  Use Growing Uniform Grid for NN search (default choise)\n");
@@ -236,6 +271,28 @@ static void usage(int argc, char *argv[], const char *opt_msg)
     exit(-1);
 }
 
+static int restore(const char *fn)
+{
+    FILE *fin;
+    int ret;
+
+    fin = fopen(fn, "rb");
+    if (fin == NULL){
+        fprintf(stderr, "Can't open '%s' for reading!\n", fn);
+        return -1;
+    }
+
+    ret = svoGSRMLoad(gsrm, fin);
+    fclose(fin);
+
+    if (ret == 0){
+        fprintf(stderr, " Training state restored from '%s'.\n", fn);
+        fprintf(stderr, "\n");
+    }
+
+    return ret;
+}
+
 void printAttrs(void)
 {
     const svo_gsrm_params_t *param;
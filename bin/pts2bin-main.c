@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gng/pts.h"
+
+int main(int argc, char *argv[])
+{
+    svo_pts_t pts;
+    int elsize;
+
+    if (argc < 4){
+        fprintf(stderr, "Usage: %s dim in.pts out.bin [float|double]\n", argv[0]);
+        fprintf(stderr, "   Converts text point cloud into binary format"
+                        " (see gng/pts.h).\n");
+        return -1;
+    }
+
+    elsize = 0;
+    if (argc >= 5){
+        if (strcmp(argv[4], "float") == 0){
+            elsize = 4;
+        }else if (strcmp(argv[4], "double") == 0){
+            elsize = 8;
+        }else{
+            fprintf(stderr, "Error: Unknown element type `%s'.\n", argv[4]);
+            return -1;
+        }
+    }
+
+    if (svoPtsLoadText(&pts, argv[2], atoi(argv[1]), 0) != 0)
+        return -1;
+    fprintf(stderr, "Added %d points from %s\n", (int)pts.len, argv[2]);
+
+    if (svoPtsWrite(&pts, argv[3], elsize) != 0){
+        svoPtsClose(&pts);
+        return -1;
+    }
+
+    svoPtsClose(&pts);
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_ADJ_H__
+#define __SVO_ADJ_H__
+
+#include <stdint.h>
+#include <boruvka/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Compact Adjacency
+ * ==================
+ *
+ * Neighbors of node stored as an array of 32-bit ids of neighbor nodes
+ * and array of edges connecting the node with them. Up to SVO_ADJ_INLINE
+ * neighbors are stored directly in the struct, higher degrees spill to
+ * arrays allocated on heap.
+ *
+ * Searching for edge between two nodes is then scan of a few consecutive
+ * integers instead of walking linked list of edges scattered in memory.
+ * It is only an index - the net (or mesh) stays authoritative and the
+ * owner is responsible for keeping the adjacency in sync with it.
+ */
+
+/** Number of neighbors stored without allocation */
+#define SVO_ADJ_INLINE 8
+
+struct _svo_adj_t {
+    uint32_t len;  /*!< Number of neighbors */
+    uint32_t size; /*!< Allocated size of .u.spill (zero while inline
+                        arrays are used) */
+    union {
+        struct {
+            uint32_t ids[SVO_ADJ_INLINE];
+            void *edges[SVO_ADJ_INLINE];
+        } in;
+        struct {
+            uint32_t *ids;
+            void **edges;
+        } spill;
+    } u;
+};
+typedef struct _svo_adj_t svo_adj_t;
+
+/**
+ * Initializes empty adjacency.
+ */
+_bor_inline void svoAdjInit(svo_adj_t *adj);
+
+/**
+ * Frees memory allocated by adjacency (if any).
+ */
+_bor_inline void svoAdjFree(svo_adj_t *adj);
+
+/**
+ * Returns edge connecting with node of given id or NULL.
+ */
+_bor_inline void *svoAdjFind(const svo_adj_t *adj, uint32_t id);
+
+/**
+ * Adds neighbor with given id connected by {edge}.
+ */
+void svoAdjAdd(svo_adj_t *adj, uint32_t id, void *edge);
+
+/**
+ * Removes neighbor with given id.
+ */
+void svoAdjRemove(svo_adj_t *adj, uint32_t id);
+
+/**
+ * Releases heap arrays, for internal use.
+ */
+void __svoAdjFreeSpill(svo_adj_t *adj);
+
+
+/**** INLINES ****/
+_bor_inline void svoAdjInit(svo_adj_t *adj)
+{
+    adj->len  = 0;
+    adj->size = 0;
+}
+
+_bor_inline void svoAdjFree(svo_adj_t *adj)
+{
+    if (adj->size > 0)
+        __svoAdjFreeSpill(adj);
+}
+
+_bor_inline void *svoAdjFind(const svo_adj_t *adj, uint32_t id)
+{
+    const uint32_t *ids;
+    void * const *edges;
+    uint32_t i;
+
+    if (adj->size == 0){
+        ids   = adj->u.in.ids;
+        edges = adj->u.in.edges;
+    }else{
+        ids   = adj->u.spill.ids;
+        edges = adj->u.spill.edges;
+    }
+
+    for (i = 0; i < adj->len; i++){
+        if (ids[i] == id)
+            return edges[i];
+    }
+    return NULL;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_ADJ_H__ */
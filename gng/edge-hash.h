@@ -0,0 +1,121 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_EDGE_HASH_H__
+#define __SVO_EDGE_HASH_H__
+
+#include <stdint.h>
+#include <boruvka/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Edge Hash Table
+ * ================
+ *
+ * Map from (unordered) pair of 32-bit ids of nodes to edge connecting
+ * them, so testing whether two nodes are connected takes constant time
+ * regardless of degree of nodes.
+ *
+ * The table uses open addressing with linear probing and it is kept at
+ * most half full. Removed entries are not marked by tombstones, the
+ * following entries of the cluster are shifted back instead, so lookups
+ * don't slow down as edges are created and removed over time.
+ *
+ * As svo_adj_t, it is only an index and the owner has to keep it in sync
+ * with the net (or mesh).
+ */
+
+struct _svo_edge_hash_t {
+    uint64_t *keys; /*!< Keys (pairs of ids), SVO_EDGE_HASH_EMPTY if
+                         slot is empty */
+    void **edges;   /*!< Edges corresponding to .keys */
+    size_t size;    /*!< Number of slots (power of two) */
+    size_t len;     /*!< Number of stored edges */
+    int shift;      /*!< 64 - log2(.size) */
+};
+typedef struct _svo_edge_hash_t svo_edge_hash_t;
+
+/** Key of empty slot */
+#define SVO_EDGE_HASH_EMPTY UINT64_MAX
+
+/**
+ * Initializes empty table.
+ */
+void svoEdgeHashInit(svo_edge_hash_t *h);
+
+/**
+ * Frees memory allocated by table.
+ */
+void svoEdgeHashFree(svo_edge_hash_t *h);
+
+/**
+ * Returns edge connecting nodes {id1} and {id2} or NULL.
+ */
+_bor_inline void *svoEdgeHashFind(const svo_edge_hash_t *h,
+                                  uint32_t id1, uint32_t id2);
+
+/**
+ * Adds edge connecting nodes {id1} and {id2}. The pair must not be
+ * already in table.
+ */
+void svoEdgeHashAdd(svo_edge_hash_t *h, uint32_t id1, uint32_t id2,
+                    void *edge);
+
+/**
+ * Removes edge connecting nodes {id1} and {id2} from table.
+ */
+void svoEdgeHashRemove(svo_edge_hash_t *h, uint32_t id1, uint32_t id2);
+
+
+/**** INLINES ****/
+_bor_inline uint64_t __svoEdgeHashKey(uint32_t id1, uint32_t id2)
+{
+    if (id1 < id2)
+        return ((uint64_t)id1 << 32) | id2;
+    return ((uint64_t)id2 << 32) | id1;
+}
+
+_bor_inline size_t __svoEdgeHashSlot(const svo_edge_hash_t *h, uint64_t key)
+{
+    // Fibonacci hashing
+    return (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> h->shift);
+}
+
+_bor_inline void *svoEdgeHashFind(const svo_edge_hash_t *h,
+                                  uint32_t id1, uint32_t id2)
+{
+    uint64_t key;
+    size_t i, mask;
+
+    key  = __svoEdgeHashKey(id1, id2);
+    mask = h->size - 1;
+    for (i = __svoEdgeHashSlot(h, key);
+            h->keys[i] != SVO_EDGE_HASH_EMPTY; i = (i + 1) & mask){
+        if (h->keys[i] == key)
+            return h->edges[i];
+    }
+    return NULL;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_EDGE_HASH_H__ */
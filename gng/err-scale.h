@@ -0,0 +1,40 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#ifndef __SVO_ERR_SCALE_H__
+#define __SVO_ERR_SCALE_H__
+
+#include <boruvka/core.h>
+
+/**
+ * Scaled Error Counters
+ * ======================
+ *
+ * GNG, GNG-Eu and GSRM store error counters of all nodes multiplied by
+ * common factor (.err_scale), so decreasing error counters of all nodes
+ * means only to increase the factor by 1 / beta and error heap can
+ * compare stored values directly.
+ * Once the factor exceeds SVO_ERR_SCALE_MAX all counters are
+ * renormalised. The limit leaves enough headroom below the largest
+ * representable bor_real_t for counters multiplied by the factor.
+ */
+#ifdef BOR_SINGLE
+# define SVO_ERR_SCALE_MAX BOR_REAL(1E15)
+#else /* BOR_SINGLE */
+# define SVO_ERR_SCALE_MAX BOR_REAL(1E150)
+#endif /* BOR_SINGLE */
+
+#endif /* __SVO_ERR_SCALE_H__ */
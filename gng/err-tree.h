@@ -0,0 +1,118 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_ERR_TREE_H__
+#define __SVO_ERR_TREE_H__
+
+#include <boruvka/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Error Tree
+ * ===========
+ *
+ * Index of error counters of nodes that can tell which node has the
+ * highest error counter. It is an alternative to pairing heap tuned for
+ * the way GNG accesses error counters: error counter of some node is
+ * changed in every step but the node with highest error is needed only
+ * once per {lambda} steps.
+ *
+ * It is a tournament tree over dense ids of elements: leaves hold error
+ * counters and each inner node holds the id of the leaf with the highest
+ * error in its subtree. Updating error counter only stores the value and
+ * marks the leaf dirty, i.e., it is O(1). Paths of the dirty leaves to
+ * the root are recomputed when the maximum is requested.
+ */
+
+/** Selects which structure is used for error counters */
+#define SVO_ERR_INDEX_HEAP 0 /*!< Pairing heap */
+#define SVO_ERR_INDEX_TREE 1 /*!< Tournament tree (svo_err_tree_t) */
+
+struct _svo_err_tree_el_t {
+    int id; /*!< Id of leaf assigned to element */
+};
+typedef struct _svo_err_tree_el_t svo_err_tree_el_t;
+
+struct _svo_err_tree_t {
+    int cap;                  /*!< Number of leaves (power of two) */
+    int len;                  /*!< Number of ids ever assigned */
+
+    svo_err_tree_el_t **els;  /*!< Elements by id (NULL if id is free) */
+    bor_real_t *err;          /*!< Error counters by id */
+    int *win;                 /*!< Inner nodes 1, ..., .cap - 1, each holds
+                                   id with highest error in subtree */
+
+    char *dirty;              /*!< Dirty flags by id */
+    int *dirty_ids;           /*!< Ids with changed error counters */
+    int dirty_len;
+
+    int *free_ids;            /*!< Released ids */
+    int free_len;
+};
+typedef struct _svo_err_tree_t svo_err_tree_t;
+
+/**
+ * Initializes empty tree.
+ */
+void svoErrTreeInit(svo_err_tree_t *t);
+
+/**
+ * Frees all memory allocated by tree (elements are not touched).
+ */
+void svoErrTreeFree(svo_err_tree_t *t);
+
+/**
+ * Adds element with given error counter into tree.
+ */
+void svoErrTreeAdd(svo_err_tree_t *t, svo_err_tree_el_t *el, bor_real_t err);
+
+/**
+ * Removes element from tree.
+ */
+void svoErrTreeRemove(svo_err_tree_t *t, svo_err_tree_el_t *el);
+
+/**
+ * Changes error counter of element.
+ */
+_bor_inline void svoErrTreeUpdate(svo_err_tree_t *t, svo_err_tree_el_t *el,
+                                  bor_real_t err);
+
+/**
+ * Returns element with highest error counter or NULL if tree is empty.
+ */
+svo_err_tree_el_t *svoErrTreeMax(svo_err_tree_t *t);
+
+
+/**** INLINES ****/
+_bor_inline void svoErrTreeUpdate(svo_err_tree_t *t, svo_err_tree_el_t *el,
+                                  bor_real_t err)
+{
+    t->err[el->id] = err;
+    if (!t->dirty[el->id]){
+        t->dirty[el->id] = 1;
+        t->dirty_ids[t->dirty_len++] = el->id;
+    }
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_ERR_TREE_H__ */
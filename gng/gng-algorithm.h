@@ -0,0 +1,556 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#ifndef __SVO_GNG_ALGORITHM_H__
+#define __SVO_GNG_ALGORITHM_H__
+
+#include <boruvka/alloc.h>
+#include <gng/gng.h>
+#include <gng/gng-t.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Devirtualised GNG and GNG-T
+ * ============================
+ *
+ * svoGNGRun() and svoGNGTRun() call user's operations through function
+ * pointers in svo_gng_ops_t (svo_gngt_ops_t), i.e., several indirect calls
+ * per input signal which compiler can neither inline nor vectorise.
+ *
+ * SVO_GNG_DEFINE() and SVO_GNGT_DEFINE() macros emit static functions
+ * that run the same algorithm with the per-signal operations
+ * (input_signal, nearest, dist2, move_towards) called directly, so they
+ * can be inlined into the learning loop. The learning step itself is
+ * written once below (__svoGNGLearn(), __svoGNGTAdapt()) and the library's
+ * own svoGNGLearn() and svoGNGTAdapt() are instances of it with
+ * operations taken from gng->ops, so both behave identically.
+ *
+ * Operations called once per cycle or less (init, new_node,
+ * new_node_between, del_node, terminate, callback) still go through
+ * gng->ops, so ops must be filled as usual. Also the data pointers
+ * (ops.nearest_data, ...) are taken from gng->ops and passed to the
+ * direct calls unchanged. Batched operations (ops.input_signal_batch,
+ * ops.nearest_batch, ops.move_towards_many) are not used by the emitted
+ * functions.
+ *
+ * Functions given to the macros work with user's node type {node_type}
+ * which must contain svo_gng_node_t (svo_gngt_node_t) as member {member}:
+ *
+ *     const void *input_signal_fn(void *data);
+ *     void nearest_fn(const void *is, node_type **n1, node_type **n2,
+ *                     void *data);
+ *     bor_real_t dist2_fn(const void *is, const node_type *n, void *data);
+ *     void move_towards_fn(node_type *n, const void *is,
+ *                          bor_real_t fraction, void *data);
+ *
+ * Example:
+ * ~~~~~~
+ *     struct node_t {
+ *         svo_gng_node_t gng;
+ *         bor_vec2_t w;
+ *         bor_nn_el_t nn;
+ *     };
+ *
+ *     static const void *inputSignal(void *data);
+ *     static void nearest(const void *is, struct node_t **n1,
+ *                         struct node_t **n2, void *data);
+ *     ...
+ *
+ *     SVO_GNG_DEFINE(myGNG, struct node_t, gng,
+ *                    inputSignal, nearest, dist2, moveTowards)
+ *
+ *     ...
+ *     myGNGRun(gng); // instead of svoGNGRun(gng)
+ *
+ * Emitted functions are (all static inline):
+ *     SVO_GNG_DEFINE:  void prefix##Learn(svo_gng_t *gng);
+ *                      void prefix##Run(svo_gng_t *gng);
+ *     SVO_GNGT_DEFINE: void prefix##Adapt(svo_gngt_t *gng);
+ *                      void prefix##Run(svo_gngt_t *gng);
+ * where Learn, Adapt and Run correspond to svoGNGLearn(), svoGNGTAdapt()
+ * and svoGNGRun() (svoGNGTRun()).
+ */
+#define SVO_GNG_DEFINE(prefix, node_type, member, \
+                       input_signal_fn, nearest_fn, dist2_fn, \
+                       move_towards_fn) \
+    static inline void prefix##OpNearest(const void *is, \
+                                         svo_gng_node_t **n1, \
+                                         svo_gng_node_t **n2, void *data) \
+    { \
+        node_type *m1, *m2; \
+        nearest_fn(is, &m1, &m2, data); \
+        *n1 = &m1->member; \
+        *n2 = &m2->member; \
+    } \
+    static inline bor_real_t prefix##OpDist2(const void *is, \
+                                             const svo_gng_node_t *n, \
+                                             void *data) \
+    { \
+        return dist2_fn(is, bor_container_of(n, node_type, member), data); \
+    } \
+    static inline void prefix##OpMoveTowards(svo_gng_node_t *n, \
+                                             const void *is, \
+                                             bor_real_t fraction, \
+                                             void *data) \
+    { \
+        move_towards_fn(bor_container_of(n, node_type, member), is, \
+                        fraction, data); \
+    } \
+    static inline void prefix##Learn(svo_gng_t *gng) \
+    { \
+        __svoGNGLearn(gng, input_signal_fn, prefix##OpNearest, \
+                      prefix##OpDist2, prefix##OpMoveTowards, NULL); \
+    } \
+    static inline void prefix##Run(svo_gng_t *gng) \
+    { \
+        __svoGNGRun(gng, prefix##Learn, NULL); \
+    }
+
+#define SVO_GNGT_DEFINE(prefix, node_type, member, \
+                        input_signal_fn, nearest_fn, dist2_fn, \
+                        move_towards_fn) \
+    static inline void prefix##OpNearest(const void *is, \
+                                         svo_gngt_node_t **n1, \
+                                         svo_gngt_node_t **n2, void *data) \
+    { \
+        node_type *m1, *m2; \
+        nearest_fn(is, &m1, &m2, data); \
+        *n1 = &m1->member; \
+        *n2 = &m2->member; \
+    } \
+    static inline bor_real_t prefix##OpDist2(const void *is, \
+                                             const svo_gngt_node_t *n, \
+                                             void *data) \
+    { \
+        return dist2_fn(is, bor_container_of(n, node_type, member), data); \
+    } \
+    static inline void prefix##OpMoveTowards(svo_gngt_node_t *n, \
+                                             const void *is, \
+                                             bor_real_t fraction, \
+                                             void *data) \
+    { \
+        move_towards_fn(bor_container_of(n, node_type, member), is, \
+                        fraction, data); \
+    } \
+    static inline void prefix##Adapt(svo_gngt_t *gng) \
+    { \
+        __svoGNGTAdapt(gng, input_signal_fn, prefix##OpNearest, \
+                       prefix##OpDist2, prefix##OpMoveTowards, NULL); \
+    } \
+    static inline void prefix##Run(svo_gngt_t *gng) \
+    { \
+        __svoGNGTRun(gng, prefix##Adapt, NULL); \
+    }
+
+
+/**
+ * Bodies below are forced inline, so that operations passed as arguments
+ * become compile-time constants in the caller and indirect calls turn
+ * into direct (and inlinable) ones. Optional operations (move_towards_many,
+ * learn_batch) may be NULL, which removes their branches altogether.
+ */
+#ifdef __GNUC__
+# define __SVO_ALG_INLINE static inline __attribute__((always_inline))
+#else /* __GNUC__ */
+# define __SVO_ALG_INLINE static inline
+#endif /* __GNUC__ */
+
+/**
+ * Steps 3. - 7. of GNG learning for input signal {is} and its two
+ * nearest nodes {n1} and {n2}. If {defer_del} is true, isolated nodes
+ * are only passed to svoGNGNodeDelLater().
+ */
+__SVO_ALG_INLINE void __svoGNGLearnApply(svo_gng_t *gng, const void *is,
+                                    svo_gng_node_t *n1, svo_gng_node_t *n2,
+                                    int defer_del,
+                                    svo_gng_dist2 dist2_fn,
+                                    svo_gng_move_towards move_towards_fn,
+                                    svo_gng_move_towards_many move_many_fn);
+
+/**
+ * One learning step of GNG, see svoGNGLearn().
+ */
+__SVO_ALG_INLINE void __svoGNGLearn(svo_gng_t *gng,
+                                    svo_gng_input_signal input_signal_fn,
+                                    svo_gng_nearest nearest_fn,
+                                    svo_gng_dist2 dist2_fn,
+                                    svo_gng_move_towards move_towards_fn,
+                                    svo_gng_move_towards_many move_many_fn);
+
+/**
+ * Whole GNG run, see svoGNGRun(). If {learn_batch} is not NULL, it is
+ * called once per cycle instead of params.lambda calls of {learn}.
+ */
+__SVO_ALG_INLINE void __svoGNGRun(svo_gng_t *gng,
+                                  void (*learn)(svo_gng_t *),
+                                  void (*learn_batch)(svo_gng_t *, size_t));
+
+/**
+ * Steps 3. - 8. of GNG-T adaptation, see __svoGNGLearnApply().
+ */
+__SVO_ALG_INLINE void __svoGNGTAdaptApply(svo_gngt_t *gng, const void *is,
+                                    svo_gngt_node_t *n1, svo_gngt_node_t *n2,
+                                    int defer_del,
+                                    svo_gngt_dist2 dist2_fn,
+                                    svo_gngt_move_towards move_towards_fn,
+                                    svo_gngt_move_towards_many move_many_fn);
+
+/**
+ * One adaptation step of GNG-T, see svoGNGTAdapt().
+ */
+__SVO_ALG_INLINE void __svoGNGTAdapt(svo_gngt_t *gng,
+                                     svo_gngt_input_signal input_signal_fn,
+                                     svo_gngt_nearest nearest_fn,
+                                     svo_gngt_dist2 dist2_fn,
+                                     svo_gngt_move_towards move_towards_fn,
+                                     svo_gngt_move_towards_many move_many_fn);
+
+/**
+ * Whole GNG-T run, see svoGNGTRun() and __svoGNGRun().
+ */
+__SVO_ALG_INLINE void __svoGNGTRun(svo_gngt_t *gng,
+                                   void (*adapt)(svo_gngt_t *),
+                                   void (*adapt_batch)(svo_gngt_t *, size_t));
+
+
+/**** INLINES ****/
+__SVO_ALG_INLINE void __svoGNGLearnApply(svo_gng_t *gng, const void *is,
+                                    svo_gng_node_t *n1, svo_gng_node_t *n2,
+                                    int defer_del,
+                                    svo_gng_dist2 dist2_fn,
+                                    svo_gng_move_towards move_towards_fn,
+                                    svo_gng_move_towards_many move_many_fn)
+{
+    bor_net_node_t *nn;
+    svo_gng_node_t *n;
+    bor_net_edge_t *nedge;
+    svo_gng_edge_t *edge;
+    bor_real_t dist2;
+    unsigned long age;
+    bor_list_t *list, *item, *item_tmp;
+    size_t neigh_len = 0;
+
+    if (gng->step > gng->params.lambda){
+        gng->cycle += 1L;
+        gng->step = 1;
+    }
+
+    // 3. Create connection between n1 and n2 if doesn't exist and set age
+    //    to zero
+    svoGNGHebbianLearning(gng, n1, n2);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_HEBBIAN);
+
+    // 4. Increase error counter of winner node
+    dist2 = dist2_fn(is, n1, gng->ops.dist2_data);
+    svoGNGNodeIncError(gng, n1, dist2);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_ERR);
+
+    // 5. Adapt nodes to input signal using fractions eb and en
+    // + 6. Increment age of all edges by one
+    // + 7. Remove edges with age higher than age_max
+    if (move_many_fn){
+        // surviving neighbors are collected and moved with winner at once
+        neigh_len = borNetNodeEdgesLen(&n1->node);
+        if (neigh_len > gng->neigh_size){
+            gng->neigh_size = neigh_len;
+            gng->neigh = BOR_REALLOC_ARR(gng->neigh, svo_gng_node_t *,
+                                         neigh_len);
+        }
+        neigh_len = 0;
+    }else{
+        move_towards_fn(n1, is, gng->params.eb, gng->ops.move_towards_data);
+        SVO_STATS_LAP(&gng->stats, SVO_STATS_MOVE);
+    }
+    // all edges of winner get older by one (6.)
+    ++n1->wins;
+    // adapt also direct topological neighbors of winner node
+    list = borNetNodeEdges(&n1->node);
+    BOR_LIST_FOR_EACH_SAFE(list, item, item_tmp){
+        nedge = borNetEdgeFromNodeList(item);
+        edge  = bor_container_of(nedge, svo_gng_edge_t, edge);
+        nn   = borNetEdgeOtherNode(&edge->edge, &n1->node);
+        n    = bor_container_of(nn, svo_gng_node_t, node);
+
+        // remove edge if it has age higher than age_max (7.)
+        age = n1->wins + n->wins - edge->age_base;
+        if (age > (unsigned long)gng->params.age_max){
+            svoGNGEdgeDel(gng, edge);
+
+            if (borNetNodeEdgesLen(nn) == 0){
+                // remove node if not connected into net anymore
+                if (defer_del){
+                    svoGNGNodeDelLater(gng, n);
+                }else{
+                    svoGNGNodeDel(gng, n);
+                }
+                n = NULL;
+            }
+            SVO_STATS_LAP(&gng->stats, SVO_STATS_PRUNE);
+        }
+
+        // move node (5.)
+        if (n){
+            if (move_many_fn){
+                gng->neigh[neigh_len++] = n;
+            }else{
+                move_towards_fn(n, is, gng->params.en,
+                                gng->ops.move_towards_data);
+                SVO_STATS_LAP(&gng->stats, SVO_STATS_MOVE);
+            }
+        }
+    }
+
+    if (move_many_fn){
+        move_many_fn(n1, gng->neigh, neigh_len, is,
+                             gng->params.eb, gng->params.en,
+                             gng->ops.move_towards_many_data);
+        SVO_STATS_LAP(&gng->stats, SVO_STATS_MOVE);
+    }
+
+    // remove winning node if not connected into net
+    if (borNetNodeEdgesLen(&n1->node) == 0){
+        // remove node if not connected into net anymore
+        if (defer_del){
+            svoGNGNodeDelLater(gng, n1);
+        }else{
+            svoGNGNodeDel(gng, n1);
+        }
+        SVO_STATS_LAP(&gng->stats, SVO_STATS_PRUNE);
+    }
+
+    ++gng->step;
+
+    // decrease error counters of all nodes
+    svoGNGDecreaseErrCounters(gng);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_ERR);
+}
+
+__SVO_ALG_INLINE void __svoGNGLearn(svo_gng_t *gng,
+                                    svo_gng_input_signal input_signal_fn,
+                                    svo_gng_nearest nearest_fn,
+                                    svo_gng_dist2 dist2_fn,
+                                    svo_gng_move_towards move_towards_fn,
+                                    svo_gng_move_towards_many move_many_fn)
+{
+    const void *input_signal;
+    svo_gng_node_t *n1, *n2;
+
+    SVO_STATS_START(&gng->stats);
+
+    // 1. Get input signal
+    input_signal = input_signal_fn(gng->ops.input_signal_data);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_INPUT);
+
+    // 2. Find two nearest nodes to input signal
+    nearest_fn(input_signal, &n1, &n2, gng->ops.nearest_data);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_NEAREST);
+
+    // 3. - 7.
+    __svoGNGLearnApply(gng, input_signal, n1, n2, 0, dist2_fn,
+                       move_towards_fn, move_many_fn);
+}
+
+__SVO_ALG_INLINE void __svoGNGRun(svo_gng_t *gng,
+                                  void (*learn)(svo_gng_t *),
+                                  void (*learn_batch)(svo_gng_t *, size_t))
+{
+    unsigned long cycle;
+    size_t i;
+
+    cycle = 0;
+    svoGNGInit(gng);
+
+    do {
+        if (learn_batch){
+            learn_batch(gng, gng->params.lambda);
+        }else{
+            for (i = 0; i < gng->params.lambda; i++){
+                learn(gng);
+            }
+        }
+        svoGNGNewNode(gng);
+
+        cycle++;
+        if (gng->ops.callback && gng->ops.callback_period == cycle){
+            gng->ops.callback(gng->ops.callback_data);
+            cycle = 0L;
+        }
+    } while (!gng->ops.terminate(gng->ops.terminate_data));
+}
+
+__SVO_ALG_INLINE void __svoGNGTAdaptApply(svo_gngt_t *gng, const void *is,
+                                    svo_gngt_node_t *n1, svo_gngt_node_t *n2,
+                                    int defer_del,
+                                    svo_gngt_dist2 dist2_fn,
+                                    svo_gngt_move_towards move_towards_fn,
+                                    svo_gngt_move_towards_many move_many_fn)
+{
+    bor_net_edge_t *ne;
+    bor_net_node_t *nn;
+    svo_gngt_edge_t *e;
+    bor_real_t dist2;
+    unsigned long age;
+    bor_list_t *list, *item, *item_tmp;
+    size_t neigh_len = 0;
+
+    n1->won = 1;
+
+    // 3. Create (or refresh) an edge between n1 and n2
+    svoGNGTHebbianLearning(gng, n1, n2);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_HEBBIAN);
+
+    // 4. Update accumulator
+    dist2 = dist2_fn(is, n1, gng->ops.dist2_data);
+    n1->err += dist2;
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_ERR);
+
+    // 5. Move winner node towards is
+    //    (ops.move_towards also updates user's NN structure, so it is
+    //    accounted as a move)
+    if (move_many_fn){
+        // surviving neighbors are collected and moved with winner at once
+        neigh_len = borNetNodeEdgesLen(&n1->node);
+        if (neigh_len > gng->neigh_size){
+            gng->neigh_size = neigh_len;
+            gng->neigh = BOR_REALLOC_ARR(gng->neigh, svo_gngt_node_t *,
+                                         neigh_len);
+        }
+        neigh_len = 0;
+    }else{
+        move_towards_fn(n1, is, gng->params.eb, gng->ops.move_towards_data);
+        SVO_STATS_LAP(&gng->stats, SVO_STATS_MOVE);
+    }
+
+    // 6. Move n1's neighbors towards is
+    // + 7. Increment age of all edges emanating from n1
+    // + 8. Remove edges with age > age_max
+    ++n1->wins;
+    list = borNetNodeEdges(&n1->node);
+    BOR_LIST_FOR_EACH_SAFE(list, item, item_tmp){
+        ne = borNetEdgeFromNodeList(item);
+        e  = bor_container_of(ne, svo_gngt_edge_t, edge);
+        nn = borNetEdgeOtherNode(ne, &n1->node);
+        n2 = bor_container_of(nn, svo_gngt_node_t, node);
+
+        // age is derived from wins of nodes, so it was incremented
+        // with n1->wins (7.)
+        age = n1->wins + n2->wins - e->age_base;
+
+        // delete edge (8.)
+        if (age > (unsigned long)gng->params.age_max){
+            svoGNGTEdgeDel(gng, e);
+
+            if (borNetNodeEdgesLen(&n2->node) == 0){
+                // remove node if not connected into net anymore
+                if (defer_del){
+                    svoGNGTNodeDelLater(gng, n2);
+                }else{
+                    svoGNGTNodeDel(gng, n2);
+                }
+            }
+            SVO_STATS_LAP(&gng->stats, SVO_STATS_PRUNE);
+        }else if (move_many_fn){
+            gng->neigh[neigh_len++] = n2;
+        }else{
+            // move node (6.)
+            move_towards_fn(n2, is, gng->params.en,
+                            gng->ops.move_towards_data);
+            SVO_STATS_LAP(&gng->stats, SVO_STATS_MOVE);
+        }
+    }
+
+    if (move_many_fn){
+        move_many_fn(n1, gng->neigh, neigh_len, is,
+                             gng->params.eb, gng->params.en,
+                             gng->ops.move_towards_many_data);
+        SVO_STATS_LAP(&gng->stats, SVO_STATS_MOVE);
+    }
+
+    // remove winning node if not connected into net
+    if (borNetNodeEdgesLen(&n1->node) == 0){
+        // remove node if not connected into net anymore
+        if (defer_del){
+            svoGNGTNodeDelLater(gng, n1);
+        }else{
+            svoGNGTNodeDel(gng, n1);
+        }
+        SVO_STATS_LAP(&gng->stats, SVO_STATS_PRUNE);
+    }
+}
+
+__SVO_ALG_INLINE void __svoGNGTAdapt(svo_gngt_t *gng,
+                                     svo_gngt_input_signal input_signal_fn,
+                                     svo_gngt_nearest nearest_fn,
+                                     svo_gngt_dist2 dist2_fn,
+                                     svo_gngt_move_towards move_towards_fn,
+                                     svo_gngt_move_towards_many move_many_fn)
+{
+    const void *is;
+    svo_gngt_node_t *n1, *n2;
+
+    SVO_STATS_START(&gng->stats);
+
+    // 1. Get input signal
+    is = input_signal_fn(gng->ops.input_signal_data);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_INPUT);
+
+    // 2. Find two nearest nodes to input signal
+    nearest_fn(is, &n1, &n2, gng->ops.nearest_data);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_NEAREST);
+
+    // 3. - 8.
+    __svoGNGTAdaptApply(gng, is, n1, n2, 0, dist2_fn,
+                        move_towards_fn, move_many_fn);
+}
+
+__SVO_ALG_INLINE void __svoGNGTRun(svo_gngt_t *gng,
+                                   void (*adapt)(svo_gngt_t *),
+                                   void (*adapt_batch)(svo_gngt_t *, size_t))
+{
+    unsigned long cycle = 0L;
+    size_t i;
+
+    if (svoGNGTNodesLen(gng) == 0)
+        svoGNGTInit(gng);
+
+    do {
+        svoGNGTReset(gng);
+        if (adapt_batch){
+            adapt_batch(gng, gng->params.lambda);
+        }else{
+            for (i = 0; i < gng->params.lambda; i++){
+                adapt(gng);
+            }
+        }
+
+        svoGNGTGrowShrink(gng);
+
+        cycle++;
+        if (gng->ops.callback && gng->ops.callback_period == cycle){
+            gng->ops.callback(gng->ops.callback_data);
+            cycle = 0L;
+        }
+    } while (!gng->ops.terminate(gng->ops.terminate_data));
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_GNG_ALGORITHM_H__ */
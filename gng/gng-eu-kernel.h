@@ -0,0 +1,93 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#ifndef __SVO_GNG_EU_KERNEL_H__
+#define __SVO_GNG_EU_KERNEL_H__
+
+#include <boruvka/vec.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * GNGEu Vector Kernels
+ * =====================
+ *
+ * Vector operations GNGEu performs for each input signal, i.e., squared
+ * distance between input signal and node and moving of node towards
+ * input signal, and computing of position of a new node.
+ *
+ * Kernels are chosen once (see svoGNGEuKernel()) according to the
+ * dimension and the instruction sets the CPU supports, so the rest of the
+ * code only calls them through function pointers.
+ *
+ * For dimensions listed in SVO_GNG_EU_KERNEL_DIMS there are kernels with
+ * the dimension fixed at compile time (i.e., with fully unrolled loops),
+ * other dimensions are handled by generic SIMD kernels.
+ */
+
+/** Dimensions with compile-time specialized kernels */
+#define SVO_GNG_EU_KERNEL_DIMS { 2, 3, 4, 6, 8, 12, 16, 32, 64 }
+
+/** vvvv */
+
+/**
+ * Returns squared distance between {a} and {b}.
+ */
+typedef bor_real_t (*svo_gng_eu_kernel_dist2)(int dim, const bor_vec_t *a,
+                                              const bor_vec_t *b);
+
+/**
+ * Moves {w} towards {x} by given fraction, i.e.:
+ * w = w + ((x - w) * fraction)
+ */
+typedef void (*svo_gng_eu_kernel_move_towards)(int dim, bor_vec_t *w,
+                                               const bor_vec_t *x,
+                                               bor_real_t fraction);
+
+/**
+ * Stores into {out} point in the middle between {a} and {b}.
+ */
+typedef void (*svo_gng_eu_kernel_between)(int dim, bor_vec_t *out,
+                                          const bor_vec_t *a,
+                                          const bor_vec_t *b);
+
+/** ^^^^ */
+
+struct _svo_gng_eu_kernel_t {
+    const char *name; /*!< Name of kernel (e.g., "avx2", "fixed6") */
+    svo_gng_eu_kernel_dist2 dist2;
+    svo_gng_eu_kernel_move_towards move_towards;
+    svo_gng_eu_kernel_between between;
+};
+typedef struct _svo_gng_eu_kernel_t svo_gng_eu_kernel_t;
+
+/**
+ * Returns the fastest kernel the CPU supports for vectors of given
+ * dimension.
+ * If the dimension is one of SVO_GNG_EU_KERNEL_DIMS kernel specialized
+ * for that dimension is returned (compiled also for AVX2 on x86).
+ * Otherwise, on x86 AVX-512, AVX2 (with FMA) and SSE2 instruction sets
+ * are considered and generic C implementation is used as a fallback.
+ */
+const svo_gng_eu_kernel_t *svoGNGEuKernel(int dim);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_GNG_EU_KERNEL_H__ */
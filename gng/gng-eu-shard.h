@@ -0,0 +1,79 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#ifndef __SVO_GNG_EU_SHARD_H__
+#define __SVO_GNG_EU_SHARD_H__
+
+#include <gng/gng-eu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Sharded GNGEu Training
+ * =======================
+ *
+ * Input space is split along the longest axis of its bounding box into
+ * .num_shards slabs containing (approximately) the same number of input
+ * signals. Each slab is trained by independent GNGEu in its own thread.
+ * Slabs are extended by a halo on both sides, so nodes near the borders
+ * of a slab are trained with signals from both neighboring slabs.
+ *
+ * When all shards reach their share of .max_nodes, they are merged into
+ * one net: each shard contributes only nodes lying in its own slab (i.e.,
+ * without halo) and edges between them. Finally, the merged net is
+ * trained for .stitch_steps steps by signals lying near borders of slabs
+ * to reconnect the shards, and nodes left without any edge are removed.
+ */
+
+struct _svo_gng_eu_shard_params_t {
+    svo_gng_eu_params_t gng; /*!< Parameters of GNGEu of each shard and of
+                                  merged net. If .gng.nn.gug.aabb is set
+                                  it is used as bounding box of input
+                                  signals. Each shard draws its input
+                                  signals from its own stream of
+                                  generator seeded by .gng.seed. */
+    int num_shards;       /*!< Number of slabs (and threads). Default: 4 */
+    bor_real_t halo;      /*!< Width of halo relative to average width of
+                               slab. Default: 0.1 */
+    size_t max_nodes;     /*!< Number of nodes of the whole net.
+                               Default: 1000 */
+    size_t stitch_steps;  /*!< Number of learning steps of the merged net.
+                               Default: 20 * lambda */
+};
+typedef struct _svo_gng_eu_shard_params_t svo_gng_eu_shard_params_t;
+
+/**
+ * Initializes params struct to default values.
+ */
+void svoGNGEuShardParamsInit(svo_gng_eu_shard_params_t *params);
+
+/**
+ * Trains GNGEu from all points of {pc} using sharding described above and
+ * returns the merged net. {ops} (may be NULL) are given to the merged
+ * net, only .new_node and .del_node are used during training.
+ * {pc} must not be modified while training.
+ */
+svo_gng_eu_t *svoGNGEuShardTrain(const svo_gng_eu_shard_params_t *params,
+                                 const svo_gng_eu_ops_t *ops,
+                                 bor_pc_t *pc);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_GNG_EU_SHARD_H__ */
@@ -25,6 +25,16 @@
 #include <boruvka/pc.h>
 #include <boruvka/nn.h>
 #include <boruvka/alloc.h>
+#include <gng/gng-eu-kernel.h>
+#include <gng/pool.h>
+#include <gng/err-tree.h>
+#include <gng/adj.h>
+#include <gng/edge-hash.h>
+#include <gng/sampler.h>
+#include <gng/stats.h>
+#include <gng/err-scale.h>
+#include <gng/rng.h>
+#include <gng/parallel.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,14 +50,21 @@ extern "C" {
 struct _svo_gng_eu_node_t {
     bor_net_node_t node;
 
-    bor_real_t err;               /*!< Overall error */
-    unsigned long err_cycle;      /*!< Last cycle in which were .err changed */
+    bor_real_t err;               /*!< Overall error multiplied by
+                                       svo_gng_eu_t's .err_scale, use
+                                       svoGNGEuNodeErr() */
     bor_pairheap_node_t err_heap; /*!< Connection to error heap */
+    svo_err_tree_el_t err_tree;   /*!< Connection to error tree */
 
     bor_vec_t *w;   /*!< Weight vector */
     bor_nn_el_t nn; /*!< Struct for NN search */
 
+    unsigned long wins; /*!< Number of times node was a winner */
+
+    int id;  /*!< Dense id of node, see svo_gng_eu_weights_t */
     int _id; /*!< Currently useful only for svoGNGEuDumpSVT(). */
+
+    svo_adj_t adj; /*!< Neighbors keyed by .id (if params.compact_adj) */
 };
 typedef struct _svo_gng_eu_node_t svo_gng_eu_node_t;
 
@@ -55,7 +72,8 @@ typedef struct _svo_gng_eu_node_t svo_gng_eu_node_t;
 struct _svo_gng_eu_edge_t {
     bor_net_edge_t edge;
 
-    int age;
+    unsigned long age_base; /*!< Sum of .wins of both nodes when edge was
+                                 created or refreshed, use svoGNGEuEdgeAge() */
 };
 typedef struct _svo_gng_eu_edge_t svo_gng_eu_edge_t;
 
@@ -144,6 +162,38 @@ struct _svo_gng_eu_params_t {
                              nearest neighbor search.
                              Default is Growing Uniform Grid with default
                              values */
+
+    int dense_weights; /*!< If true, weight vectors of all nodes are
+                            stored in one contiguous storage indexed by
+                            dense ids of nodes (see svo_gng_eu_weights_t).
+                            Default: false */
+
+    int num_threads; /*!< Number of threads used for searching of
+                          winners in svoGNGEuLearnBatch() and
+                          svoGNGEuQuantize(). Workers are started once
+                          by svoGNGEuNew() and kept till svoGNGEuDel().
+                          Default: 1 */
+
+    int err_index; /*!< Structure used for finding node with highest
+                        error counter, SVO_ERR_INDEX_HEAP (pairing heap)
+                        or SVO_ERR_INDEX_TREE (see svo_err_tree_t).
+                        Default: SVO_ERR_INDEX_HEAP */
+
+    int compact_adj; /*!< If true, each node keeps also compact array of
+                          its neighbors (see svo_adj_t) which is used
+                          for finding edge between two nodes instead of
+                          walking lists of edges.
+                          Default: false */
+    int edge_hash; /*!< If true, all edges are kept also in hash table
+                        keyed by pairs of ids of nodes (see
+                        svo_edge_hash_t) which is then used for finding
+                        edge between two nodes (it takes precedence over
+                        .compact_adj). Default: false */
+
+    unsigned long seed; /*!< Seed of order in which built-in sampler
+                             draws input signals (see
+                             svoGNGEuInputSignalsPC()) and of generator
+                             returned by svoGNGEuRng(). Default: 0 */
 };
 typedef struct _svo_gng_eu_params_t svo_gng_eu_params_t;
 
@@ -154,6 +204,73 @@ void svoGNGEuParamsInit(svo_gng_eu_params_t *params);
 
 
 
+/**
+ * GNGEu Weight Storage
+ * ---------------------
+ *
+ * Each node gets dense id (svo_gng_eu_node_t.id) from range [0, len).
+ * Ids of deleted nodes are recycled, so the range stays as compact as the
+ * net is.
+ *
+ * If params.dense_weights is set, weight vectors are stored in blocks of
+ * SVO_GNG_EU_WEIGHTS_BLOCK weights one after another (each padded to
+ * .stride reals) and node's weight vector is addressed by its id.
+ * Blocks are aligned to cache line and they are never moved, so
+ * svo_gng_eu_node_t.w remains valid while the storage grows.
+ */
+
+/** Number of weight vectors in one block is 2^SVO_GNG_EU_WEIGHTS_BLOCK_SHIFT */
+#define SVO_GNG_EU_WEIGHTS_BLOCK_SHIFT 10
+#define SVO_GNG_EU_WEIGHTS_BLOCK (1 << SVO_GNG_EU_WEIGHTS_BLOCK_SHIFT)
+
+struct _svo_gng_eu_weights_t {
+    size_t stride;       /*!< Number of reals occupied by one weight vector,
+                              zero if weight vectors aren't stored */
+    bor_real_t **blocks; /*!< Array of blocks */
+    size_t blocks_len;   /*!< Number of allocated blocks */
+
+    size_t len;          /*!< Number of ids given so far (including
+                              released ones) */
+    int *free_ids;       /*!< Stack of released ids */
+    size_t free_len;     /*!< Number of ids in .free_ids */
+    size_t free_size;    /*!< Allocated size of .free_ids */
+};
+typedef struct _svo_gng_eu_weights_t svo_gng_eu_weights_t;
+
+/**
+ * Returns new dense id. If weight vectors are stored, storage is enlarged
+ * if necessary.
+ */
+int svoGNGEuWeightsAlloc(svo_gng_eu_weights_t *ws);
+
+/**
+ * Releases id, i.e., the id (and its weight vector) can be reused.
+ */
+void svoGNGEuWeightsRelease(svo_gng_eu_weights_t *ws, int id);
+
+/**
+ * Returns weight vector stored under given id.
+ */
+_bor_inline bor_vec_t *svoGNGEuWeightsGet(const svo_gng_eu_weights_t *ws,
+                                          int id);
+
+
+
+/**
+ * GNGEu Input Signals
+ * --------------------
+ *
+ * Instead of providing ops.input_signal, input signals can be handed to
+ * GNGEu directly either as point cloud (svoGNGEuInputSignalsPC()) or as
+ * contiguous array of vectors (svoGNGEuInputSignalsArr()). GNGEu then
+ * samples them itself (see svo_sampler_t) without calling any callback:
+ * signals are visited in pseudo-random order given by params.seed, each
+ * one once per epoch, and signals that come next are prefetched while the
+ * current one is processed.
+ */
+
+
+
 /**
  * GNGEu Algorithm
  * ----------------
@@ -161,22 +278,50 @@ void svoGNGEuParamsInit(svo_gng_eu_params_t *params);
  * See svo_gng_eu_t.
  */
 
+/**
+ * Limit of common factor of error counters (svo_gng_eu_t's .err_scale),
+ * see gng/err-scale.h.
+ */
+#define SVO_GNG_EU_ERR_SCALE_MAX SVO_ERR_SCALE_MAX
+
 struct _svo_gng_eu_t {
     bor_net_t *net;
-    bor_pairheap_t *err_heap;
+    bor_pairheap_t *err_heap; /*!< Error heap (SVO_ERR_INDEX_HEAP) */
+    svo_err_tree_t err_tree;  /*!< Error tree (SVO_ERR_INDEX_TREE) */
+    svo_edge_hash_t edge_hash; /*!< Edges by pairs of nodes (if
+                                    params.edge_hash) */
 
     svo_gng_eu_ops_t ops;
     svo_gng_eu_params_t params;
 
-    bor_real_t *beta_n; /*!< Precomputed beta^n for n = 1, ..., lambda */
-    bor_real_t *beta_lambda_n; /*!< Precomputed beta^(n*lambda) */
-    size_t beta_lambda_n_len;
+    bor_real_t err_scale;     /*!< Common factor of all error counters */
+    bor_real_t err_scale_inc; /*!< 1 / beta */
 
     size_t step;
     unsigned long cycle;
 
     bor_nn_t *nn;
 
+    svo_gng_eu_weights_t weights; /*!< Dense ids and weight vectors */
+    svo_pool_t node_pool; /*!< Nodes (if ops.new_node isn't set) */
+    svo_pool_t edge_pool; /*!< Edges */
+    svo_gng_eu_kernel_t kernel; /*!< Vector kernels bound once for
+                                     params.dim and the CPU */
+    svo_sampler_t sampler; /*!< Built-in input signals, if set
+                                ops.input_signal isn't used */
+
+    svo_stats_t stats; /*!< Time spent in phases of learning (filled only
+                            if compiled with SVO_STATS) */
+    svo_rng_t rng;     /*!< Generator seeded by params.seed */
+    svo_parallel_pool_t *workers; /*!< params.num_threads persistent
+                                       workers */
+
+    svo_gng_eu_node_t **batch_win; /*!< Two winners per signal of batch */
+    size_t batch_win_size;         /*!< Allocated number of signals */
+    svo_gng_eu_node_t **batch_del; /*!< Nodes that became isolated during
+                                        batch (may contain duplicates) */
+    size_t batch_del_len, batch_del_size;
+
     bor_vec_t *tmpv;
 };
 typedef struct _svo_gng_eu_t svo_gng_eu_t;
@@ -193,13 +338,29 @@ svo_gng_eu_t *svoGNGEuNew(const svo_gng_eu_ops_t *ops,
  */
 void svoGNGEuDel(svo_gng_eu_t *gng_eu);
 
+/**
+ * Sets points of point cloud as input signals, i.e., GNGEu will sample
+ * them itself and ops.input_signal won't be called.
+ * Points aren't copied, so {pc} must not be changed or deleted while
+ * GNGEu is in use. Dimension of {pc} must be params.dim.
+ */
+void svoGNGEuInputSignalsPC(svo_gng_eu_t *gng_eu, bor_pc_t *pc);
+
+/**
+ * Same as svoGNGEuInputSignalsPC() but input signals are taken from
+ * array of {len} vectors of params.dim reals stored one after another.
+ * The array isn't copied.
+ */
+void svoGNGEuInputSignalsArr(svo_gng_eu_t *gng_eu,
+                             const bor_real_t *arr, size_t len);
+
 /**
  * Runs GNGEu algorithm.
  *
  * This runs whole algorithm in loop until operation terminate() returns
  * true:
  * ~~~~~~
- * svoGNGEuinit()
+ * svoGNGEuinit()   (unless net was restored by svoGNGEuLoad())
  * do:
  *     for (step = 1 .. params.lambda):
  *         svoGNGEuLearn()
@@ -216,10 +377,10 @@ void svoGNGEuRun(svo_gng_eu_t *gng_eu);
  * if ops.init != NULL:
  *     ops.init()
  * else:
- *     is = ops.input_signal()
+ *     is = input signal
  *     n1 = ops.new_node(is)
  *
- *     is = ops.input_signal()
+ *     is = input signal
  *     n2 = ops.new_node(is)
  * create edge between n1 and n2
  */
@@ -230,6 +391,44 @@ void svoGNGEuInit(svo_gng_eu_t *gng_eu);
  */
 void svoGNGEuLearn(svo_gng_eu_t *gng_eu);
 
+/**
+ * Performs {k} competitive hebbian learning steps, one for each of given
+ * input signals.
+ *
+ * First, two nearest nodes are found for all signals against the net as
+ * it is at the beginning of the batch. This phase only queries nearest
+ * neighbor structure and runs in params.num_threads persistent workers
+ * of {gng_eu}, so no threads are created per batch.
+ * Then hebbian learning, error accumulation and adaptation of nodes are
+ * applied serially in signal order exactly as svoGNGEuLearn() does.
+ * Nodes that become isolated are not removed until the end of the batch
+ * (unless they are connected again meanwhile), so all winners found in
+ * the first phase stay valid.
+ *
+ * Steps are counted as in svoGNGEuLearn(), so calling this with
+ * k == params.lambda followed by svoGNGEuNewNode() corresponds to one
+ * cycle of svoGNGEuRun().
+ */
+void svoGNGEuLearnBatch(svo_gng_eu_t *gng_eu,
+                        const bor_vec_t **signals, size_t k);
+
+/**
+ * Assigns each of {len} points (stored one after another in {points},
+ * params.dim reals each) to its nearest node.
+ * Dense id (svo_gng_eu_node_t.id) of nearest node of i'th point is
+ * stored in {winners}[i], id of the second nearest one in {second}[i]
+ * (-1 if net has only one node) and squared distance to the nearest node
+ * in {dist2}[i]. {second} and {dist2} may be NULL.
+ * If the net is empty, all {winners} and {second} are set to -1 and all
+ * {dist2} to BOR_REAL_MAX.
+ * Points are split between params.num_threads persistent workers
+ * (started by svoGNGEuNew()) which only query the net, so the net must
+ * not be changed meanwhile.
+ */
+void svoGNGEuQuantize(svo_gng_eu_t *gng_eu, const bor_real_t *points,
+                      size_t len, int *winners, int *second,
+                      bor_real_t *dist2);
+
 /**
  * Creates new node in place with highest error counter.
  */
@@ -259,6 +458,36 @@ void svoGNGEuNodeWithHighestError2(svo_gng_eu_t *gng_eu,
 
 void svoGNGEuDumpSVT(svo_gng_eu_t *gng_eu, FILE *out, const char *name);
 
+/**
+ * Writes binary snapshot of complete training state (learning
+ * parameters, error counters, nodes, edges with their ages, state of
+ * generator svoGNGEuRng() and position of built-in sampler) into {fout}.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoGNGEuSave(svo_gng_eu_t *gng_eu, FILE *fout);
+
+/**
+ * Restores training state from snapshot written by svoGNGEuSave().
+ * The current net is thrown away. The same input signals (if built-in
+ * sampler is used) must be already set and {gng_eu} must have the same
+ * params.dim. svoGNGEuRun() then continues where the saved run stopped
+ * and it produces the same net as the uninterrupted run would.
+ * Nodes are given new dense ids (svo_gng_eu_node_t.id).
+ * Whole snapshot is read and checked before {gng_eu} is changed, so if
+ * it fails, {gng_eu} (including its net) is left as it was.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoGNGEuLoad(svo_gng_eu_t *gng_eu, FILE *fin);
+
+/**
+ * Exports trained net into read-only model file {fn} (see svo_model_t)
+ * which holds only weight vectors, adjacency of nodes and prebuilt
+ * kd-tree for nearest node search. Nodes in the model are numbered in
+ * order of the kd-tree.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoGNGEuExportModel(svo_gng_eu_t *gng_eu, const char *fn);
+
 
 /**
  * Net Related API
@@ -293,6 +522,23 @@ _bor_inline bor_list_t *svoGNGEuNodes(svo_gng_eu_t *gng_eu);
  */
 _bor_inline size_t svoGNGEuEdgesLen(const svo_gng_eu_t *gng_eu);
 
+/**
+ * Returns statistics of phases of learning (see gng/stats.h).
+ */
+_bor_inline const svo_stats_t *svoGNGEuStats(const svo_gng_eu_t *gng_eu);
+
+/**
+ * Zeroes statistics of phases of learning.
+ */
+_bor_inline void svoGNGEuStatsReset(svo_gng_eu_t *gng_eu);
+
+/**
+ * Returns random generator of the instance seeded by params.seed.
+ * It is meant for user's ops (e.g., ops.input_signal) so that whole run
+ * is reproducible.
+ */
+_bor_inline svo_rng_t *svoGNGEuRng(svo_gng_eu_t *gng_eu);
+
 /**
  * Returns list of nodes
  */
@@ -365,9 +611,10 @@ _bor_inline void svoGNGEuNodeRemove(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n);
 _bor_inline void svoGNGEuNodeDel(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n);
 
 /**
- * Fixes node's error counter, i.e. applies correct beta^(n * lambda)
+ * Returns node's error counter.
  */
-_bor_inline void svoGNGEuNodeFixError(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n);
+_bor_inline bor_real_t svoGNGEuNodeErr(const svo_gng_eu_t *gng_eu,
+                                       const svo_gng_eu_node_t *n);
 
 /**
  * Increment error counter
@@ -380,6 +627,18 @@ _bor_inline void svoGNGEuNodeIncError(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n
 _bor_inline void svoGNGEuNodeScaleError(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n,
                                       bor_real_t scale);
 
+/**
+ * Decreases error counters of all nodes by factor beta in O(1).
+ */
+_bor_inline void svoGNGEuDecreaseErrCounters(svo_gng_eu_t *gng_eu);
+
+/**
+ * Propagates changed node's error counter into error heap/tree, for
+ * internal use.
+ */
+_bor_inline void __svoGNGEuNodeErrUpdate(svo_gng_eu_t *gng_eu,
+                                         svo_gng_eu_node_t *n);
+
 /**
  * Disconnects node from net, i.e., deletes all incidenting edges.
  */
@@ -419,6 +678,11 @@ void svoGNGEuEdgeDel(svo_gng_eu_t *gng_eu, svo_gng_eu_edge_t *edge);
  */
 _bor_inline int svoGNGEuEdgeAge(const svo_gng_eu_t *gng_eu, const svo_gng_eu_edge_t *edge);
 
+/**
+ * Sets age of edge to zero.
+ */
+_bor_inline void svoGNGEuEdgeAgeReset(svo_gng_eu_t *gng_eu, svo_gng_eu_edge_t *edge);
+
 
 /**
  * Returns edge connecting {n1} and {n2}.
@@ -444,6 +708,15 @@ _bor_inline void svoGNGEuEdgeNodes(svo_gng_eu_edge_t *e,
 
 
 /**** INLINES ****/
+_bor_inline bor_vec_t *svoGNGEuWeightsGet(const svo_gng_eu_weights_t *ws,
+                                          int id)
+{
+    bor_real_t *block;
+
+    block = ws->blocks[id >> SVO_GNG_EU_WEIGHTS_BLOCK_SHIFT];
+    return block + (id & (SVO_GNG_EU_WEIGHTS_BLOCK - 1)) * ws->stride;
+}
+
 _bor_inline bor_net_t *svoGNGEuNet(svo_gng_eu_t *gng_eu)
 {
     return gng_eu->net;
@@ -459,6 +732,21 @@ _bor_inline size_t svoGNGEuNodesLen(const svo_gng_eu_t *gng_eu)
     return borNetNodesLen(gng_eu->net);
 }
 
+_bor_inline const svo_stats_t *svoGNGEuStats(const svo_gng_eu_t *gng_eu)
+{
+    return &gng_eu->stats;
+}
+
+_bor_inline void svoGNGEuStatsReset(svo_gng_eu_t *gng_eu)
+{
+    svoStatsReset(&gng_eu->stats);
+}
+
+_bor_inline svo_rng_t *svoGNGEuRng(svo_gng_eu_t *gng_eu)
+{
+    return &gng_eu->rng;
+}
+
 _bor_inline bor_list_t *svoGNGEuEdges(svo_gng_eu_t *gng_eu)
 {
     return borNetEdges(gng_eu->net);
@@ -514,13 +802,23 @@ _bor_inline bor_net_edge_t *svoGNGEuEdgeToNet(svo_gng_eu_edge_t *e)
 _bor_inline void svoGNGEuNodeAdd(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n,
                                  const bor_vec_t *w)
 {
-    n->err       = BOR_ZERO;
-    n->err_cycle = gng_eu->cycle;
-    borPairHeapAdd(gng_eu->err_heap, &n->err_heap);
+    n->err = BOR_ZERO;
+    if (gng_eu->params.err_index == SVO_ERR_INDEX_TREE){
+        svoErrTreeAdd(&gng_eu->err_tree, &n->err_tree, n->err);
+    }else{
+        borPairHeapAdd(gng_eu->err_heap, &n->err_heap);
+    }
+
+    n->wins = 0L;
+    svoAdjInit(&n->adj);
 
     borNetAddNode(gng_eu->net, &n->node);
 
-    if (gng_eu->params.dim == 2){
+    n->id = svoGNGEuWeightsAlloc(&gng_eu->weights);
+    if (gng_eu->params.dense_weights){
+        n->w = svoGNGEuWeightsGet(&gng_eu->weights, n->id);
+        borVecCopy(gng_eu->params.dim, n->w, w);
+    }else if (gng_eu->params.dim == 2){
         n->w = (bor_vec_t *)borVec2Clone((const bor_vec2_t *)w);
     }else if (gng_eu->params.dim == 3){
         n->w = (bor_vec_t *)borVec3Clone((const bor_vec3_t *)w);
@@ -536,7 +834,11 @@ _bor_inline void svoGNGEuNodeAdd(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n,
 
 _bor_inline void svoGNGEuNodeRemove(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n)
 {
-    borPairHeapRemove(gng_eu->err_heap, &n->err_heap);
+    if (gng_eu->params.err_index == SVO_ERR_INDEX_TREE){
+        svoErrTreeRemove(&gng_eu->err_tree, &n->err_tree);
+    }else{
+        borPairHeapRemove(gng_eu->err_heap, &n->err_heap);
+    }
 
     if (borNetNodeEdgesLen(&n->node) != 0)
         svoGNGEuNodeDisconnect(gng_eu, n);
@@ -546,7 +848,12 @@ _bor_inline void svoGNGEuNodeRemove(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n)
         borNNRemove(gng_eu->nn, &n->nn);
     }
 
-    borVecDel(n->w);
+    if (!gng_eu->params.dense_weights)
+        borVecDel(n->w);
+    svoGNGEuWeightsRelease(&gng_eu->weights, n->id);
+
+    if (gng_eu->params.compact_adj)
+        svoAdjFree(&n->adj);
 }
 
 _bor_inline void svoGNGEuNodeDel(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n)
@@ -555,47 +862,65 @@ _bor_inline void svoGNGEuNodeDel(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n)
     if (gng_eu->ops.del_node){
         gng_eu->ops.del_node(n, gng_eu->ops.del_node_data);
     }else{
-        BOR_FREE(n);
+        svoPoolRelease(&gng_eu->node_pool, n);
     }
 }
 
-_bor_inline void svoGNGEuNodeFixError(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n)
+_bor_inline void __svoGNGEuNodeErrUpdate(svo_gng_eu_t *gng_eu,
+                                         svo_gng_eu_node_t *n)
 {
-    unsigned long diff;
-
-    diff = gng_eu->cycle - n->err_cycle;
-    if (diff > 0 && diff <= gng_eu->beta_lambda_n_len){
-        n->err *= gng_eu->beta_lambda_n[diff - 1];
-    }else if (diff > 0){
-        n->err *= gng_eu->beta_lambda_n[gng_eu->beta_lambda_n_len - 1];
-
-        diff = diff - gng_eu->beta_lambda_n_len;
-        n->err *= pow(gng_eu->beta_n[gng_eu->beta_lambda_n_len - 1], diff);
+    if (gng_eu->params.err_index == SVO_ERR_INDEX_TREE){
+        svoErrTreeUpdate(&gng_eu->err_tree, &n->err_tree, n->err);
+    }else{
+        borPairHeapUpdate(gng_eu->err_heap, &n->err_heap);
     }
-    n->err_cycle = gng_eu->cycle;
+}
+
+_bor_inline bor_real_t svoGNGEuNodeErr(const svo_gng_eu_t *gng_eu,
+                                       const svo_gng_eu_node_t *n)
+{
+    return n->err / gng_eu->err_scale;
 }
 
 _bor_inline void svoGNGEuNodeIncError(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n,
                                     bor_real_t inc)
 {
-    svoGNGEuNodeFixError(gng_eu, n);
-    n->err += inc;
-    borPairHeapUpdate(gng_eu->err_heap, &n->err_heap);
+    n->err += inc * gng_eu->err_scale;
+    __svoGNGEuNodeErrUpdate(gng_eu, n);
 }
 
 _bor_inline void svoGNGEuNodeScaleError(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n,
                                       bor_real_t scale)
 {
-    svoGNGEuNodeFixError(gng_eu, n);
     n->err *= scale;
-    borPairHeapUpdate(gng_eu->err_heap, &n->err_heap);
+    __svoGNGEuNodeErrUpdate(gng_eu, n);
+}
+
+void __svoGNGEuErrRenormalise(svo_gng_eu_t *gng_eu);
+_bor_inline void svoGNGEuDecreaseErrCounters(svo_gng_eu_t *gng_eu)
+{
+    gng_eu->err_scale *= gng_eu->err_scale_inc;
+    if (bor_unlikely(gng_eu->err_scale > SVO_GNG_EU_ERR_SCALE_MAX))
+        __svoGNGEuErrRenormalise(gng_eu);
 }
 
 
 
 _bor_inline int svoGNGEuEdgeAge(const svo_gng_eu_t *gng_eu, const svo_gng_eu_edge_t *edge)
 {
-    return edge->age;
+    svo_gng_eu_node_t *n1, *n2;
+
+    // edge gets one year older each time one of its nodes wins
+    svoGNGEuEdgeNodes((svo_gng_eu_edge_t *)edge, &n1, &n2);
+    return (int)(n1->wins + n2->wins - edge->age_base);
+}
+
+_bor_inline void svoGNGEuEdgeAgeReset(svo_gng_eu_t *gng_eu, svo_gng_eu_edge_t *edge)
+{
+    svo_gng_eu_node_t *n1, *n2;
+
+    svoGNGEuEdgeNodes(edge, &n1, &n2);
+    edge->age_base = n1->wins + n2->wins;
 }
 
 _bor_inline svo_gng_eu_edge_t *svoGNGEuEdgeBetween(svo_gng_eu_t *gng_eu,
@@ -605,6 +930,12 @@ _bor_inline svo_gng_eu_edge_t *svoGNGEuEdgeBetween(svo_gng_eu_t *gng_eu,
     bor_net_edge_t *ne;
     svo_gng_eu_edge_t *e = NULL;
 
+    if (gng_eu->params.edge_hash)
+        return (svo_gng_eu_edge_t *)svoEdgeHashFind(&gng_eu->edge_hash,
+                                                    n1->id, n2->id);
+    if (gng_eu->params.compact_adj)
+        return (svo_gng_eu_edge_t *)svoAdjFind(&n1->adj, n2->id);
+
     ne = borNetNodeCommonEdge(&n1->node, &n2->node);
     if (ne)
         e  = bor_container_of(ne, svo_gng_eu_edge_t, edge);
@@ -17,7 +17,11 @@
 #ifndef __SVO_GNG_T_H__
 #define __SVO_GNG_T_H__
 
+#include <stdio.h>
 #include <boruvka/net.h>
+#include <gng/pool.h>
+#include <gng/stats.h>
+#include <gng/rng.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,6 +43,7 @@ struct _svo_gngt_node_t {
 
     bor_real_t err; /*!< Overall error */
     int won;        /*!< True if node has won in last epoch */
+    unsigned long wins; /*!< Number of times node was a winner */
 };
 typedef struct _svo_gngt_node_t svo_gngt_node_t;
 
@@ -46,7 +51,8 @@ typedef struct _svo_gngt_node_t svo_gngt_node_t;
 struct _svo_gngt_edge_t {
     bor_net_edge_t edge;
 
-    int age;
+    unsigned long age_base; /*!< Sum of .wins of both nodes when edge was
+                                 created or refreshed, use svoGNGTEdgeAge() */
 };
 typedef struct _svo_gngt_edge_t svo_gngt_edge_t;
 
@@ -117,12 +123,53 @@ typedef void (*svo_gngt_move_towards)(svo_gngt_node_t *node,
                                       bor_real_t fraction,
                                       void *);
 
+/**
+ * Optional batched version of input_signal: stores {k} random input
+ * signals into {is}. Without nearest_batch it is called with k = 1.
+ */
+typedef void (*svo_gngt_input_signal_batch)(const void **is, size_t k, void *);
+
+/**
+ * Optional batched version of nearest: for each of {k} input signals
+ * {is} stores first and second nearest node into n[2 * i] and
+ * n[2 * i + 1]. Net is not changed during the call, so signals can be
+ * processed in any order or in parallel.
+ */
+typedef void (*svo_gngt_nearest_batch)(const void **is, size_t k,
+                                       svo_gngt_node_t **n, void *);
+
+/**
+ * Optional replacement of move_towards for one learning step: moves
+ * {winner} towards input_signal by fraction {eb} and all {len} nodes in
+ * {neighbors} by fraction {en}.
+ */
+typedef void (*svo_gngt_move_towards_many)(svo_gngt_node_t *winner,
+                                           svo_gngt_node_t **neighbors,
+                                           size_t len,
+                                           const void *input_signal,
+                                           bor_real_t eb, bor_real_t en,
+                                           void *);
+
 /**
  * Returns true if algorithm should terminate.
  * This is called at the end of each epoch.
  */
 typedef int (*svo_gngt_terminate)(void *);
 
+/**
+ * Writes user's part of node (e.g., weight vector) into snapshot, see
+ * svoGNGTSave(). Returns 0 on success.
+ */
+typedef int (*svo_gngt_save_node)(const svo_gngt_node_t *n, FILE *fout,
+                                  void *);
+
+/**
+ * Reads user's part of node written by svo_gngt_save_node and returns
+ * new node created from it (the same way ops.new_node does), see
+ * svoGNGTLoad(). Returns NULL on error.
+ */
+typedef svo_gngt_node_t *(*svo_gngt_load_node)(FILE *fin, void *);
+
 /**
  * Callback that is peridically called from GNG-T.
  *
@@ -143,6 +190,17 @@ struct _svo_gngt_ops_t {
     svo_gngt_move_towards     move_towards;
     svo_gngt_terminate        terminate;
 
+    /* Batched operations, all optional (may be NULL). If input_signal_batch
+       or nearest_batch is set, svoGNGTRun() learns by svoGNGTAdaptBatch()
+       of params.lambda signals per cycle. If nearest_batch is set, all
+       signals of a batch are fetched before any of them is used, so
+       pointers returned by input_signal (input_signal_batch) must stay
+       valid for the whole batch, i.e., input_signal must not return
+       reused buffer. */
+    svo_gngt_input_signal_batch input_signal_batch;
+    svo_gngt_nearest_batch      nearest_batch;
+    svo_gngt_move_towards_many  move_towards_many;
+
     svo_gngt_callback callback;
     unsigned long callback_period;
 
@@ -157,6 +215,9 @@ struct _svo_gngt_ops_t {
     void *nearest_data;
     void *dist2_data;
     void *move_towards_data;
+    void *input_signal_batch_data;
+    void *nearest_batch_data;
+    void *move_towards_many_data;
     void *terminate_data;
     void *callback_data;
 };
@@ -180,6 +241,8 @@ struct _svo_gngt_params_t {
     bor_real_t en;     /*!< Winners' neighbors learning rate. Default: 0.0006 */
     int age_max;       /*!< Maximal age of edge. Default: 200 */
     bor_real_t target; /*!< Target average error. Default: 100 */
+    unsigned long seed; /*!< Seed of generator returned by svoGNGTRng().
+                             Default: 0 */
 };
 typedef struct _svo_gngt_params_t svo_gngt_params_t;
 
@@ -203,6 +266,22 @@ struct _svo_gngt_t {
     svo_gngt_params_t params;
 
     bor_real_t avg_err; /*!< Last computed average error */
+
+    svo_pool_t edge_pool; /*!< Edges */
+
+    const void **batch_is;       /*!< Input signals of batch */
+    svo_gngt_node_t **batch_win; /*!< Two winners per signal of batch */
+    size_t batch_size;           /*!< Allocated number of signals */
+    svo_gngt_node_t **batch_del; /*!< Nodes that became isolated during
+                                      batch (may contain duplicates) */
+    size_t batch_del_len, batch_del_size;
+    svo_gngt_node_t **neigh;     /*!< Neighbors of winner passed to
+                                      ops.move_towards_many */
+    size_t neigh_size;
+
+    svo_stats_t stats; /*!< Time spent in phases of learning (filled only
+                            if compiled with SVO_STATS) */
+    svo_rng_t rng;     /*!< Generator seeded by params.seed */
 };
 typedef struct _svo_gngt_t svo_gngt_t;
 
@@ -224,7 +303,7 @@ void svoGNGTDel(svo_gngt_t *gng);
  * This runs whole algorithm in loop until operation terminate() returns
  * true:
  * ~~~~~~
- * svoGNGTInit()
+ * svoGNGTInit()   (unless net was restored by svoGNGTLoad())
  * do:
  *     svoGNGTReset()
  *     for (step = 1 .. params.lambda):
@@ -272,12 +351,44 @@ void svoGNGTReset(svo_gngt_t *gng);
  */
 void svoGNGTAdapt(svo_gngt_t *gng);
 
+/**
+ * Performs {k} adaptation steps at once using batched operations, see
+ * svoGNGLearnBatch() for description.
+ */
+void svoGNGTAdaptBatch(svo_gngt_t *gng, size_t k);
+
 /**
  * Compares target error with average error and creates or deletes a node
  * according to it.
  */
 void svoGNGTGrowShrink(svo_gngt_t *gng);
 
+/**
+ * Writes binary snapshot of complete state of GNG-T (learning parameters,
+ * error counters, state of generator svoGNGTRng(), nodes and edges with
+ * their ages) into {fout}.
+ * Weight vectors live outside of GNG-T, so each node is followed by
+ * whatever {save_node} writes.
+ * Input signals are provided by ops.input_signal, so it is up to caller
+ * to store also their state (e.g., svoSamplerTell()) if the run should be
+ * resumed exactly.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoGNGTSave(svo_gngt_t *gng, FILE *fout,
+                svo_gngt_save_node save_node, void *data);
+
+/**
+ * Restores state of GNG-T from snapshot written by svoGNGTSave(), nodes
+ * are created by {load_node}. The current net is thrown away.
+ * svoGNGTRun() then continues with restored net.
+ * Whole snapshot is read and checked before {gng} is changed, so if it
+ * fails, {gng} (including its net) is left as it was and nodes already
+ * created by {load_node} are deleted by ops.del_node.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoGNGTLoad(svo_gngt_t *gng, FILE *fin,
+                svo_gngt_load_node load_node, void *data);
+
 /**
  * Returns last computed average error
  */
@@ -322,6 +433,24 @@ _bor_inline size_t svoGNGTEdgesLen(const svo_gngt_t *gng);
  */
 _bor_inline bor_list_t *svoGNGTEdges(svo_gngt_t *gng);
 
+/**
+ * Returns statistics of phases of learning (see gng/stats.h).
+ */
+_bor_inline const svo_stats_t *svoGNGTStats(const svo_gngt_t *gng);
+
+/**
+ * Zeroes statistics of phases of learning.
+ */
+_bor_inline void svoGNGTStatsReset(svo_gngt_t *gng);
+
+/**
+ * Returns random generator of the instance seeded by params.seed.
+ * GNG-T itself doesn't draw any random numbers, the generator is meant
+ * for user's ops (e.g., ops.input_signal) so that whole run is
+ * reproducible.
+ */
+_bor_inline svo_rng_t *svoGNGTRng(svo_gngt_t *gng);
+
 /**
  * Returns GNG node from list pointer.
  *
@@ -387,6 +516,12 @@ _bor_inline void svoGNGTNodeRemove(svo_gngt_t *gng, svo_gngt_node_t *n);
  */
 _bor_inline void svoGNGTNodeDel(svo_gngt_t *gng, svo_gngt_node_t *n);
 
+/**
+ * Postpones deletion of isolated node to the end of current batch
+ * (see svoGNGTAdaptBatch()).
+ */
+void svoGNGTNodeDelLater(svo_gngt_t *gng, svo_gngt_node_t *n);
+
 /**
  * Disconnects node from net, i.e., deletes all incidenting edges.
  */
@@ -426,6 +561,11 @@ void svoGNGTEdgeDel(svo_gngt_t *gng, svo_gngt_edge_t *edge);
  */
 _bor_inline int svoGNGTEdgeAge(const svo_gngt_t *gng, const svo_gngt_edge_t *edge);
 
+/**
+ * Sets age of edge to zero.
+ */
+_bor_inline void svoGNGTEdgeAgeReset(svo_gngt_t *gng, svo_gngt_edge_t *edge);
+
 
 /**
  * Returns edge connecting {n1} and {n2}.
@@ -440,6 +580,13 @@ _bor_inline svo_gngt_edge_t *svoGNGTEdgeBetween(svo_gngt_t *gng,
 void svoGNGTEdgeBetweenDel(svo_gngt_t *gng,
                            svo_gngt_node_t *n1, svo_gngt_node_t *n2);
 
+/**
+ * Performs hebbian learning between two given nodes - edge between them
+ * is either created or its age is set to zero.
+ */
+void svoGNGTHebbianLearning(svo_gngt_t *gng,
+                            svo_gngt_node_t *n1, svo_gngt_node_t *n2);
+
 /**
  * Returns (via {n1} and {n2}) incidenting nodes of edge
  */
@@ -481,6 +628,21 @@ _bor_inline size_t svoGNGTEdgesLen(const svo_gngt_t *gng)
     return borNetEdgesLen(gng->net);
 }
 
+_bor_inline const svo_stats_t *svoGNGTStats(const svo_gngt_t *gng)
+{
+    return &gng->stats;
+}
+
+_bor_inline void svoGNGTStatsReset(svo_gngt_t *gng)
+{
+    svoStatsReset(&gng->stats);
+}
+
+_bor_inline svo_rng_t *svoGNGTRng(svo_gngt_t *gng)
+{
+    return &gng->rng;
+}
+
 _bor_inline svo_gngt_node_t *svoGNGTNodeFromList(bor_list_t *item)
 {
     bor_net_node_t *nn;
@@ -527,6 +689,7 @@ _bor_inline void svoGNGTNodeAdd(svo_gngt_t *gng, svo_gngt_node_t *n)
 {
     n->err = BOR_ZERO;
     n->won = 0;
+    n->wins = 0L;
     borNetAddNode(gng->net, &n->node);
 }
 
@@ -546,7 +709,19 @@ _bor_inline void svoGNGTNodeDel(svo_gngt_t *gng, svo_gngt_node_t *n)
 
 _bor_inline int svoGNGTEdgeAge(const svo_gngt_t *gng, const svo_gngt_edge_t *edge)
 {
-    return edge->age;
+    svo_gngt_node_t *n1, *n2;
+
+    // edge gets one year older each time one of its nodes wins
+    svoGNGTEdgeNodes((svo_gngt_edge_t *)edge, &n1, &n2);
+    return (int)(n1->wins + n2->wins - edge->age_base);
+}
+
+_bor_inline void svoGNGTEdgeAgeReset(svo_gngt_t *gng, svo_gngt_edge_t *edge)
+{
+    svo_gngt_node_t *n1, *n2;
+
+    svoGNGTEdgeNodes(edge, &n1, &n2);
+    edge->age_base = n1->wins + n2->wins;
 }
 
 _bor_inline svo_gngt_edge_t *svoGNGTEdgeBetween(svo_gngt_t *gng,
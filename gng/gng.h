@@ -19,6 +19,9 @@
 
 #include <boruvka/net.h>
 #include <boruvka/pairheap.h>
+#include <gng/pool.h>
+#include <gng/stats.h>
+#include <gng/err-scale.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -71,9 +74,12 @@ extern "C" {
 struct _svo_gng_node_t {
     bor_net_node_t node;
 
-    bor_real_t err;               /*!< Overall error */
-    unsigned long err_cycle;      /*!< Last cycle in which were .err changed */
+    bor_real_t err;               /*!< Overall error multiplied by
+                                       svo_gng_t's .err_scale, use
+                                       svoGNGNodeErr() */
     bor_pairheap_node_t err_heap; /*!< Connection to error heap */
+
+    unsigned long wins; /*!< Number of times node was a winner */
 };
 typedef struct _svo_gng_node_t svo_gng_node_t;
 
@@ -81,7 +87,8 @@ typedef struct _svo_gng_node_t svo_gng_node_t;
 struct _svo_gng_edge_t {
     bor_net_edge_t edge;
 
-    int age;
+    unsigned long age_base; /*!< Sum of .wins of both nodes when edge was
+                                 created or refreshed, use svoGNGEdgeAge() */
 };
 typedef struct _svo_gng_edge_t svo_gng_edge_t;
 
@@ -152,6 +159,33 @@ typedef void (*svo_gng_move_towards)(svo_gng_node_t *node,
                                      bor_real_t fraction,
                                      void *);
 
+/**
+ * Optional batched version of input_signal: stores {k} random input
+ * signals into {is}. Without nearest_batch it is called with k = 1.
+ */
+typedef void (*svo_gng_input_signal_batch)(const void **is, size_t k, void *);
+
+/**
+ * Optional batched version of nearest: for each of {k} input signals
+ * {is} stores first and second nearest node into n[2 * i] and
+ * n[2 * i + 1]. Net is not changed during the call, so signals can be
+ * processed in any order or in parallel.
+ */
+typedef void (*svo_gng_nearest_batch)(const void **is, size_t k,
+                                      svo_gng_node_t **n, void *);
+
+/**
+ * Optional replacement of move_towards for one learning step: moves
+ * {winner} towards input_signal by fraction {eb} and all {len} nodes in
+ * {neighbors} by fraction {en}.
+ */
+typedef void (*svo_gng_move_towards_many)(svo_gng_node_t *winner,
+                                          svo_gng_node_t **neighbors,
+                                          size_t len,
+                                          const void *input_signal,
+                                          bor_real_t eb, bor_real_t en,
+                                          void *);
+
 /**
  * Returns true if algorithm should terminate.
  */
@@ -177,6 +211,17 @@ struct _svo_gng_ops_t {
     svo_gng_move_towards     move_towards;
     svo_gng_terminate        terminate;
 
+    /* Batched operations, all optional (may be NULL). If input_signal_batch
+       or nearest_batch is set, svoGNGRun() learns by svoGNGLearnBatch()
+       of params.lambda signals per cycle. If nearest_batch is set, all
+       signals of a batch are fetched before any of them is used, so
+       pointers returned by input_signal (input_signal_batch) must stay
+       valid for the whole batch, i.e., input_signal must not return
+       reused buffer. */
+    svo_gng_input_signal_batch input_signal_batch;
+    svo_gng_nearest_batch      nearest_batch;
+    svo_gng_move_towards_many  move_towards_many;
+
     svo_gng_callback callback;
     unsigned long callback_period;
 
@@ -191,6 +236,9 @@ struct _svo_gng_ops_t {
     void *nearest_data;
     void *dist2_data;
     void *move_towards_data;
+    void *input_signal_batch_data;
+    void *nearest_batch_data;
+    void *move_towards_many_data;
     void *terminate_data;
     void *callback_data;
 };
@@ -232,6 +280,12 @@ void svoGNGParamsInit(svo_gng_params_t *params);
  * See svo_gng_t.
  */
 
+/**
+ * Limit of common factor of error counters (svo_gng_t's .err_scale), see
+ * gng/err-scale.h.
+ */
+#define SVO_GNG_ERR_SCALE_MAX SVO_ERR_SCALE_MAX
+
 struct _svo_gng_t {
     bor_net_t *net;
     bor_pairheap_t *err_heap;
@@ -239,12 +293,26 @@ struct _svo_gng_t {
     svo_gng_ops_t ops;
     svo_gng_params_t params;
 
-    bor_real_t *beta_n; /*!< Precomputed beta^n for n = 1, ..., lambda */
-    bor_real_t *beta_lambda_n; /*!< Precomputed beta^(n*lambda) */
-    size_t beta_lambda_n_len;
+    bor_real_t err_scale;     /*!< Common factor of all error counters */
+    bor_real_t err_scale_inc; /*!< 1 / beta */
 
     size_t step;
     unsigned long cycle;
+
+    svo_pool_t edge_pool; /*!< Edges */
+
+    const void **batch_is;      /*!< Input signals of batch */
+    svo_gng_node_t **batch_win; /*!< Two winners per signal of batch */
+    size_t batch_size;          /*!< Allocated number of signals */
+    svo_gng_node_t **batch_del; /*!< Nodes that became isolated during
+                                     batch (may contain duplicates) */
+    size_t batch_del_len, batch_del_size;
+    svo_gng_node_t **neigh;     /*!< Neighbors of winner passed to
+                                     ops.move_towards_many */
+    size_t neigh_size;
+
+    svo_stats_t stats; /*!< Time spent in phases of learning (filled only
+                            if compiled with SVO_STATS) */
 };
 typedef struct _svo_gng_t svo_gng_t;
 
@@ -297,6 +365,24 @@ void svoGNGInit(svo_gng_t *gng);
  */
 void svoGNGLearn(svo_gng_t *gng);
 
+/**
+ * Performs {k} learning steps at once using batched operations.
+ *
+ * If ops.nearest_batch is set, all {k} input signals are obtained first
+ * by ops.input_signal_batch (or {k} times ops.input_signal), so they must
+ * stay valid until the end of the batch. Winners of all signals are then
+ * found by one call against the net as it is at the beginning of the
+ * batch and learning steps are applied in signal order. Nodes that become
+ * isolated are not removed until the end of the batch (unless they are
+ * connected again meanwhile), so all winners stay valid.
+ *
+ * Without ops.nearest_batch each signal is obtained (by
+ * ops.input_signal_batch with k = 1 or by ops.input_signal) only after
+ * the previous one was applied, so with ops.input_signal the steps are
+ * the same as {k} calls of svoGNGLearn().
+ */
+void svoGNGLearnBatch(svo_gng_t *gng, size_t k);
+
 /**
  * Creates new node in place with highest error counter.
  */
@@ -364,6 +450,16 @@ _bor_inline size_t svoGNGEdgesLen(const svo_gng_t *gng);
  */
 _bor_inline bor_list_t *svoGNGEdges(svo_gng_t *gng);
 
+/**
+ * Returns statistics of phases of learning (see gng/stats.h).
+ */
+_bor_inline const svo_stats_t *svoGNGStats(const svo_gng_t *gng);
+
+/**
+ * Zeroes statistics of phases of learning.
+ */
+_bor_inline void svoGNGStatsReset(svo_gng_t *gng);
+
 /**
  * Returns GNG node from list pointer.
  *
@@ -430,9 +526,10 @@ _bor_inline void svoGNGNodeRemove(svo_gng_t *gng, svo_gng_node_t *n);
 _bor_inline void svoGNGNodeDel(svo_gng_t *gng, svo_gng_node_t *n);
 
 /**
- * Fixes node's error counter, i.e. applies correct beta^(n * lambda)
+ * Returns node's error counter.
  */
-_bor_inline void svoGNGNodeFixError(svo_gng_t *gng, svo_gng_node_t *n);
+_bor_inline bor_real_t svoGNGNodeErr(const svo_gng_t *gng,
+                                     const svo_gng_node_t *n);
 
 /**
  * Increment error counter
@@ -445,11 +542,22 @@ _bor_inline void svoGNGNodeIncError(svo_gng_t *gng, svo_gng_node_t *n,
 _bor_inline void svoGNGNodeScaleError(svo_gng_t *gng, svo_gng_node_t *n,
                                       bor_real_t scale);
 
+/**
+ * Decreases error counters of all nodes by factor beta in O(1).
+ */
+_bor_inline void svoGNGDecreaseErrCounters(svo_gng_t *gng);
+
 /**
  * Disconnects node from net, i.e., deletes all incidenting edges.
  */
 void svoGNGNodeDisconnect(svo_gng_t *gng, svo_gng_node_t *n);
 
+/**
+ * Postpones deletion of isolated node to the end of current batch
+ * (see svoGNGLearnBatch()).
+ */
+void svoGNGNodeDelLater(svo_gng_t *gng, svo_gng_node_t *n);
+
 /**
  * Connects new node at given position (is) and connects it with two
  * nearest nodes [ops.new_node(), ops.nearest()].
@@ -484,6 +592,11 @@ void svoGNGEdgeDel(svo_gng_t *gng, svo_gng_edge_t *edge);
  */
 _bor_inline int svoGNGEdgeAge(const svo_gng_t *gng, const svo_gng_edge_t *edge);
 
+/**
+ * Sets age of edge to zero.
+ */
+_bor_inline void svoGNGEdgeAgeReset(svo_gng_t *gng, svo_gng_edge_t *edge);
+
 
 /**
  * Returns edge connecting {n1} and {n2}.
@@ -534,6 +647,16 @@ _bor_inline size_t svoGNGEdgesLen(const svo_gng_t *gng)
     return borNetEdgesLen(gng->net);
 }
 
+_bor_inline const svo_stats_t *svoGNGStats(const svo_gng_t *gng)
+{
+    return &gng->stats;
+}
+
+_bor_inline void svoGNGStatsReset(svo_gng_t *gng)
+{
+    svoStatsReset(&gng->stats);
+}
+
 _bor_inline svo_gng_node_t *svoGNGNodeFromList(bor_list_t *item)
 {
     bor_net_node_t *nn;
@@ -578,10 +701,11 @@ _bor_inline bor_net_edge_t *svoGNGEdgeToNet(svo_gng_edge_t *e)
 
 _bor_inline void svoGNGNodeAdd(svo_gng_t *gng, svo_gng_node_t *n)
 {
-    n->err       = BOR_ZERO;
-    n->err_cycle = gng->cycle;
+    n->err = BOR_ZERO;
     borPairHeapAdd(gng->err_heap, &n->err_heap);
 
+    n->wins = 0L;
+
     borNetAddNode(gng->net, &n->node);
 }
 
@@ -600,43 +724,51 @@ _bor_inline void svoGNGNodeDel(svo_gng_t *gng, svo_gng_node_t *n)
     gng->ops.del_node(n, gng->ops.del_node_data);
 }
 
-_bor_inline void svoGNGNodeFixError(svo_gng_t *gng, svo_gng_node_t *n)
+_bor_inline bor_real_t svoGNGNodeErr(const svo_gng_t *gng,
+                                     const svo_gng_node_t *n)
 {
-    unsigned long diff;
-
-    diff = gng->cycle - n->err_cycle;
-    if (diff > 0 && diff <= gng->beta_lambda_n_len){
-        n->err *= gng->beta_lambda_n[diff - 1];
-    }else if (diff > 0){
-        n->err *= gng->beta_lambda_n[gng->beta_lambda_n_len - 1];
-
-        diff = diff - gng->beta_lambda_n_len;
-        n->err *= pow(gng->beta_n[gng->beta_lambda_n_len - 1], diff);
-    }
-    n->err_cycle = gng->cycle;
+    return n->err / gng->err_scale;
 }
 
 _bor_inline void svoGNGNodeIncError(svo_gng_t *gng, svo_gng_node_t *n,
                                     bor_real_t inc)
 {
-    svoGNGNodeFixError(gng, n);
-    n->err += inc;
+    n->err += inc * gng->err_scale;
     borPairHeapUpdate(gng->err_heap, &n->err_heap);
 }
 
 _bor_inline void svoGNGNodeScaleError(svo_gng_t *gng, svo_gng_node_t *n,
                                       bor_real_t scale)
 {
-    svoGNGNodeFixError(gng, n);
     n->err *= scale;
     borPairHeapUpdate(gng->err_heap, &n->err_heap);
 }
 
+void __svoGNGErrRenormalise(svo_gng_t *gng);
+_bor_inline void svoGNGDecreaseErrCounters(svo_gng_t *gng)
+{
+    gng->err_scale *= gng->err_scale_inc;
+    if (bor_unlikely(gng->err_scale > SVO_GNG_ERR_SCALE_MAX))
+        __svoGNGErrRenormalise(gng);
+}
+
 
 
 _bor_inline int svoGNGEdgeAge(const svo_gng_t *gng, const svo_gng_edge_t *edge)
 {
-    return edge->age;
+    svo_gng_node_t *n1, *n2;
+
+    // edge gets one year older each time one of its nodes wins
+    svoGNGEdgeNodes((svo_gng_edge_t *)edge, &n1, &n2);
+    return (int)(n1->wins + n2->wins - edge->age_base);
+}
+
+_bor_inline void svoGNGEdgeAgeReset(svo_gng_t *gng, svo_gng_edge_t *edge)
+{
+    svo_gng_node_t *n1, *n2;
+
+    svoGNGEdgeNodes(edge, &n1, &n2);
+    edge->age_base = n1->wins + n2->wins;
 }
 
 _bor_inline svo_gng_edge_t *svoGNGEdgeBetween(svo_gng_t *gng,
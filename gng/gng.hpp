@@ -0,0 +1,442 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#ifndef __SVO_GNG_HPP__
+#define __SVO_GNG_HPP__
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <gng/gng-algorithm.h>
+
+/**
+ * C++ Growing Neural Gas
+ * =======================
+ *
+ * Header-only C++17 layer over svo_gng_t. Operations are given by static
+ * members of {Traits} and learning runs through __svoGNGLearn() (see
+ * gng/gng-algorithm.h) with them as direct calls, so neither void *
+ * nor function pointers stand between the algorithm and user's distance
+ * and move, and the compiler is free to inline and fuse them.
+ *
+ * Traits must provide:
+ * ~~~~~~
+ * struct Traits {
+ *     using node_type   = ...; // per-node data, default constructible
+ *     using weight_type = ...; // weight of node, input signals are of
+ *                              // the same type
+ *
+ *     static weight_type &weight(node_type &n);
+ *     static const weight_type &weight(const node_type &n);
+ *
+ *     // squared distance between two weights
+ *     static bor_real_t dist2(const weight_type &a, const weight_type &b);
+ *
+ *     // w = w + fraction * (is - w)
+ *     static void move(weight_type &w, const weight_type &is,
+ *                      bor_real_t fraction);
+ * };
+ * ~~~~~~
+ * New node between two nodes is placed at the half way between them
+ * (Traits::move() with fraction 0.5).
+ *
+ * {Index} is nearest neighbor search structure over nodes
+ * (svo::GngNode<Traits>), it must provide:
+ * ~~~~~~
+ * void add(GngNode<Traits> *n);
+ * void remove(GngNode<Traits> *n);
+ * void update(GngNode<Traits> *n); // called after n was moved
+ * void nearest(const weight_type &is,
+ *              GngNode<Traits> **n1, GngNode<Traits> **n2);
+ * ~~~~~~
+ * svo::GngLinearIndex is used by default.
+ *
+ * {Alloc} is standard allocator used for nodes (it is rebound to
+ * GngNode<Traits>), edges are still allocated from svo_gng_t's pool.
+ *
+ * Example:
+ * ~~~~~~
+ * svo::Gng<Traits> gng;
+ * gng.run([&]{ return randomSignal(); },
+ *         [](const auto &g){ return g.nodesLen() >= 1000; });
+ * gng.forEachNode([](const Traits::node_type &n){ ... });
+ * ~~~~~~
+ */
+
+namespace svo {
+
+/**
+ * Node of the net: svo_gng_node_t followed by user's data.
+ */
+template <typename Traits>
+struct GngNode {
+    svo_gng_node_t gng; /*!< Must stay first member */
+    typename Traits::node_type value;
+};
+
+/**
+ * Nearest neighbor search by linear scan over all nodes.
+ */
+template <typename Traits>
+class GngLinearIndex {
+  public:
+    using node_type   = GngNode<Traits>;
+    using weight_type = typename Traits::weight_type;
+
+    void add(node_type *n)
+    {
+        nodes_.push_back(n);
+    }
+
+    void remove(node_type *n)
+    {
+        for (std::size_t i = 0; i < nodes_.size(); ++i){
+            if (nodes_[i] == n){
+                nodes_[i] = nodes_.back();
+                nodes_.pop_back();
+                break;
+            }
+        }
+    }
+
+    void update(node_type *)
+    {
+    }
+
+    void nearest(const weight_type &is, node_type **n1, node_type **n2)
+    {
+        bor_real_t d, d1, d2;
+
+        *n1 = *n2 = nullptr;
+        d1 = d2 = BOR_REAL_MAX;
+        for (node_type *n : nodes_){
+            d = Traits::dist2(is, Traits::weight(n->value));
+            if (d < d1){
+                *n2 = *n1;
+                d2  = d1;
+                *n1 = n;
+                d1  = d;
+            }else if (d < d2){
+                *n2 = n;
+                d2  = d;
+            }
+        }
+    }
+
+  private:
+    std::vector<node_type *> nodes_;
+};
+
+
+template <typename Traits,
+          typename Index = GngLinearIndex<Traits>,
+          typename Alloc = std::allocator<GngNode<Traits>>>
+class Gng {
+  public:
+    using node_type   = typename Traits::node_type;
+    using weight_type = typename Traits::weight_type;
+    using net_node_type = GngNode<Traits>;
+    using index_type  = Index;
+
+    /**
+     * Creates GNG with default parameters (see svoGNGParamsInit()).
+     */
+    explicit Gng(Index index = Index(), const Alloc &alloc = Alloc())
+        : index_(std::move(index)), alloc_(alloc)
+    {
+        svo_gng_params_t params;
+
+        svoGNGParamsInit(&params);
+        create(params);
+    }
+
+    explicit Gng(const svo_gng_params_t &params,
+                 Index index = Index(), const Alloc &alloc = Alloc())
+        : index_(std::move(index)), alloc_(alloc)
+    {
+        create(params);
+    }
+
+    ~Gng()
+    {
+        svoGNGDel(gng_);
+    }
+
+    Gng(const Gng &) = delete;
+    Gng &operator=(const Gng &) = delete;
+
+    /**
+     * Creates the first two nodes at {a} and {b} (see svoGNGInit()).
+     */
+    void init(const weight_type &a, const weight_type &b)
+    {
+        init_[0] = &a;
+        init_[1] = &b;
+        svoGNGInit(gng_);
+    }
+
+    /**
+     * One learning step with input signal {is} (see svoGNGLearn()).
+     */
+    void learn(const weight_type &is)
+    {
+        is_ = &is;
+        __svoGNGLearn(gng_, opInputSignal, opNearest, opDist2,
+                      opMoveTowards, nullptr);
+    }
+
+    /**
+     * Creates new node (see svoGNGNewNode()).
+     */
+    void newNode()
+    {
+        svoGNGNewNode(gng_);
+    }
+
+    /**
+     * Runs whole algorithm (see svoGNGRun()): input signals are obtained
+     * by calling {source}() and learning stops once {terminate}(*this)
+     * returns true. If the net is empty, it is first initialized by
+     * two input signals.
+     */
+    template <typename Source, typename Terminate>
+    void run(Source &&source, Terminate &&terminate)
+    {
+        std::size_t i;
+
+        if (nodesLen() == 0){
+            weight_type a = source();
+            weight_type b = source();
+            init(a, b);
+        }
+
+        do {
+            for (i = 0; i < gng_->params.lambda; i++){
+                const weight_type &is = source();
+                learn(is);
+            }
+            newNode();
+        } while (!terminate(*this));
+    }
+
+    std::size_t nodesLen() const
+    {
+        return svoGNGNodesLen(gng_);
+    }
+
+    std::size_t edgesLen() const
+    {
+        return svoGNGEdgesLen(gng_);
+    }
+
+    /**
+     * Calls {f}(const node_type &) for each node.
+     */
+    template <typename F>
+    void forEachNode(F &&f) const
+    {
+        bor_list_t *list, *item;
+
+        list = svoGNGNodes(gng_);
+        BOR_LIST_FOR_EACH(list, item){
+            f(static_cast<const node_type &>(
+                    fromC(svoGNGNodeFromList(item))->value));
+        }
+    }
+
+    /**
+     * Calls {f}(const node_type &, const node_type &) for each edge.
+     */
+    template <typename F>
+    void forEachEdge(F &&f) const
+    {
+        bor_list_t *list, *item;
+        svo_gng_node_t *n1, *n2;
+
+        list = svoGNGEdges(gng_);
+        BOR_LIST_FOR_EACH(list, item){
+            svoGNGEdgeNodes(svoGNGEdgeFromList(item), &n1, &n2);
+            f(static_cast<const node_type &>(fromC(n1)->value),
+              static_cast<const node_type &>(fromC(n2)->value));
+        }
+    }
+
+    const svo_stats_t &stats() const
+    {
+        return *svoGNGStats(gng_);
+    }
+
+    Index &index()
+    {
+        return index_;
+    }
+
+    /**
+     * Underlying C structure.
+     */
+    svo_gng_t *c()
+    {
+        return gng_;
+    }
+
+  private:
+    using alloc_type = typename std::allocator_traits<Alloc>
+                            ::template rebind_alloc<net_node_type>;
+    using alloc_traits = std::allocator_traits<alloc_type>;
+
+    static_assert(std::is_standard_layout<net_node_type>::value,
+                  "Traits::node_type must be standard layout type");
+
+    static net_node_type *fromC(svo_gng_node_t *n)
+    {
+        // svo_gng_node_t is the first member of standard layout struct
+        return reinterpret_cast<net_node_type *>(n);
+    }
+
+    static const net_node_type *fromC(const svo_gng_node_t *n)
+    {
+        return reinterpret_cast<const net_node_type *>(n);
+    }
+
+    void create(const svo_gng_params_t &params)
+    {
+        svo_gng_ops_t ops;
+
+        svoGNGOpsInit(&ops);
+        ops.init             = opInit;
+        ops.new_node         = opNewNode;
+        ops.new_node_between = opNewNodeBetween;
+        ops.del_node         = opDelNode;
+        ops.input_signal     = opInputSignal;
+        ops.nearest          = opNearest;
+        ops.dist2            = opDist2;
+        ops.move_towards     = opMoveTowards;
+        ops.terminate        = opTerminate;
+        ops.data             = this;
+
+        is_ = init_[0] = init_[1] = nullptr;
+        gng_ = svoGNGNew(&ops, &params);
+    }
+
+    net_node_type *nodeNew()
+    {
+        net_node_type *n;
+
+        n = alloc_traits::allocate(alloc_, 1);
+        alloc_traits::construct(alloc_, n);
+        return n;
+    }
+
+    net_node_type *nodeNew(const weight_type &w)
+    {
+        net_node_type *n;
+
+        n = nodeNew();
+        Traits::weight(n->value) = w;
+        index_.add(n);
+        return n;
+    }
+
+    static void opInit(svo_gng_node_t **n1, svo_gng_node_t **n2, void *d)
+    {
+        Gng *g = static_cast<Gng *>(d);
+
+        *n1 = &g->nodeNew(*g->init_[0])->gng;
+        *n2 = &g->nodeNew(*g->init_[1])->gng;
+    }
+
+    static svo_gng_node_t *opNewNode(const void *is, void *d)
+    {
+        Gng *g = static_cast<Gng *>(d);
+
+        return &g->nodeNew(*static_cast<const weight_type *>(is))->gng;
+    }
+
+    static svo_gng_node_t *opNewNodeBetween(const svo_gng_node_t *n1,
+                                            const svo_gng_node_t *n2,
+                                            void *d)
+    {
+        Gng *g = static_cast<Gng *>(d);
+        net_node_type *n;
+
+        n = g->nodeNew();
+        Traits::weight(n->value) = Traits::weight(fromC(n1)->value);
+        Traits::move(Traits::weight(n->value),
+                     Traits::weight(fromC(n2)->value), BOR_REAL(0.5));
+        g->index_.add(n);
+        return &n->gng;
+    }
+
+    static void opDelNode(svo_gng_node_t *n, void *d)
+    {
+        Gng *g = static_cast<Gng *>(d);
+        net_node_type *m = fromC(n);
+
+        g->index_.remove(m);
+        alloc_traits::destroy(g->alloc_, m);
+        alloc_traits::deallocate(g->alloc_, m, 1);
+    }
+
+    static const void *opInputSignal(void *d)
+    {
+        return static_cast<Gng *>(d)->is_;
+    }
+
+    static void opNearest(const void *is, svo_gng_node_t **n1,
+                          svo_gng_node_t **n2, void *d)
+    {
+        net_node_type *m1, *m2;
+
+        static_cast<Gng *>(d)->index_.nearest(
+                *static_cast<const weight_type *>(is), &m1, &m2);
+        *n1 = &m1->gng;
+        *n2 = &m2->gng;
+    }
+
+    static bor_real_t opDist2(const void *is, const svo_gng_node_t *n,
+                              void *)
+    {
+        return Traits::dist2(*static_cast<const weight_type *>(is),
+                             Traits::weight(fromC(n)->value));
+    }
+
+    static void opMoveTowards(svo_gng_node_t *n, const void *is,
+                              bor_real_t fraction, void *d)
+    {
+        net_node_type *m = fromC(n);
+
+        Traits::move(Traits::weight(m->value),
+                     *static_cast<const weight_type *>(is), fraction);
+        static_cast<Gng *>(d)->index_.update(m);
+    }
+
+    static int opTerminate(void *)
+    {
+        // run() has its own termination condition
+        return 1;
+    }
+
+    svo_gng_t *gng_;
+    Index index_;
+    alloc_type alloc_;
+    const weight_type *is_;      /*!< Input signal of current step */
+    const weight_type *init_[2]; /*!< Signals for init() */
+};
+
+} /* namespace svo */
+
+#endif /* __SVO_GNG_HPP__ */
@@ -17,12 +17,21 @@
 #ifndef __SVO_GSRM_H__
 #define __SVO_GSRM_H__
 
+#include <stdio.h>
 #include <boruvka/core.h>
 #include <boruvka/timer.h>
 #include <boruvka/pc.h>
 #include <boruvka/mesh3.h>
 #include <boruvka/nn.h>
 #include <boruvka/pairheap.h>
+#include <gng/pool.h>
+#include <gng/err-tree.h>
+#include <gng/adj.h>
+#include <gng/edge-hash.h>
+#include <gng/sampler.h>
+#include <gng/pts.h>
+#include <gng/stats.h>
+#include <gng/rng.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -64,6 +73,36 @@ struct _svo_gsrm_params_t {
 
     int unoptimized_err; /*!< True if unoptimized error handling should be
                               used. Default: false */
+    int err_index; /*!< Structure used for finding node with highest
+                        error counter if not .unoptimized_err,
+                        SVO_ERR_INDEX_HEAP (pairing heap) or
+                        SVO_ERR_INDEX_TREE (see svo_err_tree_t).
+                        Default: SVO_ERR_INDEX_HEAP */
+
+    int compact_adj; /*!< If true, each node keeps also compact array of
+                          its neighbors (see svo_adj_t) which is used
+                          for finding edge between two nodes instead of
+                          walking lists of edges. Default: false */
+    int edge_hash; /*!< If true, all edges are kept also in hash table
+                        keyed by pairs of ids of nodes (see
+                        svo_edge_hash_t) which is then used for finding
+                        edge between two nodes (it takes precedence over
+                        .compact_adj). Default: false */
+
+    int perm_sampler; /*!< If true, input signals are drawn in order of
+                           pseudo-random permutation computed on the fly
+                           (see svo_sampler_t) instead of reshuffling
+                           order of all input signals every epoch.
+                           Default: false */
+    unsigned long seed; /*!< Seed of all random decisions (order of input
+                             signals), the same seed and input gives the
+                             same mesh. Default: 0 */
+
+    const char *checkpoint; /*!< If set, snapshot of training state is
+                                 periodically written into this file (see
+                                 svoGSRMSave()). Default: NULL */
+    unsigned long checkpoint_period; /*!< Number of cycles between two
+                                          checkpoints. Default: 10000 */
 };
 typedef struct _svo_gsrm_params_t svo_gsrm_params_t;
 
@@ -76,20 +115,40 @@ struct _svo_gsrm_t {
     svo_gsrm_params_t params; /*!< Parameters of algorithm */
 
     bor_pc_t *is;      /*!< Input signals */
-    bor_pc_it_t isit;  /*!< Iterator over is */
+    svo_pts_t is_pts;  /*!< Input signals used in place as loaded from
+                            file (see svoGSRMAddInputSignals()), if used
+                            .is is empty */
+    bor_vec3_t **is_ptr;   /*!< Input signals of .is in order of point
+                                cloud */
+    size_t *is_order;      /*!< Indices into .is_ptr in order in which
+                                input signals are drawn, shuffled every
+                                epoch */
+    size_t is_order_len, is_order_pos;
+    svo_sampler_t sampler; /*!< Sampler of is (if params.perm_sampler) */
+    svo_rng_t rng;         /*!< Generator seeded by params.seed */
     bor_mesh3_t *mesh; /*!< Reconstructed mesh */
     bor_nn_t *nn;      /*!< Search structure for nearest neighbor */
 
-    bor_real_t *beta_n;        /*!< Precomputed beta^n for n = 1, ..., lambda */
-    bor_real_t *beta_lambda_n; /*!< Precomputed beta^(n*lambda) for
-                                    n = 1, ..., .beta_lambda_n_len */
-    size_t beta_lambda_n_len;
-    bor_pairheap_t *err_heap;
+    bor_real_t err_scale;     /*!< Common factor of all error counters
+                                   (real error is node's error divided by
+                                   this factor) */
+    bor_real_t err_scale_inc; /*!< 1 / beta */
+    bor_pairheap_t *err_heap;  /*!< Error heap (SVO_ERR_INDEX_HEAP) */
+    svo_err_tree_t *err_tree;  /*!< Error tree (SVO_ERR_INDEX_TREE) */
+    svo_edge_hash_t edge_hash; /*!< Edges by pairs of nodes (if
+                                    params.edge_hash) */
 
     size_t step;
     unsigned long cycle;
 
     bor_timer_t timer;
+    svo_stats_t stats; /*!< Time spent in phases of learning (filled only
+                            if compiled with SVO_STATS) */
+
+    svo_pool_t node_pool; /*!< Nodes of mesh */
+    svo_pool_t vec_pool;  /*!< Weight vectors of nodes */
+    svo_pool_t edge_pool; /*!< Edges of mesh */
+    svo_pool_t face_pool; /*!< Faces of mesh */
 
     struct _svo_gsrm_cache_t *c; /*!< Internal cache, don't touch it! */
 };
@@ -109,17 +168,43 @@ void svoGSRMDel(svo_gsrm_t *g);
 
 /**
  * Adds input signals from given file.
+ * The file is either text file with three coordinates per line (parsed
+ * in parallel) or binary point cloud, see svoPtsLoad(). If the file is
+ * the only source of input signals, loaded points (or mapped binary
+ * file) are used in place together with their bounding box and input
+ * signals are then drawn as if params.perm_sampler was set.
  * Returns number of read points.
  */
 size_t svoGSRMAddInputSignals(svo_gsrm_t *g, const char *fn);
 
 /**
  * Runs GSRM algorithm.
+ * If training state was restored by svoGSRMLoad(), the run continues
+ * from there.
  * Returns 0 on success.
  * Returns -1 if no there are no input signals.
  */
 int svoGSRMRun(svo_gsrm_t *g);
 
+/**
+ * Writes binary snapshot of complete training state (learning
+ * parameters, error counters, nodes, edges with their ages, faces, state
+ * of generator and position of sampler) into {fout}.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoGSRMSave(svo_gsrm_t *g, FILE *fout);
+
+/**
+ * Restores training state from snapshot written by svoGSRMSave().
+ * It must be called after the same input signals were added and before
+ * svoGSRMRun(). The run is then continued exactly as the saved one would,
+ * including order of reshuffled input signals.
+ * If it fails, parameters are left as they were and mesh stays empty, so
+ * svoGSRMRun() starts from scratch.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoGSRMLoad(svo_gsrm_t *g, FILE *fin);
+
 /**
  * Performs postprocessing of mesh.
  * This function should be called _after_ svoGSRMRun().
@@ -136,6 +221,17 @@ _bor_inline const svo_gsrm_params_t *svoGSRMParams(svo_gsrm_t *g);
  */
 _bor_inline bor_mesh3_t *svoGSRMMesh(svo_gsrm_t *g);
 
+/**
+ * Returns statistics of phases of learning and postprocessing (see
+ * gng/stats.h).
+ */
+_bor_inline const svo_stats_t *svoGSRMStats(const svo_gsrm_t *g);
+
+/**
+ * Zeroes statistics.
+ */
+_bor_inline void svoGSRMStatsReset(svo_gsrm_t *g);
+
 
 /**** INLINES ****/
 _bor_inline const svo_gsrm_params_t *svoGSRMParams(svo_gsrm_t *g)
@@ -148,6 +244,16 @@ _bor_inline bor_mesh3_t *svoGSRMMesh(svo_gsrm_t *g)
     return g->mesh;
 }
 
+_bor_inline const svo_stats_t *svoGSRMStats(const svo_gsrm_t *g)
+{
+    return &g->stats;
+}
+
+_bor_inline void svoGSRMStatsReset(svo_gsrm_t *g)
+{
+    svoStatsReset(&g->stats);
+}
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
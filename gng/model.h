@@ -0,0 +1,166 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_MODEL_H__
+#define __SVO_MODEL_H__
+
+#include <stdint.h>
+#include <boruvka/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Trained Model
+ * ==============
+ *
+ * Read-only form of trained net intended for nearest prototype lookups.
+ * The file is position independent, so it is only memory mapped when
+ * opened and all processes that use the same model share its pages
+ * through page cache.
+ *
+ * File consists of 128 bytes long header (svo_model_header_t) followed by
+ * sections aligned to 64 bytes:
+ *   - weights: {len} vectors of {dim} bor_real_t elements,
+ *   - adjacency in CSR form: {len + 1} uint64_t offsets followed by
+ *     {2 * edges_len} uint32_t indices of neighbors,
+ *   - kd-tree: {len} uint32_t split axes.
+ *
+ * Nodes are stored in order of implicit kd-tree: range [lo, hi) is split
+ * by node in the middle along the axis stored at the middle position,
+ * nodes before it lie below the split and nodes after it above. Ranges of
+ * at most {leaf} nodes are not split. So the tree needs no pointers and
+ * index of node in the model is given by its position in the tree.
+ * All values are stored in byte order of machine that wrote the file and
+ * elements must be of bor_real_t type.
+ */
+
+/** Magic string at the beginning of file (including terminating zero) */
+#define SVO_MODEL_MAGIC "SVOMDL1"
+/** Maximal number of nodes in leaf of kd-tree */
+#define SVO_MODEL_LEAF 8
+
+struct _svo_model_header_t {
+    char magic[8];        /*!< SVO_MODEL_MAGIC */
+    uint32_t endian;      /*!< 0x01020304 */
+    uint32_t dim;         /*!< Dimension of weight vectors */
+    uint32_t elsize;      /*!< sizeof(bor_real_t) */
+    uint32_t leaf;        /*!< Maximal number of nodes in leaf */
+    uint64_t len;         /*!< Number of nodes */
+    uint64_t edges_len;   /*!< Number of edges */
+    uint64_t weights_off; /*!< Offsets of sections from beginning of file */
+    uint64_t adj_ptr_off;
+    uint64_t adj_off;
+    uint64_t axis_off;
+    uint64_t size;        /*!< Size of whole file */
+    char pad[48];
+};
+typedef struct _svo_model_header_t svo_model_header_t;
+
+struct _svo_model_t {
+    int dim;                 /*!< Dimension of weight vectors */
+    size_t len;              /*!< Number of nodes */
+    size_t edges_len;        /*!< Number of edges */
+    size_t leaf;             /*!< Maximal number of nodes in leaf */
+
+    const bor_real_t *w;     /*!< Weight vectors */
+    const uint64_t *adj_ptr; /*!< Neighbors of i'th node are
+                                  .adj[.adj_ptr[i] .. .adj_ptr[i + 1]) */
+    const uint32_t *adj;
+    const uint32_t *axis;    /*!< Split axes of kd-tree */
+
+    void *map;               /*!< Mapped file */
+    size_t map_size;
+};
+typedef struct _svo_model_t svo_model_t;
+
+/**
+ * Writes model of {len} nodes with weight vectors {w} and {edges_len}
+ * edges given as pairs of indices into {w} into file {fn}.
+ * Nodes are reordered by kd-tree, if {order} is non-NULL, index of i'th
+ * node in the model is stored in {order}[i].
+ * Model without nodes ({len} == 0) is written but svoModelOpen() refuses
+ * it.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoModelWrite(const char *fn, int dim, size_t len, const bor_real_t **w,
+                  size_t edges_len, const uint32_t *edges, uint32_t *order);
+
+/**
+ * Maps model from file {fn}. It is checked that the model has at least one
+ * node and number of nodes fits into uint32_t, all sections lie within
+ * the file, split axes are lower than {dim}, CSR offsets are
+ * non-decreasing from 0 to {2 * edges_len} and all neighbor indices are
+ * lower than {len}. So lookups in an opened model never read outside of
+ * the mapping.
+ * Returns 0 on success, -1 otherwise (and error message is printed).
+ */
+int svoModelOpen(svo_model_t *m, const char *fn);
+
+/**
+ * Unmaps model.
+ */
+void svoModelClose(svo_model_t *m);
+
+/**
+ * Returns weight vector of {i}'th node.
+ */
+_bor_inline const bor_real_t *svoModelWeight(const svo_model_t *m, size_t i);
+
+/**
+ * Returns array of neighbors of {i}'th node, its length is stored in
+ * {len}.
+ */
+_bor_inline const uint32_t *svoModelNeighbors(const svo_model_t *m, size_t i,
+                                              size_t *len);
+
+/**
+ * Returns index of node nearest to {v}. If {dist2} is non-NULL squared
+ * distance to the node is stored there.
+ */
+size_t svoModelNearest(const svo_model_t *m, const bor_real_t *v,
+                       bor_real_t *dist2);
+
+/**
+ * Finds nearest nodes to {len} vectors {vs} (stored one after another)
+ * using {num_threads} threads. Index of nearest node of i'th vector is
+ * stored in {ids}[i] and squared distance to it in {dist2}[i] (if
+ * {dist2} is non-NULL).
+ */
+void svoModelQuantize(const svo_model_t *m, const bor_real_t *vs, size_t len,
+                      uint32_t *ids, bor_real_t *dist2, int num_threads);
+
+
+/**** INLINES ****/
+_bor_inline const bor_real_t *svoModelWeight(const svo_model_t *m, size_t i)
+{
+    return m->w + i * m->dim;
+}
+
+_bor_inline const uint32_t *svoModelNeighbors(const svo_model_t *m, size_t i,
+                                              size_t *len)
+{
+    *len = m->adj_ptr[i + 1] - m->adj_ptr[i];
+    return m->adj + m->adj_ptr[i];
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_MODEL_H__ */
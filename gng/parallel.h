@@ -0,0 +1,84 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#ifndef __SVO_PARALLEL_H__
+#define __SVO_PARALLEL_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Parallel For
+ * =============
+ *
+ * Minimal fork-join helper: range [0, len) is split into {num_threads}
+ * contiguous chunks of (almost) the same size and each chunk is processed
+ * by its own thread. The calling thread processes the first chunk and
+ * the function returns after all chunks are processed.
+ *
+ * svoParallelFor() creates and joins threads on each call. For short
+ * ranges processed repeatedly (e.g., every learning step) a pool of
+ * persistent workers (svo_parallel_pool_t) should be used instead.
+ */
+
+/**
+ * Processes range [from, to). {thread_id} is from [0, num_threads).
+ */
+typedef void (*svo_parallel_fn)(size_t from, size_t to, int thread_id,
+                                void *data);
+
+/**
+ * Calls {fn} on chunks of range [0, len) in {num_threads} threads.
+ * If {num_threads} <= 1 (or the range is too short) {fn} is called
+ * directly from the calling thread.
+ */
+void svoParallelFor(int num_threads, size_t len,
+                    svo_parallel_fn fn, void *data);
+
+
+/**
+ * Pool of {num_threads} - 1 worker threads that sleep between jobs.
+ * Together with the calling thread they process ranges exactly as
+ * svoParallelFor() does.
+ */
+typedef struct _svo_parallel_pool_t svo_parallel_pool_t;
+
+/**
+ * Creates pool and starts its workers. If {num_threads} <= 1 no thread
+ * is started and all work is done by the calling thread.
+ */
+svo_parallel_pool_t *svoParallelPoolNew(int num_threads);
+
+/**
+ * Stops workers and deletes pool.
+ */
+void svoParallelPoolDel(svo_parallel_pool_t *pool);
+
+/**
+ * Same as svoParallelFor() but {fn} is run by workers of {pool}.
+ * Calls from different threads are serialized.
+ */
+void svoParallelPoolFor(svo_parallel_pool_t *pool, size_t len,
+                        svo_parallel_fn fn, void *data);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_PARALLEL_H__ */
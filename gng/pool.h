@@ -0,0 +1,117 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#ifndef __SVO_POOL_H__
+#define __SVO_POOL_H__
+
+#include <boruvka/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Pool Allocator
+ * ===============
+ *
+ * Allocator of elements of the same size (nodes, edges, faces).
+ * Elements are carved out of big slabs and released elements are kept in
+ * a free list for reuse, so allocation and release are just a few
+ * instructions. Memory is returned to the system only by svoPoolFree()
+ * which releases all slabs at once, i.e., there is no need to release
+ * elements one by one before that.
+ */
+
+struct _svo_pool_t {
+    size_t el_size;      /*!< Size of one element */
+    size_t slab_els;     /*!< Number of elements in one slab */
+
+    void **slabs;        /*!< Allocated slabs */
+    size_t slabs_len;
+    size_t slabs_size;
+
+    char *cur;           /*!< Unused part of the last slab */
+    size_t cur_left;     /*!< Number of elements left in .cur */
+
+    void *free;          /*!< Free list of released elements */
+    size_t len;          /*!< Number of elements currently in use */
+};
+typedef struct _svo_pool_t svo_pool_t;
+
+/** Default number of elements per slab */
+#define SVO_POOL_SLAB_ELS 4096
+
+/**
+ * Initializes pool of elements of size {el_size}. If {slab_els} is zero,
+ * SVO_POOL_SLAB_ELS is used.
+ */
+void svoPoolInit(svo_pool_t *pool, size_t el_size, size_t slab_els);
+
+/**
+ * Releases all memory of pool including all elements still in use.
+ */
+void svoPoolFree(svo_pool_t *pool);
+
+/**
+ * Returns new (uninitialized) element.
+ */
+_bor_inline void *svoPoolAlloc(svo_pool_t *pool);
+
+/**
+ * Gives element back to pool.
+ */
+_bor_inline void svoPoolRelease(svo_pool_t *pool, void *el);
+
+/**
+ * Allocates new slab, for internal use.
+ */
+void __svoPoolGrow(svo_pool_t *pool);
+
+
+/**** INLINES ****/
+_bor_inline void *svoPoolAlloc(svo_pool_t *pool)
+{
+    void *el;
+
+    ++pool->len;
+
+    if (pool->free){
+        el = pool->free;
+        pool->free = *(void **)el;
+        return el;
+    }
+
+    if (pool->cur_left == 0)
+        __svoPoolGrow(pool);
+
+    el = pool->cur;
+    pool->cur += pool->el_size;
+    --pool->cur_left;
+    return el;
+}
+
+_bor_inline void svoPoolRelease(svo_pool_t *pool, void *el)
+{
+    *(void **)el = pool->free;
+    pool->free = el;
+    --pool->len;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_POOL_H__ */
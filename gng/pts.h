@@ -0,0 +1,158 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_PTS_H__
+#define __SVO_PTS_H__
+
+#include <stdint.h>
+#include <boruvka/core.h>
+#include <boruvka/pc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Binary Point Cloud
+ * ===================
+ *
+ * File consists of 64 bytes long header (svo_pts_header_t) followed by
+ * packed array of {len} vectors of {dim} elements, elements are either
+ * floats or doubles. All values are stored in byte order of machine that
+ * wrote the file.
+ *
+ * The file is memory mapped when opened, so loading takes no time and if
+ * elements are of bor_real_t type the array is used in place. Otherwise
+ * elements are converted into allocated array.
+ *
+ * Text files can be converted by bin/pts2bin, they can be also loaded
+ * into the same structure directly (svoPtsLoadText()).
+ */
+
+/** Magic string at the beginning of file (including terminating zero) */
+#define SVO_PTS_MAGIC "SVOPTS1"
+/** Value of .endian field written by the machine reading the file */
+#define SVO_PTS_ENDIAN 0x01020304u
+
+struct _svo_pts_header_t {
+    char magic[8];    /*!< SVO_PTS_MAGIC */
+    uint32_t endian;  /*!< SVO_PTS_ENDIAN */
+    uint32_t dim;     /*!< Dimension of vectors */
+    uint32_t elsize;  /*!< Size of one element in bytes, 4 or 8 */
+    uint32_t reserved;
+    uint64_t len;     /*!< Number of vectors */
+    char pad[32];
+};
+typedef struct _svo_pts_header_t svo_pts_header_t;
+
+struct _svo_pts_t {
+    int dim;                /*!< Dimension of vectors */
+    size_t len;             /*!< Number of vectors */
+    const bor_real_t *data; /*!< Packed vectors, NULL if nothing is open */
+
+    void *map;              /*!< Mapped file */
+    size_t map_size;        /*!< Size of mapped file */
+    bor_real_t *conv;       /*!< Converted elements, if they aren't
+                                 bor_real_t in file, or parsed elements
+                                 of text file */
+    bor_real_t *aabb;       /*!< Bounding box if it is already known */
+};
+typedef struct _svo_pts_t svo_pts_t;
+
+/**
+ * Initializes struct to empty point cloud.
+ */
+void svoPtsInit(svo_pts_t *pts);
+
+/**
+ * Returns true if file {fn} is binary point cloud.
+ */
+int svoPtsIsBinary(const char *fn);
+
+/**
+ * Maps binary point cloud from file {fn}.
+ * Returns 0 on success, -1 otherwise (and error message is printed).
+ */
+int svoPtsOpen(svo_pts_t *pts, const char *fn);
+
+/**
+ * Loads points from text file {fn} containing {dim} numbers per line
+ * (lines with less numbers are skipped), i.e., the format
+ * borPCAddFromFile() reads.
+ *
+ * The file is mapped and split at line boundaries into {num_threads}
+ * parts which are parsed in parallel (0 means one thread per online
+ * CPU). Numbers are parsed without regard to locale and the bounding
+ * box is computed meanwhile, so svoPtsAABB() then takes no time.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoPtsLoadText(svo_pts_t *pts, const char *fn, int dim, int num_threads);
+
+/**
+ * Loads points from file {fn} which can be either binary
+ * (svoPtsOpen()) or text (svoPtsLoadText()) file.
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoPtsLoad(svo_pts_t *pts, const char *fn, int dim, int num_threads);
+
+/**
+ * Unmaps file and frees all resources.
+ */
+void svoPtsClose(svo_pts_t *pts);
+
+/**
+ * Returns {i}'th vector.
+ */
+_bor_inline const bor_real_t *svoPtsGet(const svo_pts_t *pts, size_t i);
+
+/**
+ * Computes axis aligned bounding box of points, {aabb} must have 2 * dim
+ * elements (min and max of each axis).
+ */
+void svoPtsAABB(const svo_pts_t *pts, bor_real_t *aabb);
+
+/**
+ * Adds (copies) all points into point cloud. Returns number of added
+ * points.
+ */
+size_t svoPtsAddToPC(const svo_pts_t *pts, bor_pc_t *pc);
+
+/**
+ * Writes points into binary file {fn}, see svoPtsWritePC().
+ */
+int svoPtsWrite(const svo_pts_t *pts, const char *fn, int elsize);
+
+/**
+ * Writes points of point cloud {pc} into file {fn}.
+ * {elsize} is size of element in file (4 for floats, 8 for doubles or 0
+ * for bor_real_t).
+ * Returns 0 on success, -1 otherwise.
+ */
+int svoPtsWritePC(bor_pc_t *pc, const char *fn, int elsize);
+
+
+/**** INLINES ****/
+_bor_inline const bor_real_t *svoPtsGet(const svo_pts_t *pts, size_t i)
+{
+    return pts->data + i * pts->dim;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_PTS_H__ */
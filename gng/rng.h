@@ -0,0 +1,122 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_RNG_H__
+#define __SVO_RNG_H__
+
+#include <stdint.h>
+#include <boruvka/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Random Number Generator
+ * ========================
+ *
+ * Seeded generator (xoshiro256**) whose whole state is in svo_rng_t, so
+ * each instance of algorithm (and each thread) draws from its own stream
+ * and the same seed always gives the same sequence on any platform.
+ *
+ * Independent streams for parallel workers are obtained by
+ * svoRngInitStream(): stream k starts 2^128 numbers after stream k - 1
+ * of the same seed, so streams never overlap in practice.
+ */
+
+struct _svo_rng_t {
+    uint64_t s[4];
+};
+typedef struct _svo_rng_t svo_rng_t;
+
+/**
+ * Initializes generator by {seed}.
+ */
+void svoRngInit(svo_rng_t *r, uint64_t seed);
+
+/**
+ * Initializes generator by {seed} and moves it to the {stream}'th
+ * independent stream (stream 0 is the same as svoRngInit()).
+ */
+void svoRngInitStream(svo_rng_t *r, uint64_t seed, unsigned long stream);
+
+/**
+ * Advances generator by 2^128 steps.
+ */
+void svoRngJump(svo_rng_t *r);
+
+/**
+ * Returns next 64-bit number.
+ */
+_bor_inline uint64_t svoRngU64(svo_rng_t *r);
+
+/**
+ * Returns number uniformly distributed in [0, n), n must be > 0.
+ */
+_bor_inline uint64_t svoRngRange(svo_rng_t *r, uint64_t n);
+
+/**
+ * Returns number uniformly distributed in [0, 1).
+ */
+_bor_inline double svoRngUniform(svo_rng_t *r);
+
+
+/**** INLINES ****/
+_bor_inline uint64_t __svoRngRotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+_bor_inline uint64_t svoRngU64(svo_rng_t *r)
+{
+    uint64_t res, t;
+
+    res = __svoRngRotl(r->s[1] * 5, 7) * 9;
+    t = r->s[1] << 17;
+
+    r->s[2] ^= r->s[0];
+    r->s[3] ^= r->s[1];
+    r->s[1] ^= r->s[2];
+    r->s[0] ^= r->s[3];
+    r->s[2] ^= t;
+    r->s[3] = __svoRngRotl(r->s[3], 45);
+
+    return res;
+}
+
+_bor_inline uint64_t svoRngRange(svo_rng_t *r, uint64_t n)
+{
+    uint64_t x, lim;
+
+    // rejection of the top incomplete range removes modulo bias
+    lim = UINT64_MAX - UINT64_MAX % n;
+    do {
+        x = svoRngU64(r);
+    } while (x >= lim);
+    return x % n;
+}
+
+_bor_inline double svoRngUniform(svo_rng_t *r)
+{
+    return (double)(svoRngU64(r) >> 11) * (1. / 9007199254740992.);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_RNG_H__ */
@@ -0,0 +1,234 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_SAMPLER_H__
+#define __SVO_SAMPLER_H__
+
+#include <stdint.h>
+#include <boruvka/core.h>
+#include <boruvka/vec.h>
+#include <boruvka/pc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Pseudo-Random Permutation
+ * ==========================
+ *
+ * Bijection of [0, n) computed on the fly, i.e., i-th element of random
+ * permutation is obtained in constant time and memory without any array
+ * being shuffled.
+ *
+ * Indices are encrypted by balanced Feistel network over the smallest
+ * domain of even number of bits covering n (so the domain is less than
+ * 4n) and values falling out of [0, n) are encrypted again (cycle
+ * walking) until they get into the range. Keys of rounds are derived
+ * from seed, so the same seed always gives the same permutation.
+ */
+
+/** Number of rounds of Feistel network */
+#define SVO_PERM_ROUNDS 4
+
+struct _svo_perm_t {
+    uint64_t n;                       /*!< Size of permuted range */
+    int half_bits;                    /*!< Number of bits of one half */
+    uint64_t half_mask;               /*!< (1 << .half_bits) - 1 */
+    uint64_t keys[SVO_PERM_ROUNDS];   /*!< Keys of rounds */
+};
+typedef struct _svo_perm_t svo_perm_t;
+
+/**
+ * Initializes permutation of [0, n) given by {seed}.
+ */
+void svoPermInit(svo_perm_t *p, uint64_t n, uint64_t seed);
+
+/**
+ * Returns {i}'th element of permutation, {i} must be less than n.
+ */
+_bor_inline uint64_t svoPermGet(const svo_perm_t *p, uint64_t i);
+
+
+
+/**
+ * Input Signal Sampler
+ * =====================
+ *
+ * Draws input signals from point cloud (or array of vectors) in random
+ * order so that each signal is drawn exactly once per epoch. Order of
+ * each epoch is given by svo_perm_t seeded by sampler's seed and number
+ * of epoch, so points are never moved and whole sequence of signals is
+ * reproducible.
+ *
+ * Signals are addressed in place through runs of equally spaced vectors
+ * (bor_pc_t stores points in few big chunks) and next
+ * SVO_SAMPLER_AHEAD signals are always known in advance and prefetched.
+ */
+
+/** Number of signals that are prefetched ahead, must be power of two */
+#define SVO_SAMPLER_AHEAD 8
+
+struct _svo_sampler_run_t {
+    size_t from;            /*!< Index of first vector of run */
+    const bor_real_t *data; /*!< First vector of run */
+};
+typedef struct _svo_sampler_run_t svo_sampler_run_t;
+
+struct _svo_sampler_t {
+    svo_sampler_run_t *runs; /*!< Runs of vectors ordered by .from */
+    size_t runs_len;
+    size_t stride;           /*!< Distance between vectors in run */
+    size_t len;              /*!< Overall number of vectors */
+
+    uint64_t seed;           /*!< Seed of sampler */
+    unsigned long epoch;     /*!< Epoch of .perm */
+    svo_perm_t perm;         /*!< Order of signals of epoch .epoch */
+    size_t pos;              /*!< Position within .perm of next signal
+                                  that will be put into .ahead */
+
+    const bor_vec_t *ahead[SVO_SAMPLER_AHEAD]; /*!< Next signals */
+    unsigned int ahead_pos;                    /*!< Next signal in .ahead */
+};
+typedef struct _svo_sampler_t svo_sampler_t;
+
+/**
+ * Initializes sampler over points of point cloud. Points are not copied,
+ * so {pc} must stay unchanged while sampler is used.
+ */
+void svoSamplerInitPC(svo_sampler_t *s, bor_pc_t *pc, uint64_t seed);
+
+/**
+ * Initializes sampler over array of {len} vectors of {dim} reals stored
+ * one after another.
+ */
+void svoSamplerInitArr(svo_sampler_t *s, const bor_real_t *arr,
+                       size_t len, int dim, uint64_t seed);
+
+/**
+ * Frees sampler.
+ */
+void svoSamplerFree(svo_sampler_t *s);
+
+/**
+ * Returns number of signals.
+ */
+_bor_inline size_t svoSamplerLen(const svo_sampler_t *s);
+
+/**
+ * Returns {i}'th vector in order in which vectors are stored.
+ */
+_bor_inline const bor_vec_t *svoSamplerGet(const svo_sampler_t *s, size_t i);
+
+/**
+ * Returns next input signal.
+ */
+_bor_inline const bor_vec_t *svoSamplerNext(svo_sampler_t *s);
+
+/**
+ * Returns number of signals drawn by svoSamplerNext() so far.
+ */
+uint64_t svoSamplerTell(const svo_sampler_t *s);
+
+/**
+ * Sets sampler to the state after {drawn} signals were drawn, i.e., the
+ * following signals will be the same as if svoSamplerNext() was called
+ * {drawn} times since initialization.
+ */
+void svoSamplerSeek(svo_sampler_t *s, uint64_t drawn);
+
+/**
+ * Starts new epoch of permutation, for internal use.
+ */
+void __svoSamplerNextEpoch(svo_sampler_t *s);
+
+
+/**** INLINES ****/
+_bor_inline uint64_t __svoPermRound(uint64_t x, uint64_t key)
+{
+    // finalizer of splitmix64
+    x ^= key;
+    x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return x ^ (x >> 31);
+}
+
+_bor_inline uint64_t svoPermGet(const svo_perm_t *p, uint64_t i)
+{
+    uint64_t l, r, t;
+    int k;
+
+    do {
+        l = i >> p->half_bits;
+        r = i & p->half_mask;
+        for (k = 0; k < SVO_PERM_ROUNDS; k++){
+            t = r;
+            r = l ^ (__svoPermRound(r, p->keys[k]) & p->half_mask);
+            l = t;
+        }
+        i = (l << p->half_bits) | r;
+    } while (i >= p->n);
+
+    return i;
+}
+
+_bor_inline size_t svoSamplerLen(const svo_sampler_t *s)
+{
+    return s->len;
+}
+
+_bor_inline const bor_vec_t *svoSamplerGet(const svo_sampler_t *s, size_t i)
+{
+    size_t lo, hi, mid;
+
+    lo = 0;
+    hi = s->runs_len;
+    while (hi - lo > 1){
+        mid = (lo + hi) / 2;
+        if (s->runs[mid].from <= i){
+            lo = mid;
+        }else{
+            hi = mid;
+        }
+    }
+
+    return s->runs[lo].data + (i - s->runs[lo].from) * s->stride;
+}
+
+_bor_inline const bor_vec_t *svoSamplerNext(svo_sampler_t *s)
+{
+    const bor_vec_t *v, *n;
+
+    if (bor_unlikely(s->pos == s->len))
+        __svoSamplerNextEpoch(s);
+
+    // replace returned signal by the one SVO_SAMPLER_AHEAD steps ahead
+    n = svoSamplerGet(s, svoPermGet(&s->perm, s->pos++));
+    __builtin_prefetch(n);
+
+    v = s->ahead[s->ahead_pos];
+    s->ahead[s->ahead_pos] = n;
+    s->ahead_pos = (s->ahead_pos + 1) & (SVO_SAMPLER_AHEAD - 1);
+
+    return v;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_SAMPLER_H__ */
@@ -0,0 +1,150 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_SNAPSHOT_H__
+#define __SVO_SNAPSHOT_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <boruvka/core.h>
+#include <gng/rng.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Snapshots
+ * ==========
+ *
+ * Low-level reading and writing of binary snapshots of training state
+ * (see svoGNGEuSave(), svoGNGTSave() and svoGSRMSave()).
+ *
+ * Snapshot starts with header identifying which algorithm wrote it and
+ * size of bor_real_t, values follow in byte order and precision of
+ * writing machine, so state is restored bit-exactly. The first error
+ * (I/O error or unexpected data) is remembered in .err and all following
+ * reads and writes are no-op.
+ */
+
+/** Magic string at the beginning of snapshot (including terminating zero) */
+#define SVO_SNAPSHOT_MAGIC "SVOSNAP"
+/** Version of format */
+#define SVO_SNAPSHOT_VERSION 2
+
+/** Kinds of snapshots */
+#define SVO_SNAPSHOT_GNG_EU 1
+#define SVO_SNAPSHOT_GNGT   2
+#define SVO_SNAPSHOT_GSRM   3
+
+struct _svo_snapshot_t {
+    FILE *f;
+    int err; /*!< True if error occured */
+};
+typedef struct _svo_snapshot_t svo_snapshot_t;
+
+/**
+ * Starts writing snapshot of given kind into {fout}.
+ */
+void svoSnapshotWriteStart(svo_snapshot_t *s, FILE *fout, uint32_t kind);
+
+/**
+ * Starts reading snapshot from {fin}, the snapshot must be of given kind.
+ */
+void svoSnapshotReadStart(svo_snapshot_t *s, FILE *fin, uint32_t kind);
+
+/**
+ * Writes {size} bytes from {buf}.
+ */
+void svoSnapshotWrite(svo_snapshot_t *s, const void *buf, size_t size);
+
+/**
+ * Reads {size} bytes into {buf}.
+ */
+void svoSnapshotRead(svo_snapshot_t *s, void *buf, size_t size);
+
+/**
+ * Finishes snapshot. Returns 0 on success, -1 if any error occured (and
+ * message prefixed by {who} is printed to stderr).
+ */
+int svoSnapshotEnd(svo_snapshot_t *s, const char *who);
+
+_bor_inline void svoSnapshotWriteU64(svo_snapshot_t *s, uint64_t v);
+_bor_inline void svoSnapshotWriteReal(svo_snapshot_t *s, bor_real_t v);
+_bor_inline uint64_t svoSnapshotReadU64(svo_snapshot_t *s);
+_bor_inline bor_real_t svoSnapshotReadReal(svo_snapshot_t *s);
+
+/**
+ * Writes (reads) complete state of generator.
+ */
+_bor_inline void svoSnapshotWriteRng(svo_snapshot_t *s, const svo_rng_t *r);
+_bor_inline void svoSnapshotReadRng(svo_snapshot_t *s, svo_rng_t *r);
+
+
+/**** INLINES ****/
+_bor_inline void svoSnapshotWriteU64(svo_snapshot_t *s, uint64_t v)
+{
+    svoSnapshotWrite(s, &v, sizeof(v));
+}
+
+_bor_inline void svoSnapshotWriteReal(svo_snapshot_t *s, bor_real_t v)
+{
+    svoSnapshotWrite(s, &v, sizeof(v));
+}
+
+_bor_inline uint64_t svoSnapshotReadU64(svo_snapshot_t *s)
+{
+    uint64_t v = 0;
+    svoSnapshotRead(s, &v, sizeof(v));
+    return v;
+}
+
+_bor_inline bor_real_t svoSnapshotReadReal(svo_snapshot_t *s)
+{
+    bor_real_t v = BOR_ZERO;
+    svoSnapshotRead(s, &v, sizeof(v));
+    return v;
+}
+
+_bor_inline void svoSnapshotWriteRng(svo_snapshot_t *s, const svo_rng_t *r)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        svoSnapshotWriteU64(s, r->s[i]);
+}
+
+_bor_inline void svoSnapshotReadRng(svo_snapshot_t *s, svo_rng_t *r)
+{
+    uint64_t v[4];
+    int i;
+
+    for (i = 0; i < 4; i++)
+        v[i] = svoSnapshotReadU64(s);
+
+    // generator is left untouched if snapshot is broken
+    if (!s->err){
+        for (i = 0; i < 4; i++)
+            r->s[i] = v[i];
+    }
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_SNAPSHOT_H__ */
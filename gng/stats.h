@@ -0,0 +1,143 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+
+#ifndef __SVO_STATS_H__
+#define __SVO_STATS_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <boruvka/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Statistics
+ * ===========
+ *
+ * Cumulative time (in nanoseconds) and number of calls of individual
+ * phases of learning. Each algorithm (svo_gng_t, svo_gng_eu_t, svo_gngt_t,
+ * svo_gsrm_t) carries its own svo_stats_t, but it is filled only if
+ * library was compiled with SVO_STATS defined (make STATS=yes), otherwise
+ * all counters stay zero and measuring costs nothing.
+ *
+ * Phases don't overlap, so sum of times of all phases is (roughly) time
+ * spent in learning.
+ */
+
+/** Phases of learning */
+enum {
+    SVO_STATS_INPUT = 0,   /*!< Fetching of input signal */
+    SVO_STATS_NEAREST,     /*!< Search for two nearest nodes */
+    SVO_STATS_HEBBIAN,     /*!< Connecting of winners (including GSRM's
+                                face creation) */
+    SVO_STATS_ERR,         /*!< Updates of error counters, error heap or
+                                tree */
+    SVO_STATS_MOVE,        /*!< Moving of nodes towards input signal */
+    SVO_STATS_NN_UPDATE,   /*!< Updates of nearest neighbor search
+                                structure */
+    SVO_STATS_PRUNE,       /*!< Removing of old edges and isolated nodes */
+    SVO_STATS_NEW_NODE,    /*!< Node insertion (or removal in GNG-T) */
+    SVO_STATS_TOPOLOGY,    /*!< GSRM's topology learning */
+    SVO_STATS_POSTPROCESS, /*!< GSRM's postprocessing */
+
+    SVO_STATS_LEN
+};
+
+struct _svo_stats_phase_t {
+    uint64_t ns;    /*!< Cumulative time in nanoseconds */
+    uint64_t calls; /*!< Number of calls */
+};
+typedef struct _svo_stats_phase_t svo_stats_phase_t;
+
+struct _svo_stats_t {
+    svo_stats_phase_t phase[SVO_STATS_LEN];
+    uint64_t lap; /*!< Start of current lap */
+};
+typedef struct _svo_stats_t svo_stats_t;
+
+
+/**
+ * Sets all counters to zero.
+ */
+void svoStatsReset(svo_stats_t *s);
+
+/**
+ * Returns name of phase.
+ */
+const char *svoStatsName(int phase);
+
+/**
+ * Prints non-zero counters of all phases, one phase per line in format
+ * "name calls ns ns/call".
+ */
+void svoStatsPrint(const svo_stats_t *s, FILE *out);
+
+
+/**
+ * Measuring is done by lap timer: SVO_STATS_START(stats) starts new lap,
+ * SVO_STATS_LAP(stats, phase) charges time elapsed from start of the lap
+ * to {phase} and starts next lap. So only entry points of learning start
+ * the timer and all functions called from there just close laps.
+ * Both expand to nothing unless SVO_STATS is defined.
+ */
+#ifdef SVO_STATS
+# define SVO_STATS_START(stats) ((stats)->lap = svoStatsNow())
+# define SVO_STATS_LAP(stats, ph) svoStatsLap((stats), (ph))
+#else /* SVO_STATS */
+# define SVO_STATS_START(stats) ((void)0)
+# define SVO_STATS_LAP(stats, ph) ((void)0)
+#endif /* SVO_STATS */
+
+/**
+ * Returns monotonic time in nanoseconds.
+ */
+_bor_inline uint64_t svoStatsNow(void);
+
+/**
+ * Adds time elapsed from start of current lap to {phase} and starts next
+ * lap.
+ */
+_bor_inline void svoStatsLap(svo_stats_t *s, int phase);
+
+
+/**** INLINES ****/
+_bor_inline uint64_t svoStatsNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+_bor_inline void svoStatsLap(svo_stats_t *s, int phase)
+{
+    uint64_t now;
+
+    now = svoStatsNow();
+    s->phase[phase].ns += now - s->lap;
+    s->phase[phase].calls += 1;
+    s->lap = now;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __SVO_STATS_H__ */
@@ -0,0 +1,86 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <string.h>
+#include <boruvka/alloc.h>
+#include "gng/adj.h"
+
+void svoAdjAdd(svo_adj_t *adj, uint32_t id, void *edge)
+{
+    uint32_t *ids;
+    void **edges;
+
+    if (adj->size == 0 && adj->len < SVO_ADJ_INLINE){
+        adj->u.in.ids[adj->len]   = id;
+        adj->u.in.edges[adj->len] = edge;
+        ++adj->len;
+        return;
+    }
+
+    if (adj->size == 0){
+        // move inline arrays to heap
+        ids   = BOR_ALLOC_ARR(uint32_t, 2 * SVO_ADJ_INLINE);
+        edges = BOR_ALLOC_ARR(void *, 2 * SVO_ADJ_INLINE);
+        memcpy(ids, adj->u.in.ids, sizeof(uint32_t) * adj->len);
+        memcpy(edges, adj->u.in.edges, sizeof(void *) * adj->len);
+        adj->u.spill.ids   = ids;
+        adj->u.spill.edges = edges;
+        adj->size = 2 * SVO_ADJ_INLINE;
+    }else if (adj->len == adj->size){
+        adj->size *= 2;
+        adj->u.spill.ids   = BOR_REALLOC_ARR(adj->u.spill.ids, uint32_t,
+                                             adj->size);
+        adj->u.spill.edges = BOR_REALLOC_ARR(adj->u.spill.edges, void *,
+                                             adj->size);
+    }
+
+    adj->u.spill.ids[adj->len]   = id;
+    adj->u.spill.edges[adj->len] = edge;
+    ++adj->len;
+}
+
+void svoAdjRemove(svo_adj_t *adj, uint32_t id)
+{
+    uint32_t *ids;
+    void **edges;
+    uint32_t i;
+
+    if (adj->size == 0){
+        ids   = adj->u.in.ids;
+        edges = adj->u.in.edges;
+    }else{
+        ids   = adj->u.spill.ids;
+        edges = adj->u.spill.edges;
+    }
+
+    for (i = 0; i < adj->len; i++){
+        if (ids[i] == id){
+            // order doesn't matter, move last neighbor in place of removed
+            --adj->len;
+            ids[i]   = ids[adj->len];
+            edges[i] = edges[adj->len];
+            return;
+        }
+    }
+}
+
+void __svoAdjFreeSpill(svo_adj_t *adj)
+{
+    BOR_FREE(adj->u.spill.ids);
+    BOR_FREE(adj->u.spill.edges);
+    adj->size = 0;
+    adj->len  = 0;
+}
@@ -0,0 +1,124 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <boruvka/alloc.h>
+#include "gng/edge-hash.h"
+
+/** Initial number of slots as power of two */
+#define EDGE_HASH_INIT_BITS 10
+
+static void alloc(svo_edge_hash_t *h, int bits)
+{
+    size_t i;
+
+    h->size  = (size_t)1 << bits;
+    h->shift = 64 - bits;
+    h->keys  = BOR_ALLOC_ARR(uint64_t, h->size);
+    h->edges = BOR_ALLOC_ARR(void *, h->size);
+    for (i = 0; i < h->size; i++)
+        h->keys[i] = SVO_EDGE_HASH_EMPTY;
+}
+
+_bor_inline void insert(svo_edge_hash_t *h, uint64_t key, void *edge)
+{
+    size_t i, mask;
+
+    mask = h->size - 1;
+    for (i = __svoEdgeHashSlot(h, key);
+            h->keys[i] != SVO_EDGE_HASH_EMPTY; i = (i + 1) & mask);
+    h->keys[i]  = key;
+    h->edges[i] = edge;
+}
+
+static void grow(svo_edge_hash_t *h)
+{
+    uint64_t *keys;
+    void **edges;
+    size_t i, size;
+
+    keys  = h->keys;
+    edges = h->edges;
+    size  = h->size;
+
+    alloc(h, 64 - h->shift + 1);
+    for (i = 0; i < size; i++){
+        if (keys[i] != SVO_EDGE_HASH_EMPTY)
+            insert(h, keys[i], edges[i]);
+    }
+
+    BOR_FREE(keys);
+    BOR_FREE(edges);
+}
+
+void svoEdgeHashInit(svo_edge_hash_t *h)
+{
+    alloc(h, EDGE_HASH_INIT_BITS);
+    h->len = 0;
+}
+
+void svoEdgeHashFree(svo_edge_hash_t *h)
+{
+    BOR_FREE(h->keys);
+    BOR_FREE(h->edges);
+    h->keys  = NULL;
+    h->edges = NULL;
+    h->size  = h->len = 0;
+}
+
+void svoEdgeHashAdd(svo_edge_hash_t *h, uint32_t id1, uint32_t id2,
+                    void *edge)
+{
+    if (2 * (h->len + 1) > h->size)
+        grow(h);
+
+    insert(h, __svoEdgeHashKey(id1, id2), edge);
+    ++h->len;
+}
+
+void svoEdgeHashRemove(svo_edge_hash_t *h, uint32_t id1, uint32_t id2)
+{
+    uint64_t key;
+    size_t i, j, k, mask;
+
+    key  = __svoEdgeHashKey(id1, id2);
+    mask = h->size - 1;
+    for (i = __svoEdgeHashSlot(h, key); h->keys[i] != key; i = (i + 1) & mask){
+        if (h->keys[i] == SVO_EDGE_HASH_EMPTY)
+            return;
+    }
+
+    // shift back following entries of the cluster which would be
+    // unreachable otherwise
+    j = i;
+    while (1){
+        j = (j + 1) & mask;
+        if (h->keys[j] == SVO_EDGE_HASH_EMPTY)
+            break;
+
+        // k is home slot of entry at j, the entry can be moved to i only
+        // if k doesn't lie cyclically in (i, j]
+        k = __svoEdgeHashSlot(h, h->keys[j]);
+        if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        h->keys[i]  = h->keys[j];
+        h->edges[i] = h->edges[j];
+        i = j;
+    }
+
+    h->keys[i] = SVO_EDGE_HASH_EMPTY;
+    --h->len;
+}
@@ -0,0 +1,142 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <boruvka/alloc.h>
+#include "gng/err-tree.h"
+
+/** Initial number of leaves */
+#define ERR_TREE_INIT_CAP 64
+
+/** Returns id with highest error in subtree of (inner or leaf) node i */
+_bor_inline int subtreeWin(const svo_err_tree_t *t, int i)
+{
+    if (i >= t->cap)
+        return i - t->cap;
+    return t->win[i];
+}
+
+/** Recomputes inner node i from its children */
+_bor_inline void fixNode(svo_err_tree_t *t, int i)
+{
+    int l, r;
+
+    l = subtreeWin(t, 2 * i);
+    r = subtreeWin(t, 2 * i + 1);
+    t->win[i] = (t->err[l] >= t->err[r] ? l : r);
+}
+
+/** Recomputes path from leaf of given id to the root */
+_bor_inline void fixPath(svo_err_tree_t *t, int id)
+{
+    int i;
+
+    for (i = (t->cap + id) / 2; i >= 1; i /= 2)
+        fixNode(t, i);
+}
+
+/** Doubles number of leaves and rebuilds all inner nodes */
+static void grow(svo_err_tree_t *t)
+{
+    int i, cap;
+
+    cap = 2 * t->cap;
+    t->els       = BOR_REALLOC_ARR(t->els, svo_err_tree_el_t *, cap);
+    t->err       = BOR_REALLOC_ARR(t->err, bor_real_t, cap);
+    t->win       = BOR_REALLOC_ARR(t->win, int, cap);
+    t->dirty     = BOR_REALLOC_ARR(t->dirty, char, cap);
+    t->dirty_ids = BOR_REALLOC_ARR(t->dirty_ids, int, cap);
+    t->free_ids  = BOR_REALLOC_ARR(t->free_ids, int, cap);
+
+    for (i = t->cap; i < cap; i++){
+        t->els[i]   = NULL;
+        t->err[i]   = -BOR_REAL_MAX;
+        t->dirty[i] = 0;
+    }
+    t->cap = cap;
+
+    for (i = cap - 1; i >= 1; i--)
+        fixNode(t, i);
+}
+
+void svoErrTreeInit(svo_err_tree_t *t)
+{
+    int i;
+
+    t->cap = ERR_TREE_INIT_CAP;
+    t->len = 0;
+
+    t->els       = BOR_ALLOC_ARR(svo_err_tree_el_t *, t->cap);
+    t->err       = BOR_ALLOC_ARR(bor_real_t, t->cap);
+    t->win       = BOR_ALLOC_ARR(int, t->cap);
+    t->dirty     = BOR_ALLOC_ARR(char, t->cap);
+    t->dirty_ids = BOR_ALLOC_ARR(int, t->cap);
+    t->free_ids  = BOR_ALLOC_ARR(int, t->cap);
+    t->dirty_len = 0;
+    t->free_len  = 0;
+
+    for (i = 0; i < t->cap; i++){
+        t->els[i]   = NULL;
+        t->err[i]   = -BOR_REAL_MAX;
+        t->dirty[i] = 0;
+    }
+    for (i = t->cap - 1; i >= 1; i--)
+        fixNode(t, i);
+}
+
+void svoErrTreeFree(svo_err_tree_t *t)
+{
+    BOR_FREE(t->els);
+    BOR_FREE(t->err);
+    BOR_FREE(t->win);
+    BOR_FREE(t->dirty);
+    BOR_FREE(t->dirty_ids);
+    BOR_FREE(t->free_ids);
+}
+
+void svoErrTreeAdd(svo_err_tree_t *t, svo_err_tree_el_t *el, bor_real_t err)
+{
+    if (t->free_len > 0){
+        el->id = t->free_ids[--t->free_len];
+    }else{
+        if (t->len == t->cap)
+            grow(t);
+        el->id = t->len++;
+    }
+
+    t->els[el->id] = el;
+    svoErrTreeUpdate(t, el, err);
+}
+
+void svoErrTreeRemove(svo_err_tree_t *t, svo_err_tree_el_t *el)
+{
+    svoErrTreeUpdate(t, el, -BOR_REAL_MAX);
+    t->els[el->id] = NULL;
+    t->free_ids[t->free_len++] = el->id;
+}
+
+svo_err_tree_el_t *svoErrTreeMax(svo_err_tree_t *t)
+{
+    int i, id;
+
+    for (i = 0; i < t->dirty_len; i++){
+        id = t->dirty_ids[i];
+        t->dirty[id] = 0;
+        fixPath(t, id);
+    }
+    t->dirty_len = 0;
+
+    return t->els[t->win[1]];
+}
@@ -0,0 +1,472 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include "gng/gng-eu-kernel.h"
+
+#if defined(__GNUC__) \
+        && (defined(__x86_64__) || defined(__i386__)) \
+        && !defined(SVO_NO_SIMD)
+# define KERNEL_X86
+# include <immintrin.h>
+#endif
+
+
+/*** Generic kernels ***/
+static bor_real_t dist2Generic(int dim, const bor_vec_t *a,
+                               const bor_vec_t *b)
+{
+    bor_real_t d, dist;
+    int i;
+
+    dist = BOR_ZERO;
+    for (i = 0; i < dim; i++){
+        d = a[i] - b[i];
+        dist += d * d;
+    }
+    return dist;
+}
+
+static void moveTowardsGeneric(int dim, bor_vec_t *w, const bor_vec_t *x,
+                               bor_real_t fraction)
+{
+    int i;
+
+    for (i = 0; i < dim; i++){
+        w[i] += (x[i] - w[i]) * fraction;
+    }
+}
+
+static void betweenGeneric(int dim, bor_vec_t *out, const bor_vec_t *a,
+                           const bor_vec_t *b)
+{
+    int i;
+
+    for (i = 0; i < dim; i++){
+        out[i] = (a[i] + b[i]) * BOR_REAL(0.5);
+    }
+}
+
+static const svo_gng_eu_kernel_t kernel_generic = {
+    "generic", dist2Generic, moveTowardsGeneric, betweenGeneric
+};
+
+
+
+/*** Kernels with fixed dimension ***/
+#if defined(__GNUC__) && __GNUC__ >= 8 && !defined(__clang__)
+# define UNROLL _Pragma("GCC unroll 64")
+#else
+# define UNROLL
+#endif
+
+/**
+ * Defines kernel {name} with dimension fixed to {N}.
+ * The loops have constant number of iterations so compiler unrolls (and
+ * vectorizes) them completely. {target} is function attribute
+ * specifying instruction set the kernel is compiled for.
+ */
+#define KERNEL_FIXED(name, N, target) \
+    target static bor_real_t dist2##name(int dim, const bor_vec_t *a, \
+                                         const bor_vec_t *b) \
+    { \
+        bor_real_t d, dist = BOR_ZERO; \
+        int i; \
+        UNROLL \
+        for (i = 0; i < (N); i++){ \
+            d = a[i] - b[i]; \
+            dist += d * d; \
+        } \
+        return dist; \
+    } \
+    target static void moveTowards##name(int dim, bor_vec_t *w, \
+                                         const bor_vec_t *x, \
+                                         bor_real_t fraction) \
+    { \
+        int i; \
+        UNROLL \
+        for (i = 0; i < (N); i++){ \
+            w[i] += (x[i] - w[i]) * fraction; \
+        } \
+    } \
+    target static void between##name(int dim, bor_vec_t *out, \
+                                     const bor_vec_t *a, \
+                                     const bor_vec_t *b) \
+    { \
+        int i; \
+        UNROLL \
+        for (i = 0; i < (N); i++){ \
+            out[i] = (a[i] + b[i]) * BOR_REAL(0.5); \
+        } \
+    } \
+    static const svo_gng_eu_kernel_t kernel_##name = { \
+        #name, dist2##name, moveTowards##name, between##name \
+    }
+
+KERNEL_FIXED(fixed2, 2, );
+KERNEL_FIXED(fixed3, 3, );
+KERNEL_FIXED(fixed4, 4, );
+KERNEL_FIXED(fixed6, 6, );
+KERNEL_FIXED(fixed8, 8, );
+KERNEL_FIXED(fixed12, 12, );
+KERNEL_FIXED(fixed16, 16, );
+KERNEL_FIXED(fixed32, 32, );
+KERNEL_FIXED(fixed64, 64, );
+
+
+
+#ifdef KERNEL_X86
+
+#define TARGET_SSE2   __attribute__((target("sse2")))
+#define TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+/** Mapping of SIMD types and intrinsics to bor_real_t */
+#ifdef BOR_SINGLE
+# define SSE_T            __m128
+# define SSE_LANES        4
+# define SSE_ZERO()       _mm_setzero_ps()
+# define SSE_SET1(x)      _mm_set1_ps(x)
+# define SSE_LOAD(p)      _mm_loadu_ps(p)
+# define SSE_STORE(p, v)  _mm_storeu_ps((p), (v))
+# define SSE_ADD(a, b)    _mm_add_ps((a), (b))
+# define SSE_SUB(a, b)    _mm_sub_ps((a), (b))
+# define SSE_MUL(a, b)    _mm_mul_ps((a), (b))
+
+# define AVX_T            __m256
+# define AVX_LANES        8
+# define AVX_ZERO()       _mm256_setzero_ps()
+# define AVX_SET1(x)      _mm256_set1_ps(x)
+# define AVX_LOAD(p)      _mm256_loadu_ps(p)
+# define AVX_STORE(p, v)  _mm256_storeu_ps((p), (v))
+# define AVX_ADD(a, b)    _mm256_add_ps((a), (b))
+# define AVX_SUB(a, b)    _mm256_sub_ps((a), (b))
+# define AVX_MUL(a, b)    _mm256_mul_ps((a), (b))
+# define AVX_FMADD(a, b, c) _mm256_fmadd_ps((a), (b), (c))
+# define AVX_LO(v)        _mm256_castps256_ps128(v)
+# define AVX_HI(v)        _mm256_extractf128_ps((v), 1)
+
+# define AVX512_T            __m512
+# define AVX512_LANES        16
+# define AVX512_MASK         __mmask16
+# define AVX512_ZERO()       _mm512_setzero_ps()
+# define AVX512_SET1(x)      _mm512_set1_ps(x)
+# define AVX512_LOAD(p)      _mm512_loadu_ps(p)
+# define AVX512_MLOAD(m, p)  _mm512_maskz_loadu_ps((m), (p))
+# define AVX512_STORE(p, v)  _mm512_storeu_ps((p), (v))
+# define AVX512_MSTORE(p, m, v) _mm512_mask_storeu_ps((p), (m), (v))
+# define AVX512_SUB(a, b)    _mm512_sub_ps((a), (b))
+# define AVX512_ADD(a, b)    _mm512_add_ps((a), (b))
+# define AVX512_FMADD(a, b, c) _mm512_fmadd_ps((a), (b), (c))
+# define AVX512_HSUM(v)      _mm512_reduce_add_ps(v)
+
+TARGET_SSE2 static inline bor_real_t sseHSum(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+#else /* BOR_SINGLE */
+# define SSE_T            __m128d
+# define SSE_LANES        2
+# define SSE_ZERO()       _mm_setzero_pd()
+# define SSE_SET1(x)      _mm_set1_pd(x)
+# define SSE_LOAD(p)      _mm_loadu_pd(p)
+# define SSE_STORE(p, v)  _mm_storeu_pd((p), (v))
+# define SSE_ADD(a, b)    _mm_add_pd((a), (b))
+# define SSE_SUB(a, b)    _mm_sub_pd((a), (b))
+# define SSE_MUL(a, b)    _mm_mul_pd((a), (b))
+
+# define AVX_T            __m256d
+# define AVX_LANES        4
+# define AVX_ZERO()       _mm256_setzero_pd()
+# define AVX_SET1(x)      _mm256_set1_pd(x)
+# define AVX_LOAD(p)      _mm256_loadu_pd(p)
+# define AVX_STORE(p, v)  _mm256_storeu_pd((p), (v))
+# define AVX_ADD(a, b)    _mm256_add_pd((a), (b))
+# define AVX_SUB(a, b)    _mm256_sub_pd((a), (b))
+# define AVX_MUL(a, b)    _mm256_mul_pd((a), (b))
+# define AVX_FMADD(a, b, c) _mm256_fmadd_pd((a), (b), (c))
+# define AVX_LO(v)        _mm256_castpd256_pd128(v)
+# define AVX_HI(v)        _mm256_extractf128_pd((v), 1)
+
+# define AVX512_T            __m512d
+# define AVX512_LANES        8
+# define AVX512_MASK         __mmask8
+# define AVX512_ZERO()       _mm512_setzero_pd()
+# define AVX512_SET1(x)      _mm512_set1_pd(x)
+# define AVX512_LOAD(p)      _mm512_loadu_pd(p)
+# define AVX512_MLOAD(m, p)  _mm512_maskz_loadu_pd((m), (p))
+# define AVX512_STORE(p, v)  _mm512_storeu_pd((p), (v))
+# define AVX512_MSTORE(p, m, v) _mm512_mask_storeu_pd((p), (m), (v))
+# define AVX512_SUB(a, b)    _mm512_sub_pd((a), (b))
+# define AVX512_ADD(a, b)    _mm512_add_pd((a), (b))
+# define AVX512_FMADD(a, b, c) _mm512_fmadd_pd((a), (b), (c))
+# define AVX512_HSUM(v)      _mm512_reduce_add_pd(v)
+
+TARGET_SSE2 static inline bor_real_t sseHSum(__m128d v)
+{
+    v = _mm_add_sd(v, _mm_unpackhi_pd(v, v));
+    return _mm_cvtsd_f64(v);
+}
+#endif /* BOR_SINGLE */
+
+
+/*** SSE2 kernels ***/
+TARGET_SSE2 static bor_real_t dist2SSE2(int dim, const bor_vec_t *a,
+                                        const bor_vec_t *b)
+{
+    SSE_T s0, s1, d0, d1;
+    bor_real_t d, dist;
+    int i;
+
+    s0 = s1 = SSE_ZERO();
+    for (i = 0; i + 2 * SSE_LANES <= dim; i += 2 * SSE_LANES){
+        d0 = SSE_SUB(SSE_LOAD(a + i), SSE_LOAD(b + i));
+        d1 = SSE_SUB(SSE_LOAD(a + i + SSE_LANES), SSE_LOAD(b + i + SSE_LANES));
+        s0 = SSE_ADD(s0, SSE_MUL(d0, d0));
+        s1 = SSE_ADD(s1, SSE_MUL(d1, d1));
+    }
+    for (; i + SSE_LANES <= dim; i += SSE_LANES){
+        d0 = SSE_SUB(SSE_LOAD(a + i), SSE_LOAD(b + i));
+        s0 = SSE_ADD(s0, SSE_MUL(d0, d0));
+    }
+
+    dist = sseHSum(SSE_ADD(s0, s1));
+    for (; i < dim; i++){
+        d = a[i] - b[i];
+        dist += d * d;
+    }
+
+    return dist;
+}
+
+TARGET_SSE2 static void moveTowardsSSE2(int dim, bor_vec_t *w,
+                                        const bor_vec_t *x,
+                                        bor_real_t fraction)
+{
+    SSE_T f, v;
+    int i;
+
+    f = SSE_SET1(fraction);
+    for (i = 0; i + SSE_LANES <= dim; i += SSE_LANES){
+        v = SSE_LOAD(w + i);
+        v = SSE_ADD(v, SSE_MUL(SSE_SUB(SSE_LOAD(x + i), v), f));
+        SSE_STORE(w + i, v);
+    }
+    for (; i < dim; i++){
+        w[i] += (x[i] - w[i]) * fraction;
+    }
+}
+
+static const svo_gng_eu_kernel_t kernel_sse2 = {
+    "sse2", dist2SSE2, moveTowardsSSE2, betweenGeneric
+};
+
+
+/*** AVX2 kernels ***/
+TARGET_AVX2 static bor_real_t dist2AVX2(int dim, const bor_vec_t *a,
+                                        const bor_vec_t *b)
+{
+    AVX_T s0, s1, d0, d1;
+    bor_real_t d, dist;
+    int i;
+
+    s0 = s1 = AVX_ZERO();
+    for (i = 0; i + 2 * AVX_LANES <= dim; i += 2 * AVX_LANES){
+        d0 = AVX_SUB(AVX_LOAD(a + i), AVX_LOAD(b + i));
+        d1 = AVX_SUB(AVX_LOAD(a + i + AVX_LANES), AVX_LOAD(b + i + AVX_LANES));
+        s0 = AVX_FMADD(d0, d0, s0);
+        s1 = AVX_FMADD(d1, d1, s1);
+    }
+    for (; i + AVX_LANES <= dim; i += AVX_LANES){
+        d0 = AVX_SUB(AVX_LOAD(a + i), AVX_LOAD(b + i));
+        s0 = AVX_FMADD(d0, d0, s0);
+    }
+
+    s0 = AVX_ADD(s0, s1);
+    dist = sseHSum(SSE_ADD(AVX_LO(s0), AVX_HI(s0)));
+    for (; i < dim; i++){
+        d = a[i] - b[i];
+        dist += d * d;
+    }
+
+    return dist;
+}
+
+TARGET_AVX2 static void moveTowardsAVX2(int dim, bor_vec_t *w,
+                                        const bor_vec_t *x,
+                                        bor_real_t fraction)
+{
+    AVX_T f, v;
+    int i;
+
+    f = AVX_SET1(fraction);
+    for (i = 0; i + AVX_LANES <= dim; i += AVX_LANES){
+        v = AVX_LOAD(w + i);
+        v = AVX_FMADD(AVX_SUB(AVX_LOAD(x + i), v), f, v);
+        AVX_STORE(w + i, v);
+    }
+    for (; i < dim; i++){
+        w[i] += (x[i] - w[i]) * fraction;
+    }
+}
+
+TARGET_AVX2 static void betweenAVX2(int dim, bor_vec_t *out,
+                                    const bor_vec_t *a, const bor_vec_t *b)
+{
+    AVX_T h;
+    int i;
+
+    h = AVX_SET1(BOR_REAL(0.5));
+    for (i = 0; i + AVX_LANES <= dim; i += AVX_LANES){
+        AVX_STORE(out + i, AVX_MUL(AVX_ADD(AVX_LOAD(a + i), AVX_LOAD(b + i)), h));
+    }
+    for (; i < dim; i++){
+        out[i] = (a[i] + b[i]) * BOR_REAL(0.5);
+    }
+}
+
+static const svo_gng_eu_kernel_t kernel_avx2 = {
+    "avx2", dist2AVX2, moveTowardsAVX2, betweenAVX2
+};
+
+KERNEL_FIXED(fixed8_avx2, 8, TARGET_AVX2);
+KERNEL_FIXED(fixed12_avx2, 12, TARGET_AVX2);
+KERNEL_FIXED(fixed16_avx2, 16, TARGET_AVX2);
+KERNEL_FIXED(fixed32_avx2, 32, TARGET_AVX2);
+KERNEL_FIXED(fixed64_avx2, 64, TARGET_AVX2);
+
+
+/*** AVX-512 kernels ***/
+TARGET_AVX512 static bor_real_t dist2AVX512(int dim, const bor_vec_t *a,
+                                            const bor_vec_t *b)
+{
+    AVX512_T s0, s1, d0, d1;
+    AVX512_MASK m;
+    int i;
+
+    s0 = s1 = AVX512_ZERO();
+    for (i = 0; i + 2 * AVX512_LANES <= dim; i += 2 * AVX512_LANES){
+        d0 = AVX512_SUB(AVX512_LOAD(a + i), AVX512_LOAD(b + i));
+        d1 = AVX512_SUB(AVX512_LOAD(a + i + AVX512_LANES),
+                        AVX512_LOAD(b + i + AVX512_LANES));
+        s0 = AVX512_FMADD(d0, d0, s0);
+        s1 = AVX512_FMADD(d1, d1, s1);
+    }
+    for (; i + AVX512_LANES <= dim; i += AVX512_LANES){
+        d0 = AVX512_SUB(AVX512_LOAD(a + i), AVX512_LOAD(b + i));
+        s0 = AVX512_FMADD(d0, d0, s0);
+    }
+    if (i < dim){
+        // masked tail, masked-out lanes are loaded as zeros
+        m  = (AVX512_MASK)((1u << (dim - i)) - 1u);
+        d0 = AVX512_SUB(AVX512_MLOAD(m, a + i), AVX512_MLOAD(m, b + i));
+        s1 = AVX512_FMADD(d0, d0, s1);
+    }
+
+    return AVX512_HSUM(AVX512_ADD(s0, s1));
+}
+
+TARGET_AVX512 static void moveTowardsAVX512(int dim, bor_vec_t *w,
+                                            const bor_vec_t *x,
+                                            bor_real_t fraction)
+{
+    AVX512_T f, v;
+    AVX512_MASK m;
+    int i;
+
+    f = AVX512_SET1(fraction);
+    for (i = 0; i + AVX512_LANES <= dim; i += AVX512_LANES){
+        v = AVX512_LOAD(w + i);
+        v = AVX512_FMADD(AVX512_SUB(AVX512_LOAD(x + i), v), f, v);
+        AVX512_STORE(w + i, v);
+    }
+    if (i < dim){
+        m = (AVX512_MASK)((1u << (dim - i)) - 1u);
+        v = AVX512_MLOAD(m, w + i);
+        v = AVX512_FMADD(AVX512_SUB(AVX512_MLOAD(m, x + i), v), f, v);
+        AVX512_MSTORE(w + i, m, v);
+    }
+}
+
+static const svo_gng_eu_kernel_t kernel_avx512 = {
+    "avx512", dist2AVX512, moveTowardsAVX512, betweenAVX2
+};
+
+#endif /* KERNEL_X86 */
+
+
+
+/** Table of kernels with fixed dimension */
+struct _kernel_fixed_t {
+    int dim;
+    const svo_gng_eu_kernel_t *kernel;
+    const svo_gng_eu_kernel_t *kernel_avx2; /*!< NULL if not available */
+};
+typedef struct _kernel_fixed_t kernel_fixed_t;
+
+#ifdef KERNEL_X86
+# define FIXED_AVX2(name) &kernel_##name##_avx2
+#else /* KERNEL_X86 */
+# define FIXED_AVX2(name) NULL
+#endif /* KERNEL_X86 */
+
+static const kernel_fixed_t kernels_fixed[] = {
+    {  2, &kernel_fixed2,  NULL },
+    {  3, &kernel_fixed3,  NULL },
+    {  4, &kernel_fixed4,  NULL },
+    {  6, &kernel_fixed6,  NULL },
+    {  8, &kernel_fixed8,  FIXED_AVX2(fixed8) },
+    { 12, &kernel_fixed12, FIXED_AVX2(fixed12) },
+    { 16, &kernel_fixed16, FIXED_AVX2(fixed16) },
+    { 32, &kernel_fixed32, FIXED_AVX2(fixed32) },
+    { 64, &kernel_fixed64, FIXED_AVX2(fixed64) },
+};
+#define KERNELS_FIXED_LEN (sizeof(kernels_fixed) / sizeof(kernel_fixed_t))
+
+const svo_gng_eu_kernel_t *svoGNGEuKernel(int dim)
+{
+    size_t i;
+
+#ifdef KERNEL_X86
+    __builtin_cpu_init();
+#endif /* KERNEL_X86 */
+
+    for (i = 0; i < KERNELS_FIXED_LEN; i++){
+        if (kernels_fixed[i].dim != dim)
+            continue;
+
+#ifdef KERNEL_X86
+        if (kernels_fixed[i].kernel_avx2
+                && __builtin_cpu_supports("avx2")
+                && __builtin_cpu_supports("fma"))
+            return kernels_fixed[i].kernel_avx2;
+#endif /* KERNEL_X86 */
+        return kernels_fixed[i].kernel;
+    }
+
+#ifdef KERNEL_X86
+    if (__builtin_cpu_supports("avx512f"))
+        return &kernel_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return &kernel_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return &kernel_sse2;
+#endif /* KERNEL_X86 */
+
+    return &kernel_generic;
+}
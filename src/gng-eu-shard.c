@@ -0,0 +1,434 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <boruvka/alloc.h>
+#include "gng/gng-eu-shard.h"
+#include "gng/parallel.h"
+
+/** Maximal number of points used for estimation of slab borders */
+#define BORDERS_SAMPLE 65536
+
+/** Growing array of input signals */
+struct _signals_t {
+    const bor_vec_t **s;
+    size_t len, size;
+};
+typedef struct _signals_t signals_t;
+
+struct _shard_t {
+    svo_gng_eu_t *gng;
+    signals_t signals;    /*!< Signals of slab including halo */
+    size_t core_len;      /*!< Number of signals without halo */
+    size_t max_nodes;     /*!< Share of overall number of nodes */
+    bor_real_t *aabb;     /*!< Bounding box of slab including halo */
+    svo_rng_t rng;        /*!< Stream of random generator */
+};
+typedef struct _shard_t shard_t;
+
+struct _sharding_t {
+    const svo_gng_eu_shard_params_t *params;
+    int dim;
+    int axis;             /*!< Axis along which the space is split */
+    bor_real_t *borders;  /*!< Inner borders of slabs (num_shards - 1) */
+    bor_real_t halo;      /*!< Absolute width of halo */
+    shard_t *shards;
+    signals_t stitch;     /*!< Signals near borders */
+};
+typedef struct _sharding_t sharding_t;
+
+
+static void signalsAdd(signals_t *s, const bor_vec_t *v);
+static void signalsFree(signals_t *s);
+/** Finds out axis and borders of slabs */
+static void shardingBorders(sharding_t *sh, bor_pc_t *pc,
+                            const bor_real_t *aabb);
+/** Distributes input signals between shards */
+static void shardingSignals(sharding_t *sh, bor_pc_t *pc);
+/** Returns index of slab the coordinate {x} belongs to */
+static int shardOf(const sharding_t *sh, bor_real_t x);
+/** Runs GNGEu of shards in range [from, to) */
+static void shardRun(size_t from, size_t to, int thread_id, void *data);
+/** Merges shards into one net */
+static void shardingMerge(sharding_t *sh, svo_gng_eu_t *gng);
+/** Reconnects shards in merged net */
+static void shardingStitch(sharding_t *sh, svo_gng_eu_t *gng);
+
+
+void svoGNGEuShardParamsInit(svo_gng_eu_shard_params_t *params)
+{
+    svoGNGEuParamsInit(&params->gng);
+    params->num_shards   = 4;
+    params->halo         = 0.1;
+    params->max_nodes    = 1000;
+    params->stitch_steps = 20 * params->gng.lambda;
+}
+
+svo_gng_eu_t *svoGNGEuShardTrain(const svo_gng_eu_shard_params_t *params,
+                                 const svo_gng_eu_ops_t *ops,
+                                 bor_pc_t *pc)
+{
+    sharding_t sh;
+    svo_gng_eu_params_t gparams;
+    svo_gng_eu_ops_t gops;
+    svo_gng_eu_t *gng;
+    bor_real_t *aabb;
+    int i;
+
+    if (params->num_shards < 1){
+        fprintf(stderr, "GNGEu Shard Error: Number of shards must be positive.\n");
+        exit(-1);
+    }
+
+    sh.params = params;
+    sh.dim    = params->gng.dim;
+    sh.shards = BOR_ALLOC_ARR(shard_t, params->num_shards);
+    sh.borders = BOR_ALLOC_ARR(bor_real_t, params->num_shards);
+    sh.stitch.s = NULL;
+    sh.stitch.len = sh.stitch.size = 0;
+
+    // bounding box of all input signals
+    aabb = BOR_ALLOC_ARR(bor_real_t, 2 * sh.dim);
+    if (params->gng.nn.gug.aabb){
+        for (i = 0; i < 2 * sh.dim; i++)
+            aabb[i] = params->gng.nn.gug.aabb[i];
+    }else{
+        borPCAABB(pc, aabb);
+    }
+
+    // split input space into slabs
+    shardingBorders(&sh, pc, aabb);
+    for (i = 0; i < params->num_shards; i++){
+        sh.shards[i].gng = NULL;
+        sh.shards[i].signals.s = NULL;
+        sh.shards[i].signals.len = sh.shards[i].signals.size = 0;
+        sh.shards[i].core_len = 0;
+        svoRngInitStream(&sh.shards[i].rng, params->gng.seed, 1 + i);
+    }
+    shardingSignals(&sh, pc);
+
+    // train each shard in its own thread
+    svoParallelFor(params->num_shards, params->num_shards, shardRun, &sh);
+
+    // merge shards into one net
+    gparams = params->gng;
+    gparams.nn.gug.aabb = aabb;
+    if (ops){
+        gops = *ops;
+    }else{
+        svoGNGEuOpsInit(&gops);
+    }
+    gng = svoGNGEuNew(&gops, &gparams);
+    shardingMerge(&sh, gng);
+    shardingStitch(&sh, gng);
+
+    for (i = 0; i < params->num_shards; i++){
+        if (sh.shards[i].gng)
+            svoGNGEuDel(sh.shards[i].gng);
+        signalsFree(&sh.shards[i].signals);
+        BOR_FREE(sh.shards[i].aabb);
+    }
+    signalsFree(&sh.stitch);
+    BOR_FREE(sh.shards);
+    BOR_FREE(sh.borders);
+    BOR_FREE(aabb);
+
+    return gng;
+}
+
+
+static void signalsAdd(signals_t *s, const bor_vec_t *v)
+{
+    if (s->len == s->size){
+        s->size = (s->size == 0 ? 1024 : 2 * s->size);
+        s->s = BOR_REALLOC_ARR(s->s, const bor_vec_t *, s->size);
+    }
+    s->s[s->len++] = v;
+}
+
+static void signalsFree(signals_t *s)
+{
+    if (s->s)
+        BOR_FREE(s->s);
+    s->s = NULL;
+    s->len = s->size = 0;
+}
+
+static int realCmp(const void *a, const void *b)
+{
+    bor_real_t x = *(const bor_real_t *)a;
+    bor_real_t y = *(const bor_real_t *)b;
+
+    if (x < y)
+        return -1;
+    if (x > y)
+        return 1;
+    return 0;
+}
+
+static void shardingBorders(sharding_t *sh, bor_pc_t *pc,
+                            const bor_real_t *aabb)
+{
+    bor_pc_it_t it;
+    bor_real_t *sample, extent, best;
+    size_t len, step, i, sample_len;
+    int num, d, s;
+
+    num = sh->params->num_shards;
+
+    // the longest axis
+    best = -BOR_ONE;
+    sh->axis = 0;
+    for (d = 0; d < sh->dim; d++){
+        extent = aabb[2 * d + 1] - aabb[2 * d];
+        if (extent > best){
+            best = extent;
+            sh->axis = d;
+        }
+    }
+    sh->halo = sh->params->halo * best / num;
+
+    // borders are quantiles of coordinates along the axis estimated from
+    // regularly sampled points
+    len  = borPCLen(pc);
+    step = len / BORDERS_SAMPLE + 1;
+    sample = BOR_ALLOC_ARR(bor_real_t, len / step + 1);
+    sample_len = 0;
+    i = 0;
+    borPCItInit(&it, pc);
+    while (!borPCItEnd(&it)){
+        if (i % step == 0)
+            sample[sample_len++] = borPCItGet(&it)[sh->axis];
+        borPCItNext(&it);
+        ++i;
+    }
+    qsort(sample, sample_len, sizeof(bor_real_t), realCmp);
+
+    for (s = 1; s < num; s++){
+        if (sample_len > 0){
+            sh->borders[s - 1] = sample[(sample_len * s) / num];
+        }else{
+            sh->borders[s - 1] = aabb[2 * sh->axis] + (best * s) / num;
+        }
+    }
+
+    // bounding boxes of slabs including halo
+    for (s = 0; s < num; s++){
+        sh->shards[s].aabb = BOR_ALLOC_ARR(bor_real_t, 2 * sh->dim);
+        for (d = 0; d < 2 * sh->dim; d++)
+            sh->shards[s].aabb[d] = aabb[d];
+
+        if (s > 0)
+            sh->shards[s].aabb[2 * sh->axis] = sh->borders[s - 1] - sh->halo;
+        if (s < num - 1)
+            sh->shards[s].aabb[2 * sh->axis + 1] = sh->borders[s] + sh->halo;
+    }
+
+    BOR_FREE(sample);
+}
+
+static int shardOf(const sharding_t *sh, bor_real_t x)
+{
+    int s;
+
+    for (s = 0; s < sh->params->num_shards - 1; s++){
+        if (x < sh->borders[s])
+            return s;
+    }
+    return sh->params->num_shards - 1;
+}
+
+static void shardingSignals(sharding_t *sh, bor_pc_t *pc)
+{
+    bor_pc_it_t it;
+    const bor_vec_t *v;
+    bor_real_t x;
+    int num, s, near;
+
+    num = sh->params->num_shards;
+
+    borPCItInit(&it, pc);
+    while (!borPCItEnd(&it)){
+        v = borPCItGet(&it);
+        x = v[sh->axis];
+        s = shardOf(sh, x);
+
+        signalsAdd(&sh->shards[s].signals, v);
+        sh->shards[s].core_len++;
+
+        near = 0;
+        if (s > 0 && x < sh->borders[s - 1] + sh->halo){
+            signalsAdd(&sh->shards[s - 1].signals, v);
+            near = 1;
+        }
+        if (s < num - 1 && x >= sh->borders[s] - sh->halo){
+            signalsAdd(&sh->shards[s + 1].signals, v);
+            near = 1;
+        }
+        if (near)
+            signalsAdd(&sh->stitch, v);
+
+        borPCItNext(&it);
+    }
+}
+
+
+static const bor_vec_t *shardInputSignal(void *data)
+{
+    shard_t *shard = (shard_t *)data;
+    return shard->signals.s[svoRngRange(&shard->rng, shard->signals.len)];
+}
+
+static int shardTerminate(void *data)
+{
+    shard_t *shard = (shard_t *)data;
+    return svoGNGEuNodesLen(shard->gng) >= shard->max_nodes;
+}
+
+static void shardRun(size_t from, size_t to, int thread_id, void *data)
+{
+    sharding_t *sh = (sharding_t *)data;
+    shard_t *shard;
+    svo_gng_eu_params_t params;
+    svo_gng_eu_ops_t ops;
+    size_t i, total;
+
+    total = 0;
+    for (i = 0; i < (size_t)sh->params->num_shards; i++)
+        total += sh->shards[i].core_len;
+
+    for (i = from; i < to; i++){
+        shard = sh->shards + i;
+        if (shard->signals.len < 2)
+            continue;
+
+        shard->max_nodes = (sh->params->max_nodes * shard->core_len) / total;
+        if (shard->max_nodes < 3)
+            shard->max_nodes = 3;
+
+        params = sh->params->gng;
+        params.nn.gug.aabb = shard->aabb;
+        params.num_threads = 1;
+
+        svoGNGEuOpsInit(&ops);
+        ops.input_signal = shardInputSignal;
+        ops.terminate    = shardTerminate;
+        ops.data         = shard;
+
+        shard->gng = svoGNGEuNew(&ops, &params);
+        svoGNGEuRun(shard->gng);
+    }
+}
+
+
+static void shardingMerge(sharding_t *sh, svo_gng_eu_t *gng)
+{
+    svo_gng_eu_t *sgng;
+    svo_gng_eu_node_t **map, *n, *n1, *n2;
+    svo_gng_eu_edge_t *e, *ne;
+    bor_list_t *list, *item;
+    size_t map_size;
+    int s;
+
+    map = NULL;
+    map_size = 0;
+
+    for (s = 0; s < sh->params->num_shards; s++){
+        sgng = sh->shards[s].gng;
+        if (!sgng)
+            continue;
+
+        // dense ids of shard's nodes -> nodes of merged net
+        if (sgng->weights.len > map_size){
+            map_size = sgng->weights.len;
+            map = BOR_REALLOC_ARR(map, svo_gng_eu_node_t *, map_size);
+        }
+
+        // copy nodes lying in the slab
+        list = svoGNGEuNodes(sgng);
+        BOR_LIST_FOR_EACH(list, item){
+            n = svoGNGEuNodeFromList(item);
+            map[n->id] = NULL;
+            if (shardOf(sh, n->w[sh->axis]) != s)
+                continue;
+
+            if (gng->ops.new_node){
+                n1 = gng->ops.new_node(n->w, gng->ops.new_node_data);
+            }else{
+                n1 = svoPoolAlloc(&gng->node_pool);
+            }
+            svoGNGEuNodeAdd(gng, n1, n->w);
+
+            n1->err = svoGNGEuNodeErr(sgng, n) * gng->err_scale;
+            __svoGNGEuNodeErrUpdate(gng, n1);
+
+            // keep ages of copied edges
+            n1->wins = n->wins;
+
+            map[n->id] = n1;
+        }
+
+        // copy edges between copied nodes
+        list = svoGNGEuEdges(sgng);
+        BOR_LIST_FOR_EACH(list, item){
+            e = svoGNGEuEdgeFromList(item);
+            svoGNGEuEdgeNodes(e, &n1, &n2);
+            if (!map[n1->id] || !map[n2->id])
+                continue;
+
+            ne = svoGNGEuEdgeNew(gng, map[n1->id], map[n2->id]);
+            ne->age_base = e->age_base;
+        }
+    }
+
+    if (map)
+        BOR_FREE(map);
+}
+
+static void shardingStitch(sharding_t *sh, svo_gng_eu_t *gng)
+{
+    const bor_vec_t **batch;
+    bor_list_t *list, *item, *item_tmp;
+    svo_gng_eu_node_t *n;
+    svo_rng_t rng;
+    size_t step, k, i;
+
+    if (sh->stitch.len > 0 && svoGNGEuNodesLen(gng) >= 2){
+        batch = BOR_ALLOC_ARR(const bor_vec_t *, gng->params.lambda);
+        svoRngInitStream(&rng, sh->params->gng.seed, 0);
+
+        for (step = 0; step < sh->params->stitch_steps; step += k){
+            k = sh->params->stitch_steps - step;
+            if (k > gng->params.lambda)
+                k = gng->params.lambda;
+
+            for (i = 0; i < k; i++)
+                batch[i] = sh->stitch.s[svoRngRange(&rng, sh->stitch.len)];
+            svoGNGEuLearnBatch(gng, batch, k);
+        }
+
+        BOR_FREE(batch);
+    }
+
+    // remove nodes not connected to net
+    list = svoGNGEuNodes(gng);
+    BOR_LIST_FOR_EACH_SAFE(list, item, item_tmp){
+        n = svoGNGEuNodeFromList(item);
+        if (borNetNodeEdgesLen(&n->node) == 0)
+            svoGNGEuNodeDel(gng, n);
+    }
+}
@@ -15,11 +15,15 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <boruvka/nearest-linear.h>
 #include <boruvka/vec3.h>
 #include <boruvka/alloc.h>
 #include <boruvka/dbg.h>
 #include "gng/gng-eu.h"
+#include "gng/parallel.h"
+#include "gng/snapshot.h"
+#include "gng/model.h"
 
 /** Operations for svo_gng_ops_t struct */
 static svo_gng_eu_node_t *svoGNGEuNodeNew(svo_gng_eu_t *gng, const bor_vec_t *is);
@@ -27,12 +31,22 @@ static svo_gng_eu_node_t *svoGNGEuNodeNewBetween(svo_gng_eu_t *gng,
                                                  const svo_gng_eu_node_t *n1,
                                                  const svo_gng_eu_node_t *n2);
 
-static const void *svoGNGEuInputSignal(void *);
+/** Returns next input signal, either from built-in sampler or from
+ *  ops.input_signal */
+_bor_inline const bor_vec_t *svoGNGEuInputSignal(svo_gng_eu_t *gng);
 static void svoGNGEuNearest(svo_gng_eu_t *gng,
                             const bor_vec_t *is,
                             svo_gng_eu_node_t **n1,
                             svo_gng_eu_node_t **n2);
 
+/** Applies one learning step given input signal and its two winners.
+ *  If {defer_del} is true, isolated nodes are only stored in .batch_del */
+static void learnApply(svo_gng_eu_t *gng, const bor_vec_t *is,
+                       svo_gng_eu_node_t *n1, svo_gng_eu_node_t *n2,
+                       int defer_del);
+/** Deletes nodes stored in .batch_del that are still isolated */
+static void batchDelIsolated(svo_gng_eu_t *gng);
+
 _bor_inline bor_real_t svoGNGEuDist2(svo_gng_eu_t *gng,
                                      const bor_vec_t *is,
                                      const svo_gng_eu_node_t *node);
@@ -54,8 +68,13 @@ static int errHeapLT(const bor_pairheap_node_t *n1,
 
 /** Delete callbacks */
 static void nodeFinalDel(bor_net_node_t *node, void *data);
+static void nodeFastDel(bor_net_node_t *node, void *data);
 static void delEdge(bor_net_edge_t *edge, void *data);
 
+/** Initializes and frees weight storage */
+static void weightsInit(svo_gng_eu_weights_t *ws, int dim, int store);
+static void weightsFree(svo_gng_eu_weights_t *ws);
+
 void svoGNGEuOpsInit(svo_gng_eu_ops_t *ops)
 {
     bzero(ops, sizeof(svo_gng_eu_ops_t));
@@ -74,6 +93,13 @@ void svoGNGEuParamsInit(svo_gng_eu_params_t *params)
 
     borNNParamsInit(&params->nn);
     params->nn.type = BOR_NN_GUG;
+
+    params->dense_weights = 0;
+    params->num_threads = 1;
+    params->err_index = SVO_ERR_INDEX_HEAP;
+    params->compact_adj = 0;
+    params->edge_hash = 0;
+    params->seed = 0L;
 }
 
 
@@ -82,8 +108,6 @@ svo_gng_eu_t *svoGNGEuNew(const svo_gng_eu_ops_t *ops,
 {
     svo_gng_eu_t *gng_eu;
     bor_nn_params_t nnp;
-    size_t i;
-    bor_real_t maxbeta;
 
     gng_eu = BOR_ALLOC(svo_gng_eu_t);
 
@@ -105,28 +129,27 @@ svo_gng_eu_t *svoGNGEuNew(const svo_gng_eu_ops_t *ops,
         gng_eu->ops.callback_data = gng_eu->ops.data;
 
 
-    // initialize error heap
-    gng_eu->err_heap = borPairHeapNew(errHeapLT, (void *)gng_eu);
-
-    // precompute beta^n
-    gng_eu->beta_n = BOR_ALLOC_ARR(bor_real_t, gng_eu->params.lambda);
-    gng_eu->beta_n[0] = gng_eu->params.beta;
-    for (i = 1; i < gng_eu->params.lambda; i++){
-        gng_eu->beta_n[i] = gng_eu->beta_n[i - 1] * gng_eu->params.beta;
+    // initialize error heap or tree
+    gng_eu->err_heap = NULL;
+    if (gng_eu->params.err_index == SVO_ERR_INDEX_TREE){
+        svoErrTreeInit(&gng_eu->err_tree);
+    }else{
+        gng_eu->err_heap = borPairHeapNew(errHeapLT, (void *)gng_eu);
     }
 
-    // precompute beta^(n * lambda)
-    maxbeta = gng_eu->beta_n[gng_eu->params.lambda - 1];
-    gng_eu->beta_lambda_n_len = 1000;
-    gng_eu->beta_lambda_n = BOR_ALLOC_ARR(bor_real_t, gng_eu->beta_lambda_n_len);
-    gng_eu->beta_lambda_n[0] = maxbeta;
-    for (i = 1; i < gng_eu->beta_lambda_n_len; i++){
-        gng_eu->beta_lambda_n[i] = gng_eu->beta_lambda_n[i - 1] * maxbeta;
-    }
+    if (gng_eu->params.edge_hash)
+        svoEdgeHashInit(&gng_eu->edge_hash);
+
+    // error counters
+    gng_eu->err_scale     = BOR_ONE;
+    gng_eu->err_scale_inc = BOR_ONE / gng_eu->params.beta;
 
     gng_eu->cycle = 1L;
     gng_eu->step  = 1;
 
+    svoStatsReset(&gng_eu->stats);
+    svoRngInit(&gng_eu->rng, gng_eu->params.seed);
+
 
     // initialize nncells
     nnp = params->nn;
@@ -135,6 +158,26 @@ svo_gng_eu_t *svoGNGEuNew(const svo_gng_eu_ops_t *ops,
     nnp.linear.dim = params->dim;
     gng_eu->nn = borNNNew(&nnp);
 
+    // initialize storage of weight vectors
+    weightsInit(&gng_eu->weights, gng_eu->params.dim,
+                gng_eu->params.dense_weights);
+
+    svoPoolInit(&gng_eu->node_pool, sizeof(svo_gng_eu_node_t), 0);
+    svoPoolInit(&gng_eu->edge_pool, sizeof(svo_gng_eu_edge_t), 0);
+
+    // choose vector kernels
+    gng_eu->kernel = *svoGNGEuKernel(gng_eu->params.dim);
+
+    gng_eu->workers = svoParallelPoolNew(gng_eu->params.num_threads);
+
+    gng_eu->batch_win = NULL;
+    gng_eu->batch_win_size = 0;
+    gng_eu->batch_del = NULL;
+    gng_eu->batch_del_len = gng_eu->batch_del_size = 0;
+
+    gng_eu->sampler.runs = NULL;
+    gng_eu->sampler.len = 0;
+
     // initialize temporary vector
     if (gng_eu->params.dim == 2){
         gng_eu->tmpv = (bor_vec_t *)borVec2New(BOR_ZERO, BOR_ZERO);
@@ -149,22 +192,40 @@ svo_gng_eu_t *svoGNGEuNew(const svo_gng_eu_ops_t *ops,
 
 void svoGNGEuDel(svo_gng_eu_t *gng_eu)
 {
-    if (gng_eu->beta_n)
-        BOR_FREE(gng_eu->beta_n);
-    if (gng_eu->beta_lambda_n)
-        BOR_FREE(gng_eu->beta_lambda_n);
-
     if (gng_eu->net){
-        borNetDel2(gng_eu->net, nodeFinalDel, gng_eu,
-                              delEdge, gng_eu);
+        // Nodes and edges from pools are released wholesale below, so
+        // they don't have to be unlinked from heap and nn one by one.
+        if (gng_eu->ops.del_node){
+            borNetDel2(gng_eu->net, nodeFinalDel, gng_eu,
+                                  delEdge, gng_eu);
+        }else{
+            borNetDel2(gng_eu->net, nodeFastDel, gng_eu,
+                                  delEdge, gng_eu);
+        }
     }
 
     if (gng_eu->err_heap)
         borPairHeapDel(gng_eu->err_heap);
+    if (gng_eu->params.err_index == SVO_ERR_INDEX_TREE)
+        svoErrTreeFree(&gng_eu->err_tree);
+    if (gng_eu->params.edge_hash)
+        svoEdgeHashFree(&gng_eu->edge_hash);
 
     if (gng_eu->nn)
         borNNDel(gng_eu->nn);
 
+    weightsFree(&gng_eu->weights);
+    svoPoolFree(&gng_eu->node_pool);
+    svoPoolFree(&gng_eu->edge_pool);
+
+    svoParallelPoolDel(gng_eu->workers);
+
+    if (gng_eu->batch_win)
+        BOR_FREE(gng_eu->batch_win);
+    if (gng_eu->batch_del)
+        BOR_FREE(gng_eu->batch_del);
+    svoSamplerFree(&gng_eu->sampler);
+
     if (gng_eu->params.dim == 2){
         borVec2Del((bor_vec2_t *)gng_eu->tmpv);
     }else if (gng_eu->params.dim == 3){
@@ -176,6 +237,27 @@ void svoGNGEuDel(svo_gng_eu_t *gng_eu)
     BOR_FREE(gng_eu);
 }
 
+void svoGNGEuInputSignalsPC(svo_gng_eu_t *gng_eu, bor_pc_t *pc)
+{
+    if (borPCDim(pc) != gng_eu->params.dim){
+        fprintf(stderr, "GNGEu Error: Dimension of point cloud (%d) differs"
+                        " from params.dim (%d).\n",
+                borPCDim(pc), gng_eu->params.dim);
+        exit(-1);
+    }
+
+    svoSamplerFree(&gng_eu->sampler);
+    svoSamplerInitPC(&gng_eu->sampler, pc, gng_eu->params.seed);
+}
+
+void svoGNGEuInputSignalsArr(svo_gng_eu_t *gng_eu,
+                             const bor_real_t *arr, size_t len)
+{
+    svoSamplerFree(&gng_eu->sampler);
+    svoSamplerInitArr(&gng_eu->sampler, arr, len, gng_eu->params.dim,
+                      gng_eu->params.seed);
+}
+
 
 void svoGNGEuRun(svo_gng_eu_t *gng_eu)
 {
@@ -183,7 +265,8 @@ void svoGNGEuRun(svo_gng_eu_t *gng_eu)
     size_t i;
 
     cycle = 0;
-    svoGNGEuInit(gng_eu);
+    if (svoGNGEuNodesLen(gng_eu) == 0)
+        svoGNGEuInit(gng_eu);
 
     do {
         for (i = 0; i < gng_eu->params.lambda; i++){
@@ -207,10 +290,10 @@ void svoGNGEuInit(svo_gng_eu_t *gng_eu)
     gng_eu->cycle = 1L;
     gng_eu->step  = 1;
 
-    is = gng_eu->ops.input_signal(gng_eu->ops.input_signal_data);
+    is = svoGNGEuInputSignal(gng_eu);
     n1 = svoGNGEuNodeNew(gng_eu, is);
 
-    is = gng_eu->ops.input_signal(gng_eu->ops.input_signal_data);
+    is = svoGNGEuInputSignal(gng_eu);
     n2 = svoGNGEuNodeNew(gng_eu, is);
 
     svoGNGEuEdgeNew(gng_eu, n1, n2);
@@ -219,11 +302,162 @@ void svoGNGEuInit(svo_gng_eu_t *gng_eu)
 void svoGNGEuLearn(svo_gng_eu_t *gng_eu)
 {
     const bor_vec_t *input_signal;
+    svo_gng_eu_node_t *n1, *n2;
+
+    SVO_STATS_START(&gng_eu->stats);
+
+    // 1. Get input signal
+    input_signal = svoGNGEuInputSignal(gng_eu);
+    SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_INPUT);
+
+    // 2. Find two nearest nodes to input signal
+    svoGNGEuNearest(gng_eu, input_signal, &n1, &n2);
+    SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_NEAREST);
+
+    // 3. - 7.
+    learnApply(gng_eu, input_signal, n1, n2, 0);
+}
+
+struct _batch_nearest_t {
+    svo_gng_eu_t *gng;
+    const bor_vec_t **signals;
+};
+typedef struct _batch_nearest_t batch_nearest_t;
+
+static void batchNearest(size_t from, size_t to, int thread_id, void *data)
+{
+    batch_nearest_t *b = (batch_nearest_t *)data;
+    svo_gng_eu_node_t **win;
+    size_t i;
+
+    win = b->gng->batch_win;
+    for (i = from; i < to; i++){
+        svoGNGEuNearest(b->gng, b->signals[i], &win[2 * i], &win[2 * i + 1]);
+    }
+}
+
+void svoGNGEuLearnBatch(svo_gng_eu_t *gng_eu,
+                        const bor_vec_t **signals, size_t k)
+{
+    batch_nearest_t b;
+    size_t i;
+
+    if (k > gng_eu->batch_win_size){
+        gng_eu->batch_win_size = k;
+        gng_eu->batch_win = BOR_REALLOC_ARR(gng_eu->batch_win,
+                                            svo_gng_eu_node_t *, 2 * k);
+    }
+
+    SVO_STATS_START(&gng_eu->stats);
+
+    // 1. Find two nearest nodes to all input signals in parallel, the
+    //    net isn't changed meanwhile
+    b.gng = gng_eu;
+    b.signals = signals;
+    svoParallelPoolFor(gng_eu->workers, k, batchNearest, &b);
+    SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_NEAREST);
+
+    // 2. Apply learning steps in order of signals
+    gng_eu->batch_del_len = 0;
+    for (i = 0; i < k; i++){
+        learnApply(gng_eu, signals[i], gng_eu->batch_win[2 * i],
+                   gng_eu->batch_win[2 * i + 1], 1);
+    }
+
+    // 3. Remove nodes that are still isolated
+    batchDelIsolated(gng_eu);
+    SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_PRUNE);
+}
+
+struct _quantize_t {
+    svo_gng_eu_t *gng;
+    const bor_real_t *points;
+    int *winners, *second;
+    bor_real_t *dist2;
+};
+typedef struct _quantize_t quantize_t;
+
+static void quantize(size_t from, size_t to, int thread_id, void *data)
+{
+    quantize_t *q = (quantize_t *)data;
+    svo_gng_eu_t *gng = q->gng;
+    const bor_vec_t *p;
+    bor_nn_el_t *els[2];
+    svo_gng_eu_node_t *n;
+    size_t i, found;
+
+    for (i = from; i < to; i++){
+        p = (const bor_vec_t *)(q->points + i * gng->params.dim);
+        found = borNNNearest(gng->nn, p, 2, els);
+
+        n = bor_container_of(els[0], svo_gng_eu_node_t, nn);
+        q->winners[i] = n->id;
+        if (q->dist2)
+            q->dist2[i] = gng->kernel.dist2(gng->params.dim, p, n->w);
+
+        if (q->second){
+            q->second[i] = -1;
+            if (found > 1){
+                n = bor_container_of(els[1], svo_gng_eu_node_t, nn);
+                q->second[i] = n->id;
+            }
+        }
+    }
+}
+
+void svoGNGEuQuantize(svo_gng_eu_t *gng_eu, const bor_real_t *points,
+                      size_t len, int *winners, int *second,
+                      bor_real_t *dist2)
+{
+    quantize_t q;
+    size_t i;
+
+    if (svoGNGEuNodesLen(gng_eu) == 0){
+        for (i = 0; i < len; i++){
+            winners[i] = -1;
+            if (second)
+                second[i] = -1;
+            if (dist2)
+                dist2[i] = BOR_REAL_MAX;
+        }
+        return;
+    }
+
+    q.gng     = gng_eu;
+    q.points  = points;
+    q.winners = winners;
+    q.second  = second;
+    q.dist2   = dist2;
+    svoParallelPoolFor(gng_eu->workers, len, quantize, &q);
+}
+
+static void learnDelNode(svo_gng_eu_t *gng, svo_gng_eu_node_t *n,
+                         int defer_del)
+{
+    if (!defer_del){
+        svoGNGEuNodeDel(gng, n);
+        return;
+    }
+
+    if (gng->batch_del_len == gng->batch_del_size){
+        gng->batch_del_size = (gng->batch_del_size == 0
+                                    ? 64 : 2 * gng->batch_del_size);
+        gng->batch_del = BOR_REALLOC_ARR(gng->batch_del, svo_gng_eu_node_t *,
+                                         gng->batch_del_size);
+    }
+    gng->batch_del[gng->batch_del_len++] = n;
+}
+
+static void learnApply(svo_gng_eu_t *gng_eu, const bor_vec_t *input_signal,
+                       svo_gng_eu_node_t *n1, svo_gng_eu_node_t *n2,
+                       int defer_del)
+{
     bor_net_node_t *nn;
-    svo_gng_eu_node_t *n1, *n2, *n;
+    svo_gng_eu_node_t *n;
     bor_net_edge_t *nedge;
     svo_gng_eu_edge_t *edge;
     bor_real_t dist2;
+    unsigned long age;
     bor_list_t *list, *item, *item_tmp;
 
     if (gng_eu->step > gng_eu->params.lambda){
@@ -231,24 +465,22 @@ void svoGNGEuLearn(svo_gng_eu_t *gng_eu)
         gng_eu->step = 1;
     }
 
-    // 1. Get input signal
-    input_signal = gng_eu->ops.input_signal(gng_eu->ops.input_signal_data);
-
-    // 2. Find two nearest nodes to input signal
-    svoGNGEuNearest(gng_eu, input_signal, &n1, &n2);
-
     // 3. Create connection between n1 and n2 if doesn't exist and set age
     //    to zero
     svoGNGEuHebbianLearning(gng_eu, n1, n2);
+    SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_HEBBIAN);
 
     // 4. Increase error counter of winner node
     dist2 = svoGNGEuDist2(gng_eu, input_signal, n1);
-    svoGNGEuNodeIncError(gng_eu, n1, dist2 * gng_eu->beta_n[gng_eu->params.lambda - gng_eu->step]);
+    svoGNGEuNodeIncError(gng_eu, n1, dist2);
+    SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_ERR);
 
     // 5. Adapt nodes to input signal using fractions eb and en
     // + 6. Increment age of all edges by one
     // + 7. Remove edges with age higher than age_max
     svoGNGEuMoveTowards(gng_eu, n1, input_signal, gng_eu->params.eb);
+    // all edges of winner get older by one (6.)
+    ++n1->wins;
     // adapt also direct topological neighbors of winner node
     list = borNetNodeEdges(&n1->node);
     BOR_LIST_FOR_EACH_SAFE(list, item, item_tmp){
@@ -257,18 +489,17 @@ void svoGNGEuLearn(svo_gng_eu_t *gng_eu)
         nn   = borNetEdgeOtherNode(&edge->edge, &n1->node);
         n    = bor_container_of(nn, svo_gng_eu_node_t, node);
 
-        // increase age (6.)
-        edge->age += 1;
-
         // remove edge if it has age higher than age_max (7.)
-        if (edge->age > gng_eu->params.age_max){
+        age = n1->wins + n->wins - edge->age_base;
+        if (age > (unsigned long)gng_eu->params.age_max){
             svoGNGEuEdgeDel(gng_eu, edge);
 
             if (borNetNodeEdgesLen(nn) == 0){
                 // remove node if not connected into net anymore
-                svoGNGEuNodeDel(gng_eu, n);
+                learnDelNode(gng_eu, n, defer_del);
                 n = NULL;
             }
+            SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_PRUNE);
         }
 
         // move node (5.)
@@ -280,10 +511,47 @@ void svoGNGEuLearn(svo_gng_eu_t *gng_eu)
     // remove winning node if not connected into net
     if (borNetNodeEdgesLen(&n1->node) == 0){
         // remove node if not connected into net anymore
-        svoGNGEuNodeDel(gng_eu, n1);
+        learnDelNode(gng_eu, n1, defer_del);
+        SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_PRUNE);
     }
 
     ++gng_eu->step;
+
+    // decrease error counters of all nodes
+    svoGNGEuDecreaseErrCounters(gng_eu);
+    SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_ERR);
+}
+
+static int batchDelCmp(const void *a, const void *b)
+{
+    const svo_gng_eu_node_t *n1 = *(const svo_gng_eu_node_t **)a;
+    const svo_gng_eu_node_t *n2 = *(const svo_gng_eu_node_t **)b;
+
+    if (n1 < n2)
+        return -1;
+    if (n1 > n2)
+        return 1;
+    return 0;
+}
+
+static void batchDelIsolated(svo_gng_eu_t *gng)
+{
+    svo_gng_eu_node_t *n;
+    size_t i;
+
+    // the same node could become isolated several times
+    qsort(gng->batch_del, gng->batch_del_len, sizeof(svo_gng_eu_node_t *),
+          batchDelCmp);
+
+    for (i = 0; i < gng->batch_del_len; i++){
+        n = gng->batch_del[i];
+        if (i > 0 && n == gng->batch_del[i - 1])
+            continue;
+
+        if (borNetNodeEdgesLen(&n->node) == 0)
+            svoGNGEuNodeDel(gng, n);
+    }
+    gng->batch_del_len = 0;
 }
 
 void svoGNGEuNewNode(svo_gng_eu_t *gng_eu)
@@ -291,6 +559,8 @@ void svoGNGEuNewNode(svo_gng_eu_t *gng_eu)
     svo_gng_eu_node_t *q, *f, *r;
     svo_gng_eu_edge_t *eqf;
 
+    SVO_STATS_START(&gng_eu->stats);
+
     // 1. Get node with highest error counter and its neighbor with
     // highest error counter
     svoGNGEuNodeWithHighestError2(gng_eu, &q, &f, &eqf);
@@ -310,8 +580,8 @@ void svoGNGEuNewNode(svo_gng_eu_t *gng_eu)
     // 6. Set error counter of new node (r)
     r->err  = q->err + f->err;
     r->err /= BOR_REAL(2.);
-    r->err_cycle = gng_eu->cycle;
-    borPairHeapUpdate(gng_eu->err_heap, &r->err_heap);
+    __svoGNGEuNodeErrUpdate(gng_eu, r);
+    SVO_STATS_LAP(&gng_eu->stats, SVO_STATS_NEW_NODE);
 }
 
 
@@ -319,15 +589,17 @@ svo_gng_eu_node_t *svoGNGEuNodeWithHighestError(svo_gng_eu_t *gng_eu)
 {
     bor_pairheap_node_t *max;
     svo_gng_eu_node_t *maxn;
+    svo_err_tree_el_t *el;
+
+    if (gng_eu->params.err_index == SVO_ERR_INDEX_TREE){
+        el   = svoErrTreeMax(&gng_eu->err_tree);
+        return bor_container_of(el, svo_gng_eu_node_t, err_tree);
+    }
 
     max  = borPairHeapMin(gng_eu->err_heap);
     maxn = bor_container_of(max, svo_gng_eu_node_t, err_heap);
 
     /*
-    if (maxn->err_cycle != gng_eu->cycle){
-        DBG2("");
-    }
-
     {
         bor_list_t *list, *item;
         bor_net_node_t *nn;
@@ -340,7 +612,6 @@ svo_gng_eu_node_t *svoGNGEuNodeWithHighestError(svo_gng_eu_t *gng_eu)
             nn = BOR_LIST_ENTRY(item, bor_net_node_t, list);
             n  = bor_container_of(nn, svo_gng_eu_node_t, node);
 
-            svoGNGEuNodeFixError(gng_eu, n);
             if (n->err > max){
                 max = n->err;
                 __maxn = n;
@@ -359,16 +630,12 @@ svo_gng_eu_node_t *svoGNGEuNodeWithHighestError(svo_gng_eu_t *gng_eu)
 void svoGNGEuHebbianLearning(svo_gng_eu_t *gng_eu,
                              svo_gng_eu_node_t *n1, svo_gng_eu_node_t *n2)
 {
-    bor_net_edge_t *nedge;
     svo_gng_eu_edge_t *edge;
 
-    nedge = borNetNodeCommonEdge(&n1->node, &n2->node);
-    if (!nedge){
+    edge = svoGNGEuEdgeBetween(gng_eu, n1, n2);
+    if (!edge)
         edge = svoGNGEuEdgeNew(gng_eu, n1, n2);
-    }else{
-        edge = bor_container_of(nedge, svo_gng_eu_edge_t, edge);
-    }
-    edge->age = 0;
+    edge->age_base = n1->wins + n2->wins;
 }
 
 static void __svoGNGEuNodeWithHighestError2(svo_gng_eu_t *gng_eu,
@@ -396,9 +663,6 @@ static void __svoGNGEuNodeWithHighestError2(svo_gng_eu_t *gng_eu,
         nn = borNetEdgeOtherNode(ne, &q->node);
         n  = bor_container_of(nn, svo_gng_eu_node_t, node);
 
-        svoGNGEuNodeFixError(gng_eu, n);
-        borPairHeapUpdate(gng_eu->err_heap, &n->err_heap);
-
         if (n->err > err_highest){
             err_highest = n->err;
             n_highest   = n;
@@ -485,12 +749,263 @@ void svoGNGEuDumpSVT(svo_gng_eu_t *gng_eu, FILE *out, const char *name)
     fprintf(out, "--------\n");
 }
 
+int svoGNGEuSave(svo_gng_eu_t *gng_eu, FILE *fout)
+{
+    svo_snapshot_t s;
+    bor_list_t *list, *item;
+    svo_gng_eu_node_t *n, *n2;
+    svo_gng_eu_edge_t *e;
+    int i;
+
+    svoSnapshotWriteStart(&s, fout, SVO_SNAPSHOT_GNG_EU);
+
+    svoSnapshotWriteU64(&s, gng_eu->params.dim);
+    svoSnapshotWriteU64(&s, gng_eu->params.lambda);
+    svoSnapshotWriteReal(&s, gng_eu->params.eb);
+    svoSnapshotWriteReal(&s, gng_eu->params.en);
+    svoSnapshotWriteReal(&s, gng_eu->params.alpha);
+    svoSnapshotWriteReal(&s, gng_eu->params.beta);
+    svoSnapshotWriteU64(&s, gng_eu->params.age_max);
+
+    svoSnapshotWriteReal(&s, gng_eu->err_scale);
+    svoSnapshotWriteReal(&s, gng_eu->err_scale_inc);
+    svoSnapshotWriteU64(&s, gng_eu->step);
+    svoSnapshotWriteU64(&s, gng_eu->cycle);
+    svoSnapshotWriteRng(&s, &gng_eu->rng);
+
+    // position of built-in sampler
+    svoSnapshotWriteU64(&s, gng_eu->sampler.len);
+    if (gng_eu->sampler.len > 0)
+        svoSnapshotWriteU64(&s, svoSamplerTell(&gng_eu->sampler));
+
+    // nodes in order of list, their order gives their indices
+    svoSnapshotWriteU64(&s, svoGNGEuNodesLen(gng_eu));
+    list = svoGNGEuNodes(gng_eu);
+    i = 0;
+    BOR_LIST_FOR_EACH(list, item){
+        n = svoGNGEuNodeFromList(item);
+        n->_id = i++;
+
+        svoSnapshotWriteU64(&s, n->wins);
+        svoSnapshotWriteReal(&s, n->err);
+        svoSnapshotWrite(&s, n->w, sizeof(bor_real_t) * gng_eu->params.dim);
+    }
+
+    svoSnapshotWriteU64(&s, svoGNGEuEdgesLen(gng_eu));
+    list = svoGNGEuEdges(gng_eu);
+    BOR_LIST_FOR_EACH(list, item){
+        e = svoGNGEuEdgeFromList(item);
+        svoGNGEuEdgeNodes(e, &n, &n2);
+
+        svoSnapshotWriteU64(&s, n->_id);
+        svoSnapshotWriteU64(&s, n2->_id);
+        svoSnapshotWriteU64(&s, e->age_base);
+    }
+
+    return svoSnapshotEnd(&s, "GNGEu");
+}
+
+int svoGNGEuExportModel(svo_gng_eu_t *gng_eu, const char *fn)
+{
+    bor_list_t *list, *item;
+    svo_gng_eu_node_t *n, *n2;
+    svo_gng_eu_edge_t *e;
+    const bor_real_t **w;
+    uint32_t *edges;
+    size_t i, len, edges_len;
+    int ret;
+
+    len = svoGNGEuNodesLen(gng_eu);
+    w = BOR_ALLOC_ARR(const bor_real_t *, len + 1);
+    i = 0;
+    list = svoGNGEuNodes(gng_eu);
+    BOR_LIST_FOR_EACH(list, item){
+        n = svoGNGEuNodeFromList(item);
+        n->_id = i;
+        w[i++] = n->w;
+    }
+
+    edges_len = svoGNGEuEdgesLen(gng_eu);
+    edges = BOR_ALLOC_ARR(uint32_t, 2 * edges_len + 1);
+    i = 0;
+    list = svoGNGEuEdges(gng_eu);
+    BOR_LIST_FOR_EACH(list, item){
+        e = svoGNGEuEdgeFromList(item);
+        svoGNGEuEdgeNodes(e, &n, &n2);
+        edges[i++] = n->_id;
+        edges[i++] = n2->_id;
+    }
+
+    ret = svoModelWrite(fn, gng_eu->params.dim, len, w,
+                        edges_len, edges, NULL);
+
+    BOR_FREE(w);
+    BOR_FREE(edges);
+
+    return ret;
+}
+
+/** Node read from snapshot, see svoGNGEuLoad() */
+struct _load_node_t {
+    unsigned long wins;
+    bor_real_t err;
+};
+typedef struct _load_node_t load_node_t;
+
+/** Edge read from snapshot */
+struct _load_edge_t {
+    uint64_t n1, n2;
+    unsigned long age_base;
+};
+typedef struct _load_edge_t load_edge_t;
+
+int svoGNGEuLoad(svo_gng_eu_t *gng_eu, FILE *fin)
+{
+    svo_snapshot_t s;
+    svo_gng_eu_params_t params;
+    svo_rng_t rng;
+    bor_list_t *list, *item, *itemtmp;
+    svo_gng_eu_node_t **nodes, *n;
+    svo_gng_eu_edge_t *e;
+    load_node_t *lnodes;
+    load_edge_t *ledges;
+    bor_real_t *ws, err_scale, err_scale_inc;
+    uint64_t drawn = 0, step, cycle;
+    size_t i, len, len2, size, size2, dim;
+
+    // everything is read into local storage first, so broken snapshot
+    // leaves {gng_eu} untouched
+    dim = gng_eu->params.dim;
+    params = gng_eu->params;
+    rng = gng_eu->rng;
+
+    svoSnapshotReadStart(&s, fin, SVO_SNAPSHOT_GNG_EU);
+    if (svoSnapshotReadU64(&s) != (uint64_t)dim)
+        s.err = 1;
+
+    params.lambda  = svoSnapshotReadU64(&s);
+    params.eb      = svoSnapshotReadReal(&s);
+    params.en      = svoSnapshotReadReal(&s);
+    params.alpha   = svoSnapshotReadReal(&s);
+    params.beta    = svoSnapshotReadReal(&s);
+    params.age_max = svoSnapshotReadU64(&s);
+
+    err_scale     = svoSnapshotReadReal(&s);
+    err_scale_inc = svoSnapshotReadReal(&s);
+    step          = svoSnapshotReadU64(&s);
+    cycle         = svoSnapshotReadU64(&s);
+    svoSnapshotReadRng(&s, &rng);
+    if (err_scale <= BOR_ZERO || params.beta <= BOR_ZERO)
+        s.err = 1;
+
+    // the same input signals must be already set
+    if (svoSnapshotReadU64(&s) != gng_eu->sampler.len)
+        s.err = 1;
+    if (gng_eu->sampler.len > 0)
+        drawn = svoSnapshotReadU64(&s);
+
+    // nodes and edges, arrays grow as they are read so that corrupted
+    // lengths can't request huge allocations
+    lnodes = NULL;
+    ws = NULL;
+    size = 0;
+    len = svoSnapshotReadU64(&s);
+    for (i = 0; i < len && !s.err; i++){
+        if (i == size){
+            size = (size == 0 ? 64 : 2 * size);
+            lnodes = BOR_REALLOC_ARR(lnodes, load_node_t, size);
+            ws = BOR_REALLOC_ARR(ws, bor_real_t, size * dim);
+        }
+        lnodes[i].wins = svoSnapshotReadU64(&s);
+        lnodes[i].err  = svoSnapshotReadReal(&s);
+        svoSnapshotRead(&s, ws + i * dim, sizeof(bor_real_t) * dim);
+    }
+
+    ledges = NULL;
+    size2 = 0;
+    len2 = svoSnapshotReadU64(&s);
+    for (i = 0; i < len2 && !s.err; i++){
+        if (i == size2){
+            size2 = (size2 == 0 ? 64 : 2 * size2);
+            ledges = BOR_REALLOC_ARR(ledges, load_edge_t, size2);
+        }
+        ledges[i].n1       = svoSnapshotReadU64(&s);
+        ledges[i].n2       = svoSnapshotReadU64(&s);
+        ledges[i].age_base = svoSnapshotReadU64(&s);
+        if (ledges[i].n1 >= len || ledges[i].n2 >= len)
+            s.err = 1;
+    }
+
+    if (!s.err){
+        gng_eu->params        = params;
+        gng_eu->err_scale     = err_scale;
+        gng_eu->err_scale_inc = err_scale_inc;
+        gng_eu->step          = step;
+        gng_eu->cycle         = cycle;
+        gng_eu->rng           = rng;
+        if (gng_eu->sampler.len > 0)
+            svoSamplerSeek(&gng_eu->sampler, drawn);
+
+        // throw away current net
+        list = svoGNGEuNodes(gng_eu);
+        BOR_LIST_FOR_EACH_SAFE(list, item, itemtmp){
+            n = svoGNGEuNodeFromList(item);
+            svoGNGEuNodeDisconnect(gng_eu, n);
+            svoGNGEuNodeDel(gng_eu, n);
+        }
+
+        nodes = BOR_ALLOC_ARR(svo_gng_eu_node_t *, len);
+        for (i = 0; i < len; i++){
+            nodes[i] = n = svoGNGEuNodeNew(gng_eu,
+                                           (const bor_vec_t *)(ws + i * dim));
+            n->wins = lnodes[i].wins;
+            n->err  = lnodes[i].err;
+            __svoGNGEuNodeErrUpdate(gng_eu, n);
+        }
+
+        for (i = 0; i < len2; i++){
+            e = svoGNGEuEdgeNew(gng_eu, nodes[ledges[i].n1],
+                                nodes[ledges[i].n2]);
+            e->age_base = ledges[i].age_base;
+        }
+        BOR_FREE(nodes);
+    }
+
+    if (lnodes)
+        BOR_FREE(lnodes);
+    if (ws)
+        BOR_FREE(ws);
+    if (ledges)
+        BOR_FREE(ledges);
+
+    return svoSnapshotEnd(&s, "GNGEu");
+}
+
 
 
 
 
 
 /*** Node functions ***/
+void __svoGNGEuErrRenormalise(svo_gng_eu_t *gng_eu)
+{
+    bor_list_t *list, *item;
+    bor_net_node_t *nn;
+    svo_gng_eu_node_t *n;
+
+    // all stored errors are divided by the same factor so order of nodes
+    // in error heap doesn't change
+    list = borNetNodes(gng_eu->net);
+    BOR_LIST_FOR_EACH(list, item){
+        nn = BOR_LIST_ENTRY(item, bor_net_node_t, list);
+        n  = bor_container_of(nn, svo_gng_eu_node_t, node);
+        n->err /= gng_eu->err_scale;
+        if (gng_eu->params.err_index == SVO_ERR_INDEX_TREE)
+            svoErrTreeUpdate(&gng_eu->err_tree, &n->err_tree, n->err);
+    }
+    gng_eu->err_scale = BOR_ONE;
+}
+
 void svoGNGEuNodeDisconnect(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *node)
 {
     bor_list_t *edges, *item, *itemtmp;
@@ -509,16 +1024,13 @@ void svoGNGEuNodeDisconnect(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *node)
 svo_gng_eu_node_t *svoGNGEuNodeNewAtPos(svo_gng_eu_t *gng_eu, const void *is)
 {
     svo_gng_eu_node_t *r, *n1, *n2;
-    svo_gng_eu_edge_t *edge;
 
     svoGNGEuNearest(gng_eu, is, &n1, &n2);
 
     r = svoGNGEuNodeNew(gng_eu, (const bor_vec_t *)is);
 
-    edge = svoGNGEuEdgeNew(gng_eu, r, n1);
-    edge->age = 0;
-    edge = svoGNGEuEdgeNew(gng_eu, r, n2);
-    edge->age = 0;
+    svoGNGEuEdgeNew(gng_eu, r, n1);
+    svoGNGEuEdgeNew(gng_eu, r, n2);
 
     return r;
 }
@@ -530,18 +1042,37 @@ svo_gng_eu_edge_t *svoGNGEuEdgeNew(svo_gng_eu_t *gng_eu, svo_gng_eu_node_t *n1,
 {
     svo_gng_eu_edge_t *e;
 
-    e = BOR_ALLOC(svo_gng_eu_edge_t);
-    e->age = 0;
+    e = svoPoolAlloc(&gng_eu->edge_pool);
+    e->age_base = n1->wins + n2->wins;
 
     borNetAddEdge(gng_eu->net, &e->edge, &n1->node, &n2->node);
 
+    if (gng_eu->params.compact_adj){
+        svoAdjAdd(&n1->adj, n2->id, e);
+        svoAdjAdd(&n2->adj, n1->id, e);
+    }
+    if (gng_eu->params.edge_hash)
+        svoEdgeHashAdd(&gng_eu->edge_hash, n1->id, n2->id, e);
+
     return e;
 }
 
 void svoGNGEuEdgeDel(svo_gng_eu_t *gng_eu, svo_gng_eu_edge_t *e)
 {
+    svo_gng_eu_node_t *n1, *n2;
+
+    if (gng_eu->params.compact_adj || gng_eu->params.edge_hash){
+        svoGNGEuEdgeNodes(e, &n1, &n2);
+        if (gng_eu->params.compact_adj){
+            svoAdjRemove(&n1->adj, n2->id);
+            svoAdjRemove(&n2->adj, n1->id);
+        }
+        if (gng_eu->params.edge_hash)
+            svoEdgeHashRemove(&gng_eu->edge_hash, n1->id, n2->id);
+    }
+
     borNetRemoveEdge(gng_eu->net, &e->edge);
-    BOR_FREE(e);
+    svoPoolRelease(&gng_eu->edge_pool, e);
 }
 
 void svoGNGEuEdgeBetweenDel(svo_gng_eu_t *gng_eu,
@@ -559,18 +1090,88 @@ void svoGNGEuEdgeBetweenDel(svo_gng_eu_t *gng_eu,
 
 
 
+/*** Weight storage ***/
+int svoGNGEuWeightsAlloc(svo_gng_eu_weights_t *ws)
+{
+    size_t id, block;
+    void *mem;
+
+    if (ws->free_len > 0)
+        return ws->free_ids[--ws->free_len];
+
+    id = ws->len++;
+
+    block = id >> SVO_GNG_EU_WEIGHTS_BLOCK_SHIFT;
+    if (ws->stride > 0 && block >= ws->blocks_len){
+        ws->blocks = BOR_REALLOC_ARR(ws->blocks, bor_real_t *, block + 1);
+        ws->blocks_len = block + 1;
+
+        if (posix_memalign(&mem, 64, sizeof(bor_real_t) * ws->stride
+                                        * SVO_GNG_EU_WEIGHTS_BLOCK) != 0){
+            fprintf(stderr, "GNGEu Error: Can't allocate storage for weight vectors.\n");
+            exit(-1);
+        }
+        bzero(mem, sizeof(bor_real_t) * ws->stride * SVO_GNG_EU_WEIGHTS_BLOCK);
+        ws->blocks[block] = (bor_real_t *)mem;
+    }
+
+    return (int)id;
+}
+
+void svoGNGEuWeightsRelease(svo_gng_eu_weights_t *ws, int id)
+{
+    if (ws->free_len == ws->free_size){
+        ws->free_size = BOR_MAX(2 * ws->free_size, 32);
+        ws->free_ids = BOR_REALLOC_ARR(ws->free_ids, int, ws->free_size);
+    }
+    ws->free_ids[ws->free_len++] = id;
+}
+
+static void weightsInit(svo_gng_eu_weights_t *ws, int dim, int store)
+{
+    size_t align;
+
+    bzero(ws, sizeof(*ws));
+    if (!store)
+        return;
+
+    // 2-D and 3-D vectors may be padded (see bor_vec2_t, bor_vec3_t)
+    if (dim == 2){
+        ws->stride = sizeof(bor_vec2_t) / sizeof(bor_real_t);
+    }else if (dim == 3){
+        ws->stride = sizeof(bor_vec3_t) / sizeof(bor_real_t);
+    }else{
+        ws->stride = dim;
+    }
+
+    // keep each weight vector aligned to 16 bytes
+    align = 16 / sizeof(bor_real_t);
+    ws->stride = ((ws->stride + align - 1) / align) * align;
+}
+
+static void weightsFree(svo_gng_eu_weights_t *ws)
+{
+    size_t i;
+
+    for (i = 0; i < ws->blocks_len; i++)
+        free(ws->blocks[i]);
+    if (ws->blocks)
+        BOR_FREE(ws->blocks);
+    if (ws->free_ids)
+        BOR_FREE(ws->free_ids);
+}
+
+
+
 static int errHeapLT(const bor_pairheap_node_t *_n1,
                      const bor_pairheap_node_t *_n2,
                      void *data)
 {
-    svo_gng_eu_t *gng_eu = (svo_gng_eu_t *)data;
     svo_gng_eu_node_t *n1, *n2;
 
     n1 = bor_container_of(_n1, svo_gng_eu_node_t, err_heap);
     n2 = bor_container_of(_n2, svo_gng_eu_node_t, err_heap);
 
-    svoGNGEuNodeFixError(gng_eu, n1);
-    svoGNGEuNodeFixError(gng_eu, n2);
     return n1->err > n2->err;
 }
 
@@ -584,9 +1185,23 @@ static void nodeFinalDel(bor_net_node_t *node, void *data)
     svoGNGEuNodeDel(gng_eu, n);
 }
 
+static void nodeFastDel(bor_net_node_t *node, void *data)
+{
+    svo_gng_eu_t *gng_eu = (svo_gng_eu_t *)data;
+    svo_gng_eu_node_t *n;
+
+    // only weight vector and spilled adjacency are owned by node, the
+    // rest goes with pools
+    n = bor_container_of(node, svo_gng_eu_node_t, node);
+    if (!gng_eu->params.dense_weights)
+        borVecDel(n->w);
+    if (gng_eu->params.compact_adj)
+        svoAdjFree(&n->adj);
+}
+
 static void delEdge(bor_net_edge_t *edge, void *data)
 {
-    BOR_FREE(edge);
+    // edges are released all at once with edge pool
 }
 
 
@@ -599,7 +1214,7 @@ static svo_gng_eu_node_t *svoGNGEuNodeNew(svo_gng_eu_t *gng, const bor_vec_t *is
     if (gng->ops.new_node){
         n = gng->ops.new_node(is, gng->ops.new_node_data);
     }else{
-        n = BOR_ALLOC(svo_gng_eu_node_t);
+        n = svoPoolAlloc(&gng->node_pool);
     }
     svoGNGEuNodeAdd(gng, n, is);
 
@@ -610,40 +1225,15 @@ static svo_gng_eu_node_t *svoGNGEuNodeNewBetween(svo_gng_eu_t *gng,
                                                  const svo_gng_eu_node_t *n1,
                                                  const svo_gng_eu_node_t *n2)
 {
-    if (gng->params.dim == 2){
-        borVec2Add2((bor_vec2_t *)gng->tmpv, (const bor_vec2_t *)n1->w,
-                                             (const bor_vec2_t *)n2->w);
-        borVec2Scale((bor_vec2_t *)gng->tmpv, BOR_REAL(0.5));
-    }else if (gng->params.dim == 3){
-        borVec3Add2((bor_vec3_t *)gng->tmpv, (const bor_vec3_t *)n1->w,
-                                             (const bor_vec3_t *)n2->w);
-        borVec3Scale((bor_vec3_t *)gng->tmpv, BOR_REAL(0.5));
-    }else{
-        borVecAdd2(gng->params.dim, gng->tmpv, n1->w, n2->w);
-        borVecScale(gng->params.dim, gng->tmpv, BOR_REAL(0.5));
-    }
-
+    gng->kernel.between(gng->params.dim, gng->tmpv, n1->w, n2->w);
     return svoGNGEuNodeNew(gng, gng->tmpv);
 }
 
-static const void *svoGNGEuInputSignal(void *data)
+_bor_inline const bor_vec_t *svoGNGEuInputSignal(svo_gng_eu_t *gng)
 {
-    /*
-    svo_gng_eu_t *gng = (svo_gng_eu_t *)data;
-    const bor_vec_t *v;
-
-    if (borPCItEnd(&gng->pcit)){
-        borPCPermutate(gng->pc);
-        borPCItInit(&gng->pcit, gng->pc);
-    }
-
-    v = borPCItGet(&gng->pcit);
-    borPCItNext(&gng->pcit);
-
-    return v;
-    */
-    // TODO
-    return NULL;
+    if (gng->sampler.len == 0)
+        return gng->ops.input_signal(gng->ops.input_signal_data);
+    return svoSamplerNext(&gng->sampler);
 }
 
 
@@ -668,13 +1258,7 @@ _bor_inline bor_real_t svoGNGEuDist2(svo_gng_eu_t *gng,
                                      const bor_vec_t *is,
                                      const svo_gng_eu_node_t *n)
 {
-    if (gng->params.dim == 2){
-        return borVec2Dist2((const bor_vec2_t *)is, (const bor_vec2_t *)n->w);
-    }else if (gng->params.dim == 3){
-        return borVec3Dist2((const bor_vec3_t *)is, (const bor_vec3_t *)n->w);
-    }else{
-        return borVecDist2(gng->params.dim, is, n->w);
-    }
+    return gng->kernel.dist2(gng->params.dim, is, n->w);
 }
 
 _bor_inline void svoGNGEuMoveTowards(svo_gng_eu_t *gng,
@@ -682,21 +1266,9 @@ _bor_inline void svoGNGEuMoveTowards(svo_gng_eu_t *gng,
                                      const bor_vec_t *is,
                                      bor_real_t fraction)
 {
-    if (gng->params.dim == 2){
-        borVec2Sub2((bor_vec2_t *)gng->tmpv, (const bor_vec2_t *)is,
-                                             (const bor_vec2_t *)n->w);
-        borVec2Scale((bor_vec2_t *)gng->tmpv, fraction);
-        borVec2Add((bor_vec2_t *)n->w, (const bor_vec2_t *)gng->tmpv);
-    }else if (gng->params.dim == 3){
-        borVec3Sub2((bor_vec3_t *)gng->tmpv, (const bor_vec3_t *)is,
-                                             (const bor_vec3_t *)n->w);
-        borVec3Scale((bor_vec3_t *)gng->tmpv, fraction);
-        borVec3Add((bor_vec3_t *)n->w, (const bor_vec3_t *)gng->tmpv);
-    }else{
-        borVecSub2(gng->params.dim, gng->tmpv, is, n->w);
-        borVecScale(gng->params.dim, gng->tmpv, fraction);
-        borVecAdd(gng->params.dim, n->w, gng->tmpv);
-    }
+    gng->kernel.move_towards(gng->params.dim, n->w, is, fraction);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_MOVE);
 
     borNNUpdate(gng->nn, &n->nn);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_NN_UPDATE);
 }
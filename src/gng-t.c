@@ -14,13 +14,13 @@
  *  See the License for more information.
  */
 
+#include <stdlib.h>
 #include <boruvka/dbg.h>
 #include <boruvka/alloc.h>
 #include "gng/gng-t.h"
+#include "gng/gng-algorithm.h"
+#include "gng/snapshot.h"
 
-static void svoGNGTHebbianLearning(svo_gngt_t *gng,
-                                   svo_gngt_node_t *n1,
-                                   svo_gngt_node_t *n2);
 static svo_gngt_node_t *svoGNGTNodeNeighborWithHighestErr(svo_gngt_t *gng,
                                                           svo_gngt_node_t *n);
 
@@ -28,6 +28,9 @@ static svo_gngt_node_t *svoGNGTNodeNeighborWithHighestErr(svo_gngt_t *gng,
 static void nodeFinalDel(bor_net_node_t *node, void *data);
 static void delEdge(bor_net_edge_t *edge, void *data);
 
+/** Deletes nodes stored in .batch_del that are still isolated */
+static void batchDelIsolated(svo_gngt_t *gng);
+
 void svoGNGTOpsInit(svo_gngt_ops_t *ops)
 {
     bzero(ops, sizeof(svo_gngt_ops_t));
@@ -40,6 +43,7 @@ void svoGNGTParamsInit(svo_gngt_params_t *params)
     params->en      = 0.0006;
     params->age_max = 200;
     params->target  = 100.;
+    params->seed    = 0L;
 }
 
 svo_gngt_t *svoGNGTNew(const svo_gngt_ops_t *ops,
@@ -71,11 +75,30 @@ svo_gngt_t *svoGNGTNew(const svo_gngt_ops_t *ops,
         gng->ops.dist2_data = gng->ops.data;
     if (!gng->ops.move_towards_data)
         gng->ops.move_towards_data = gng->ops.data;
+    if (!gng->ops.input_signal_batch_data)
+        gng->ops.input_signal_batch_data = gng->ops.data;
+    if (!gng->ops.nearest_batch_data)
+        gng->ops.nearest_batch_data = gng->ops.data;
+    if (!gng->ops.move_towards_many_data)
+        gng->ops.move_towards_many_data = gng->ops.data;
     if (!gng->ops.terminate_data)
         gng->ops.terminate_data = gng->ops.data;
     if (!gng->ops.callback_data)
         gng->ops.callback_data = gng->ops.data;
 
+    svoPoolInit(&gng->edge_pool, sizeof(svo_gngt_edge_t), 0);
+
+    gng->batch_is = NULL;
+    gng->batch_win = NULL;
+    gng->batch_size = 0;
+    gng->batch_del = NULL;
+    gng->batch_del_len = gng->batch_del_size = 0;
+    gng->neigh = NULL;
+    gng->neigh_size = 0;
+
+    svoStatsReset(&gng->stats);
+    svoRngInit(&gng->rng, gng->params.seed);
+
     return gng;
 }
 
@@ -86,30 +109,27 @@ void svoGNGTDel(svo_gngt_t *gng)
                              delEdge, gng);
     }
 
+    svoPoolFree(&gng->edge_pool);
+
+    if (gng->batch_is)
+        BOR_FREE(gng->batch_is);
+    if (gng->batch_win)
+        BOR_FREE(gng->batch_win);
+    if (gng->batch_del)
+        BOR_FREE(gng->batch_del);
+    if (gng->neigh)
+        BOR_FREE(gng->neigh);
+
     BOR_FREE(gng);
 }
 
 void svoGNGTRun(svo_gngt_t *gng)
 {
-    unsigned long cycle = 0L;
-    size_t i;
-
-    svoGNGTInit(gng);
-
-    do {
-        svoGNGTReset(gng);
-        for (i = 0; i < gng->params.lambda; i++){
-            svoGNGTAdapt(gng);
-        }
-
-        svoGNGTGrowShrink(gng);
-
-        cycle++;
-        if (gng->ops.callback && gng->ops.callback_period == cycle){
-            gng->ops.callback(gng->ops.callback_data);
-            cycle = 0L;
-        }
-    } while (!gng->ops.terminate(gng->ops.terminate_data));
+    if (gng->ops.input_signal_batch || gng->ops.nearest_batch){
+        __svoGNGTRun(gng, svoGNGTAdapt, svoGNGTAdaptBatch);
+    }else{
+        __svoGNGTRun(gng, svoGNGTAdapt, NULL);
+    }
 }
 
 void svoGNGTInit(svo_gngt_t *gng)
@@ -146,66 +166,81 @@ void svoGNGTReset(svo_gngt_t *gng)
 }
 
 void svoGNGTAdapt(svo_gngt_t *gng)
+{
+    __svoGNGTAdapt(gng, gng->ops.input_signal, gng->ops.nearest,
+                   gng->ops.dist2, gng->ops.move_towards,
+                   gng->ops.move_towards_many);
+}
+
+void svoGNGTAdaptBatch(svo_gngt_t *gng, size_t k)
 {
     const void *is;
-    bor_net_edge_t *ne;
-    bor_net_node_t *nn;
     svo_gngt_node_t *n1, *n2;
-    svo_gngt_edge_t *e;
-    bor_real_t dist2;
-    bor_list_t *list, *item, *item_tmp;
-
-    // 1. Get input signal
-    is = gng->ops.input_signal(gng->ops.input_signal_data);
-
-    // 2. Find two nearest nodes to input signal
-    gng->ops.nearest(is, &n1, &n2, gng->ops.nearest_data);
-    n1->won = 1;
-
-    // 3. Create (or refresh) an edge between n1 and n2
-    svoGNGTHebbianLearning(gng, n1, n2);
+    size_t i;
 
-    // 4. Update accumulator
-    dist2 = gng->ops.dist2(is, n1, gng->ops.dist2_data);
-    n1->err += dist2;
+    if (!gng->ops.nearest_batch){
+        // Each signal is fetched only after the previous one was applied,
+        // so it has to stay valid only until the next call as in
+        // svoGNGTAdapt()
+        for (i = 0; i < k; i++){
+            SVO_STATS_START(&gng->stats);
+            if (gng->ops.input_signal_batch){
+                gng->ops.input_signal_batch(&is, 1,
+                                            gng->ops.input_signal_batch_data);
+            }else{
+                is = gng->ops.input_signal(gng->ops.input_signal_data);
+            }
+            SVO_STATS_LAP(&gng->stats, SVO_STATS_INPUT);
 
-    // 5. Move winner node towards is
-    gng->ops.move_towards(n1, is, gng->params.eb,
-                          gng->ops.move_towards_data);
+            gng->ops.nearest(is, &n1, &n2, gng->ops.nearest_data);
+            SVO_STATS_LAP(&gng->stats, SVO_STATS_NEAREST);
 
-    // 6. Move n1's neighbors towards is
-    // + 7. Increment age of all edges emanating from n1
-    // + 8. Remove edges with age > age_max
-    list = borNetNodeEdges(&n1->node);
-    BOR_LIST_FOR_EACH_SAFE(list, item, item_tmp){
-        ne = borNetEdgeFromNodeList(item);
-        e  = bor_container_of(ne, svo_gngt_edge_t, edge);
-        nn = borNetEdgeOtherNode(ne, &n1->node);
-        n2 = bor_container_of(nn, svo_gngt_node_t, node);
+            __svoGNGTAdaptApply(gng, is, n1, n2, 0,
+                                gng->ops.dist2, gng->ops.move_towards,
+                                gng->ops.move_towards_many);
+        }
+        return;
+    }
 
-        // increment age (7.)
-        e->age += 1;
+    if (k > gng->batch_size){
+        gng->batch_size = k;
+        gng->batch_is = BOR_REALLOC_ARR(gng->batch_is, const void *, k);
+        gng->batch_win = BOR_REALLOC_ARR(gng->batch_win,
+                                         svo_gngt_node_t *, 2 * k);
+    }
 
-        // delete edge (8.)
-        if (e->age > gng->params.age_max){
-            svoGNGTEdgeDel(gng, e);
+    SVO_STATS_START(&gng->stats);
 
-            if (borNetNodeEdgesLen(&n2->node) == 0){
-                // remove node if not connected into net anymore
-                svoGNGTNodeDel(gng, n2);
-            }
-        }else{
-            // move node (6.)
-            gng->ops.move_towards(n2, is, gng->params.en,
-                                  gng->ops.move_towards_data);
+    // 1. Get all input signals
+    if (gng->ops.input_signal_batch){
+        gng->ops.input_signal_batch(gng->batch_is, k,
+                                    gng->ops.input_signal_batch_data);
+    }else{
+        for (i = 0; i < k; i++){
+            gng->batch_is[i] = gng->ops.input_signal(
+                                    gng->ops.input_signal_data);
         }
     }
-
-    // remove winning node if not connected into net
-    if (borNetNodeEdgesLen(&n1->node) == 0){
-        // remove node if not connected into net anymore
-        svoGNGTNodeDel(gng, n1);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_INPUT);
+
+    // 2. Find two nearest nodes to all input signals at once, the net
+    //    isn't changed meanwhile
+    gng->ops.nearest_batch(gng->batch_is, k, gng->batch_win,
+                           gng->ops.nearest_batch_data);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_NEAREST);
+
+    // 3. Apply adaptation steps in order of signals
+    gng->batch_del_len = 0;
+    for (i = 0; i < k; i++){
+        __svoGNGTAdaptApply(gng, gng->batch_is[i], gng->batch_win[2 * i],
+                            gng->batch_win[2 * i + 1], 1,
+                            gng->ops.dist2, gng->ops.move_towards,
+                            gng->ops.move_towards_many);
     }
+
+    // 4. Remove nodes that are still isolated
+    batchDelIsolated(gng);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_PRUNE);
 }
 
 void svoGNGTGrowShrink(svo_gngt_t *gng)
@@ -215,6 +250,8 @@ void svoGNGTGrowShrink(svo_gngt_t *gng)
     svo_gngt_edge_t *e;
     bor_real_t avg, num;
 
+    SVO_STATS_START(&gng->stats);
+
     avg = num = BOR_ZERO;
     max = min = NULL;
 
@@ -241,6 +278,7 @@ void svoGNGTGrowShrink(svo_gngt_t *gng)
     // compute average error
     avg /= num;
     gng->avg_err = avg;
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_ERR);
 
     if (gng->params.target < avg){
         // more accuracy required
@@ -259,6 +297,7 @@ void svoGNGTGrowShrink(svo_gngt_t *gng)
         if (min)
             svoGNGTNodeDel(gng, min);
     }
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_NEW_NODE);
 
     if (svoGNGTNodesLen(gng) < 2){
         fprintf(stderr, "GNG-T Error: Check the parameters! The network shrinks too much.\n");
@@ -268,6 +307,224 @@ void svoGNGTGrowShrink(svo_gngt_t *gng)
 
 
 
+/** Node and its index in snapshot */
+struct _node_idx_t {
+    svo_gngt_node_t *n;
+    uint64_t idx;
+};
+typedef struct _node_idx_t node_idx_t;
+
+static int nodeIdxCmp(const void *a, const void *b)
+{
+    const node_idx_t *n1 = (const node_idx_t *)a;
+    const node_idx_t *n2 = (const node_idx_t *)b;
+
+    if (n1->n < n2->n)
+        return -1;
+    return n1->n > n2->n;
+}
+
+/** Returns index of node {n}, {nodes} are sorted by nodeIdxCmp() */
+static uint64_t nodeIdx(const node_idx_t *nodes, size_t len,
+                        svo_gngt_node_t *n)
+{
+    node_idx_t key, *found;
+
+    key.n = n;
+    found = bsearch(&key, nodes, len, sizeof(node_idx_t), nodeIdxCmp);
+    return found->idx;
+}
+
+int svoGNGTSave(svo_gngt_t *gng, FILE *fout,
+                svo_gngt_save_node save_node, void *data)
+{
+    svo_snapshot_t s;
+    bor_list_t *list, *item;
+    node_idx_t *nodes;
+    svo_gngt_node_t *n, *n2;
+    svo_gngt_edge_t *e;
+    size_t i, len;
+
+    svoSnapshotWriteStart(&s, fout, SVO_SNAPSHOT_GNGT);
+
+    svoSnapshotWriteU64(&s, gng->params.lambda);
+    svoSnapshotWriteReal(&s, gng->params.eb);
+    svoSnapshotWriteReal(&s, gng->params.en);
+    svoSnapshotWriteU64(&s, gng->params.age_max);
+    svoSnapshotWriteReal(&s, gng->params.target);
+    svoSnapshotWriteReal(&s, gng->avg_err);
+    svoSnapshotWriteRng(&s, &gng->rng);
+
+    // nodes in order of list, their order gives their indices
+    len = svoGNGTNodesLen(gng);
+    svoSnapshotWriteU64(&s, len);
+    nodes = BOR_ALLOC_ARR(node_idx_t, len);
+    i = 0;
+    list = svoGNGTNodes(gng);
+    BOR_LIST_FOR_EACH(list, item){
+        n = svoGNGTNodeFromList(item);
+        nodes[i].n = n;
+        nodes[i].idx = i;
+        i++;
+
+        svoSnapshotWriteReal(&s, n->err);
+        svoSnapshotWriteU64(&s, n->won);
+        svoSnapshotWriteU64(&s, n->wins);
+        if (!s.err && save_node(n, fout, data) != 0)
+            s.err = 1;
+    }
+
+    // edges refer to nodes by indices, so nodes are sorted by pointers
+    qsort(nodes, len, sizeof(node_idx_t), nodeIdxCmp);
+
+    svoSnapshotWriteU64(&s, svoGNGTEdgesLen(gng));
+    list = svoGNGTEdges(gng);
+    BOR_LIST_FOR_EACH(list, item){
+        e = svoGNGTEdgeFromList(item);
+        svoGNGTEdgeNodes(e, &n, &n2);
+
+        svoSnapshotWriteU64(&s, nodeIdx(nodes, len, n));
+        svoSnapshotWriteU64(&s, nodeIdx(nodes, len, n2));
+        svoSnapshotWriteU64(&s, e->age_base);
+    }
+
+    BOR_FREE(nodes);
+
+    return svoSnapshotEnd(&s, "GNG-T");
+}
+
+/** Node read from snapshot, see svoGNGTLoad() */
+struct _load_node_t {
+    svo_gngt_node_t *n;
+    bor_real_t err;
+    int won;
+    unsigned long wins;
+};
+typedef struct _load_node_t load_node_t;
+
+/** Edge read from snapshot */
+struct _load_edge_t {
+    uint64_t n1, n2;
+    unsigned long age_base;
+};
+typedef struct _load_edge_t load_edge_t;
+
+int svoGNGTLoad(svo_gngt_t *gng, FILE *fin,
+                svo_gngt_load_node load_node, void *data)
+{
+    svo_snapshot_t s;
+    svo_gngt_params_t params;
+    svo_rng_t rng;
+    bor_list_t *list, *item, *itemtmp;
+    svo_gngt_node_t *n;
+    svo_gngt_edge_t *e;
+    load_node_t *lnodes, *ln;
+    load_edge_t *ledges;
+    bor_real_t avg_err;
+    size_t i, len, len2, size, size2, loaded;
+
+    // everything is read into local storage first, so broken snapshot
+    // leaves {gng} untouched
+    params = gng->params;
+    rng = gng->rng;
+
+    svoSnapshotReadStart(&s, fin, SVO_SNAPSHOT_GNGT);
+
+    params.lambda  = svoSnapshotReadU64(&s);
+    params.eb      = svoSnapshotReadReal(&s);
+    params.en      = svoSnapshotReadReal(&s);
+    params.age_max = svoSnapshotReadU64(&s);
+    params.target  = svoSnapshotReadReal(&s);
+    avg_err        = svoSnapshotReadReal(&s);
+    svoSnapshotReadRng(&s, &rng);
+
+    // nodes are created by {load_node} but they are added into net only
+    // once whole snapshot is read
+    lnodes = NULL;
+    size = loaded = 0;
+    len = svoSnapshotReadU64(&s);
+    for (i = 0; i < len && !s.err; i++){
+        if (i == size){
+            size = (size == 0 ? 64 : 2 * size);
+            lnodes = BOR_REALLOC_ARR(lnodes, load_node_t, size);
+        }
+        ln = lnodes + i;
+        ln->err  = svoSnapshotReadReal(&s);
+        ln->won  = svoSnapshotReadU64(&s);
+        ln->wins = svoSnapshotReadU64(&s);
+        if (s.err || (ln->n = load_node(fin, data)) == NULL){
+            s.err = 1;
+            break;
+        }
+        ++loaded;
+    }
+
+    ledges = NULL;
+    size2 = 0;
+    len2 = svoSnapshotReadU64(&s);
+    for (i = 0; i < len2 && !s.err; i++){
+        if (i == size2){
+            size2 = (size2 == 0 ? 64 : 2 * size2);
+            ledges = BOR_REALLOC_ARR(ledges, load_edge_t, size2);
+        }
+        ledges[i].n1       = svoSnapshotReadU64(&s);
+        ledges[i].n2       = svoSnapshotReadU64(&s);
+        ledges[i].age_base = svoSnapshotReadU64(&s);
+        if (ledges[i].n1 >= len || ledges[i].n2 >= len)
+            s.err = 1;
+    }
+
+    if (s.err){
+        // nodes created so far aren't part of net
+        for (i = 0; i < loaded; i++)
+            gng->ops.del_node(lnodes[i].n, gng->ops.del_node_data);
+    }else{
+        gng->params  = params;
+        gng->avg_err = avg_err;
+        gng->rng     = rng;
+
+        // throw away current net
+        list = svoGNGTNodes(gng);
+        BOR_LIST_FOR_EACH_SAFE(list, item, itemtmp){
+            n = svoGNGTNodeFromList(item);
+            svoGNGTNodeDisconnect(gng, n);
+            svoGNGTNodeDel(gng, n);
+        }
+
+        for (i = 0; i < len; i++){
+            ln = lnodes + i;
+            svoGNGTNodeAdd(gng, ln->n);
+            ln->n->err  = ln->err;
+            ln->n->won  = ln->won;
+            ln->n->wins = ln->wins;
+        }
+
+        for (i = 0; i < len2; i++){
+            e = svoGNGTEdgeNew(gng, lnodes[ledges[i].n1].n,
+                               lnodes[ledges[i].n2].n);
+            e->age_base = ledges[i].age_base;
+        }
+    }
+
+    if (lnodes)
+        BOR_FREE(lnodes);
+    if (ledges)
+        BOR_FREE(ledges);
+
+    return svoSnapshotEnd(&s, "GNG-T");
+}
+
+
+void svoGNGTNodeDelLater(svo_gngt_t *gng, svo_gngt_node_t *n)
+{
+    if (gng->batch_del_len == gng->batch_del_size){
+        gng->batch_del_size = (gng->batch_del_size == 0
+                                    ? 64 : 2 * gng->batch_del_size);
+        gng->batch_del = BOR_REALLOC_ARR(gng->batch_del, svo_gngt_node_t *,
+                                         gng->batch_del_size);
+    }
+    gng->batch_del[gng->batch_del_len++] = n;
+}
 
 void svoGNGTNodeDisconnect(svo_gngt_t *gng, svo_gngt_node_t *n)
 {
@@ -304,8 +561,8 @@ svo_gngt_edge_t *svoGNGTEdgeNew(svo_gngt_t *gng, svo_gngt_node_t *n1,
 {
     svo_gngt_edge_t *e;
 
-    e = BOR_ALLOC(svo_gngt_edge_t);
-    e->age = 0;
+    e = svoPoolAlloc(&gng->edge_pool);
+    e->age_base = n1->wins + n2->wins;
 
     borNetAddEdge(gng->net, &e->edge, &n1->node, &n2->node);
 
@@ -315,7 +572,7 @@ svo_gngt_edge_t *svoGNGTEdgeNew(svo_gngt_t *gng, svo_gngt_node_t *n1,
 void svoGNGTEdgeDel(svo_gngt_t *gng, svo_gngt_edge_t *edge)
 {
     borNetRemoveEdge(gng->net, &edge->edge);
-    BOR_FREE(edge);
+    svoPoolRelease(&gng->edge_pool, edge);
 }
 
 void svoGNGTEdgeBetweenDel(svo_gngt_t *gng,
@@ -328,17 +585,15 @@ void svoGNGTEdgeBetweenDel(svo_gngt_t *gng,
 }
 
 
-
-static void svoGNGTHebbianLearning(svo_gngt_t *gng,
-                                   svo_gngt_node_t *n1,
-                                   svo_gngt_node_t *n2)
+void svoGNGTHebbianLearning(svo_gngt_t *gng,
+                            svo_gngt_node_t *n1, svo_gngt_node_t *n2)
 {
     svo_gngt_edge_t *e;
 
     e = svoGNGTEdgeBetween(gng, n1, n2);
     if (!e)
         e = svoGNGTEdgeNew(gng, n1, n2);
-    e->age = 0;
+    e->age_base = n1->wins + n2->wins;
 }
 
 static svo_gngt_node_t *svoGNGTNodeNeighborWithHighestErr(svo_gngt_t *gng,
@@ -369,6 +624,38 @@ static svo_gngt_node_t *svoGNGTNodeNeighborWithHighestErr(svo_gngt_t *gng,
 }
 
 
+static int batchDelCmp(const void *a, const void *b)
+{
+    const svo_gngt_node_t *n1 = *(const svo_gngt_node_t **)a;
+    const svo_gngt_node_t *n2 = *(const svo_gngt_node_t **)b;
+
+    if (n1 < n2)
+        return -1;
+    if (n1 > n2)
+        return 1;
+    return 0;
+}
+
+static void batchDelIsolated(svo_gngt_t *gng)
+{
+    svo_gngt_node_t *n;
+    size_t i;
+
+    // the same node could become isolated several times
+    qsort(gng->batch_del, gng->batch_del_len, sizeof(svo_gngt_node_t *),
+          batchDelCmp);
+
+    for (i = 0; i < gng->batch_del_len; i++){
+        n = gng->batch_del[i];
+        if (i > 0 && n == gng->batch_del[i - 1])
+            continue;
+
+        if (borNetNodeEdgesLen(&n->node) == 0)
+            svoGNGTNodeDel(gng, n);
+    }
+    gng->batch_del_len = 0;
+}
+
 static void nodeFinalDel(bor_net_node_t *node, void *data)
 {
     svo_gngt_t *gng = (svo_gngt_t *)data;
@@ -380,5 +667,5 @@ static void nodeFinalDel(bor_net_node_t *node, void *data)
 
 static void delEdge(bor_net_edge_t *edge, void *data)
 {
-    BOR_FREE(edge);
+    // edges are released all at once with edge pool
 }
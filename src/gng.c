@@ -14,9 +14,11 @@
  *  See the License for more information.
  */
 
+#include <stdlib.h>
 #include <boruvka/alloc.h>
 #include <boruvka/dbg.h>
 #include "gng/gng.h"
+#include "gng/gng-algorithm.h"
 
 
 /** Should return true if n1 > n2 - this is used for err-heap */
@@ -28,6 +30,9 @@ static int errHeapLT(const bor_pairheap_node_t *n1,
 static void nodeFinalDel(bor_net_node_t *node, void *data);
 static void delEdge(bor_net_edge_t *edge, void *data);
 
+/** Deletes nodes stored in .batch_del that are still isolated */
+static void batchDelIsolated(svo_gng_t *gng);
+
 void svoGNGOpsInit(svo_gng_ops_t *ops)
 {
     bzero(ops, sizeof(svo_gng_ops_t));
@@ -48,8 +53,6 @@ svo_gng_t *svoGNGNew(const svo_gng_ops_t *ops,
                      const svo_gng_params_t *params)
 {
     svo_gng_t *gng;
-    size_t i;
-    bor_real_t maxbeta;
 
     gng = BOR_ALLOC(svo_gng_t);
 
@@ -75,6 +78,12 @@ svo_gng_t *svoGNGNew(const svo_gng_ops_t *ops,
         gng->ops.dist2_data = gng->ops.data;
     if (!gng->ops.move_towards_data)
         gng->ops.move_towards_data = gng->ops.data;
+    if (!gng->ops.input_signal_batch_data)
+        gng->ops.input_signal_batch_data = gng->ops.data;
+    if (!gng->ops.nearest_batch_data)
+        gng->ops.nearest_batch_data = gng->ops.data;
+    if (!gng->ops.move_towards_many_data)
+        gng->ops.move_towards_many_data = gng->ops.data;
     if (!gng->ops.terminate_data)
         gng->ops.terminate_data = gng->ops.data;
     if (!gng->ops.callback_data)
@@ -84,35 +93,30 @@ svo_gng_t *svoGNGNew(const svo_gng_ops_t *ops,
     // initialize error heap
     gng->err_heap = borPairHeapNew(errHeapLT, (void *)gng);
 
-    // precompute beta^n
-    gng->beta_n = BOR_ALLOC_ARR(bor_real_t, gng->params.lambda);
-    gng->beta_n[0] = gng->params.beta;
-    for (i = 1; i < gng->params.lambda; i++){
-        gng->beta_n[i] = gng->beta_n[i - 1] * gng->params.beta;
-    }
-
-    // precompute beta^(n * lambda)
-    maxbeta = gng->beta_n[gng->params.lambda - 1];
-    gng->beta_lambda_n_len = 1000;
-    gng->beta_lambda_n = BOR_ALLOC_ARR(bor_real_t, gng->beta_lambda_n_len);
-    gng->beta_lambda_n[0] = maxbeta;
-    for (i = 1; i < gng->beta_lambda_n_len; i++){
-        gng->beta_lambda_n[i] = gng->beta_lambda_n[i - 1] * maxbeta;
-    }
+    // error counters
+    gng->err_scale     = BOR_ONE;
+    gng->err_scale_inc = BOR_ONE / gng->params.beta;
 
     gng->cycle = 1L;
     gng->step  = 1;
 
+    svoPoolInit(&gng->edge_pool, sizeof(svo_gng_edge_t), 0);
+
+    gng->batch_is = NULL;
+    gng->batch_win = NULL;
+    gng->batch_size = 0;
+    gng->batch_del = NULL;
+    gng->batch_del_len = gng->batch_del_size = 0;
+    gng->neigh = NULL;
+    gng->neigh_size = 0;
+
+    svoStatsReset(&gng->stats);
+
     return gng;
 }
 
 void svoGNGDel(svo_gng_t *gng)
 {
-    if (gng->beta_n)
-        BOR_FREE(gng->beta_n);
-    if (gng->beta_lambda_n)
-        BOR_FREE(gng->beta_lambda_n);
-
     if (gng->net){
         borNetDel2(gng->net, nodeFinalDel, gng,
                               delEdge, gng);
@@ -121,30 +125,28 @@ void svoGNGDel(svo_gng_t *gng)
     if (gng->err_heap)
         borPairHeapDel(gng->err_heap);
 
+    svoPoolFree(&gng->edge_pool);
+
+    if (gng->batch_is)
+        BOR_FREE(gng->batch_is);
+    if (gng->batch_win)
+        BOR_FREE(gng->batch_win);
+    if (gng->batch_del)
+        BOR_FREE(gng->batch_del);
+    if (gng->neigh)
+        BOR_FREE(gng->neigh);
+
     BOR_FREE(gng);
 }
 
 
 void svoGNGRun(svo_gng_t *gng)
 {
-    unsigned long cycle;
-    size_t i;
-
-    cycle = 0;
-    svoGNGInit(gng);
-
-    do {
-        for (i = 0; i < gng->params.lambda; i++){
-            svoGNGLearn(gng);
-        }
-        svoGNGNewNode(gng);
-
-        cycle++;
-        if (gng->ops.callback && gng->ops.callback_period == cycle){
-            gng->ops.callback(gng->ops.callback_data);
-            cycle = 0L;
-        }
-    } while (!gng->ops.terminate(gng->ops.terminate_data));
+    if (gng->ops.input_signal_batch || gng->ops.nearest_batch){
+        __svoGNGRun(gng, svoGNGLearn, svoGNGLearnBatch);
+    }else{
+        __svoGNGRun(gng, svoGNGLearn, NULL);
+    }
 }
 
 void svoGNGInit(svo_gng_t *gng)
@@ -172,74 +174,80 @@ void svoGNGInit(svo_gng_t *gng)
 
 void svoGNGLearn(svo_gng_t *gng)
 {
-    const void *input_signal;
-    bor_net_node_t *nn;
-    svo_gng_node_t *n1, *n2, *n;
-    bor_net_edge_t *nedge;
-    svo_gng_edge_t *edge;
-    bor_real_t dist2;
-    bor_list_t *list, *item, *item_tmp;
+    __svoGNGLearn(gng, gng->ops.input_signal, gng->ops.nearest,
+                  gng->ops.dist2, gng->ops.move_towards,
+                  gng->ops.move_towards_many);
+}
 
-    if (gng->step > gng->params.lambda){
-        gng->cycle += 1L;
-        gng->step = 1;
-    }
+void svoGNGLearnBatch(svo_gng_t *gng, size_t k)
+{
+    const void *is;
+    svo_gng_node_t *n1, *n2;
+    size_t i;
 
-    // 1. Get input signal
-    input_signal = gng->ops.input_signal(gng->ops.input_signal_data);
-
-    // 2. Find two nearest nodes to input signal
-    gng->ops.nearest(input_signal, &n1, &n2, gng->ops.nearest_data);
-
-    // 3. Create connection between n1 and n2 if doesn't exist and set age
-    //    to zero
-    svoGNGHebbianLearning(gng, n1, n2);
-
-    // 4. Increase error counter of winner node
-    dist2 = gng->ops.dist2(input_signal, n1, gng->ops.dist2_data);
-    svoGNGNodeIncError(gng, n1, dist2 * gng->beta_n[gng->params.lambda - gng->step]);
-
-    // 5. Adapt nodes to input signal using fractions eb and en
-    // + 6. Increment age of all edges by one
-    // + 7. Remove edges with age higher than age_max
-    gng->ops.move_towards(n1, input_signal, gng->params.eb,
-                           gng->ops.move_towards_data);
-    // adapt also direct topological neighbors of winner node
-    list = borNetNodeEdges(&n1->node);
-    BOR_LIST_FOR_EACH_SAFE(list, item, item_tmp){
-        nedge = borNetEdgeFromNodeList(item);
-        edge  = bor_container_of(nedge, svo_gng_edge_t, edge);
-        nn   = borNetEdgeOtherNode(&edge->edge, &n1->node);
-        n    = bor_container_of(nn, svo_gng_node_t, node);
-
-        // increase age (6.)
-        edge->age += 1;
-
-        // remove edge if it has age higher than age_max (7.)
-        if (edge->age > gng->params.age_max){
-            svoGNGEdgeDel(gng, edge);
-
-            if (borNetNodeEdgesLen(nn) == 0){
-                // remove node if not connected into net anymore
-                svoGNGNodeDel(gng, n);
-                n = NULL;
+    if (!gng->ops.nearest_batch){
+        // Each signal is fetched only after the previous one was applied,
+        // so it has to stay valid only until the next call as in
+        // svoGNGLearn()
+        for (i = 0; i < k; i++){
+            SVO_STATS_START(&gng->stats);
+            if (gng->ops.input_signal_batch){
+                gng->ops.input_signal_batch(&is, 1,
+                                            gng->ops.input_signal_batch_data);
+            }else{
+                is = gng->ops.input_signal(gng->ops.input_signal_data);
             }
-        }
+            SVO_STATS_LAP(&gng->stats, SVO_STATS_INPUT);
+
+            gng->ops.nearest(is, &n1, &n2, gng->ops.nearest_data);
+            SVO_STATS_LAP(&gng->stats, SVO_STATS_NEAREST);
 
-        // move node (5.)
-        if (n){
-            gng->ops.move_towards(n, input_signal, gng->params.en,
-                gng->ops.move_towards_data);
+            __svoGNGLearnApply(gng, is, n1, n2, 0,
+                               gng->ops.dist2, gng->ops.move_towards,
+                               gng->ops.move_towards_many);
         }
+        return;
     }
 
-    // remove winning node if not connected into net
-    if (borNetNodeEdgesLen(&n1->node) == 0){
-        // remove node if not connected into net anymore
-        svoGNGNodeDel(gng, n1);
+    if (k > gng->batch_size){
+        gng->batch_size = k;
+        gng->batch_is = BOR_REALLOC_ARR(gng->batch_is, const void *, k);
+        gng->batch_win = BOR_REALLOC_ARR(gng->batch_win,
+                                         svo_gng_node_t *, 2 * k);
     }
 
-    ++gng->step;
+    SVO_STATS_START(&gng->stats);
+
+    // 1. Get all input signals
+    if (gng->ops.input_signal_batch){
+        gng->ops.input_signal_batch(gng->batch_is, k,
+                                    gng->ops.input_signal_batch_data);
+    }else{
+        for (i = 0; i < k; i++){
+            gng->batch_is[i] = gng->ops.input_signal(
+                                    gng->ops.input_signal_data);
+        }
+    }
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_INPUT);
+
+    // 2. Find two nearest nodes to all input signals at once, the net
+    //    isn't changed meanwhile
+    gng->ops.nearest_batch(gng->batch_is, k, gng->batch_win,
+                           gng->ops.nearest_batch_data);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_NEAREST);
+
+    // 3. Apply learning steps in order of signals
+    gng->batch_del_len = 0;
+    for (i = 0; i < k; i++){
+        __svoGNGLearnApply(gng, gng->batch_is[i], gng->batch_win[2 * i],
+                           gng->batch_win[2 * i + 1], 1,
+                           gng->ops.dist2, gng->ops.move_towards,
+                           gng->ops.move_towards_many);
+    }
+
+    // 4. Remove nodes that are still isolated
+    batchDelIsolated(gng);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_PRUNE);
 }
 
 void svoGNGNewNode(svo_gng_t *gng)
@@ -247,6 +255,8 @@ void svoGNGNewNode(svo_gng_t *gng)
     svo_gng_node_t *q, *f, *r;
     svo_gng_edge_t *eqf;
 
+    SVO_STATS_START(&gng->stats);
+
     // 1. Get node with highest error counter and its neighbor with
     // highest error counter
     svoGNGNodeWithHighestError2(gng, &q, &f, &eqf);
@@ -267,8 +277,8 @@ void svoGNGNewNode(svo_gng_t *gng)
     // 6. Set error counter of new node (r)
     r->err  = q->err + f->err;
     r->err /= BOR_REAL(2.);
-    r->err_cycle = gng->cycle;
     borPairHeapUpdate(gng->err_heap, &r->err_heap);
+    SVO_STATS_LAP(&gng->stats, SVO_STATS_NEW_NODE);
 }
 
 
@@ -281,10 +291,6 @@ svo_gng_node_t *svoGNGNodeWithHighestError(svo_gng_t *gng)
     maxn = bor_container_of(max, svo_gng_node_t, err_heap);
 
     /*
-    if (maxn->err_cycle != gng->cycle){
-        DBG2("");
-    }
-
     {
         bor_list_t *list, *item;
         bor_net_node_t *nn;
@@ -297,7 +303,6 @@ svo_gng_node_t *svoGNGNodeWithHighestError(svo_gng_t *gng)
             nn = BOR_LIST_ENTRY(item, bor_net_node_t, list);
             n  = bor_container_of(nn, svo_gng_node_t, node);
 
-            svoGNGNodeFixError(gng, n);
             if (n->err > max){
                 max = n->err;
                 __maxn = n;
@@ -325,7 +330,7 @@ void svoGNGHebbianLearning(svo_gng_t *gng,
     }else{
         edge = bor_container_of(nedge, svo_gng_edge_t, edge);
     }
-    edge->age = 0;
+    edge->age_base = n1->wins + n2->wins;
 }
 
 static void __svoGNGNodeWithHighestError2(svo_gng_t *gng,
@@ -353,9 +358,6 @@ static void __svoGNGNodeWithHighestError2(svo_gng_t *gng,
         nn = borNetEdgeOtherNode(ne, &q->node);
         n  = bor_container_of(nn, svo_gng_node_t, node);
 
-        svoGNGNodeFixError(gng, n);
-        borPairHeapUpdate(gng->err_heap, &n->err_heap);
-
         if (n->err > err_highest){
             err_highest = n->err;
             n_highest   = n;
@@ -398,6 +400,23 @@ void svoGNGNodeWithHighestError2(svo_gng_t *gng,
 
 
 /*** Node functions ***/
+void __svoGNGErrRenormalise(svo_gng_t *gng)
+{
+    bor_list_t *list, *item;
+    bor_net_node_t *nn;
+    svo_gng_node_t *n;
+
+    // all stored errors are divided by the same factor so order of nodes
+    // in error heap doesn't change
+    list = borNetNodes(gng->net);
+    BOR_LIST_FOR_EACH(list, item){
+        nn = BOR_LIST_ENTRY(item, bor_net_node_t, list);
+        n  = bor_container_of(nn, svo_gng_node_t, node);
+        n->err /= gng->err_scale;
+    }
+    gng->err_scale = BOR_ONE;
+}
+
 void svoGNGNodeDisconnect(svo_gng_t *gng, svo_gng_node_t *node)
 {
     bor_list_t *edges, *item, *itemtmp;
@@ -413,20 +432,28 @@ void svoGNGNodeDisconnect(svo_gng_t *gng, svo_gng_node_t *node)
     }
 }
 
+void svoGNGNodeDelLater(svo_gng_t *gng, svo_gng_node_t *n)
+{
+    if (gng->batch_del_len == gng->batch_del_size){
+        gng->batch_del_size = (gng->batch_del_size == 0
+                                    ? 64 : 2 * gng->batch_del_size);
+        gng->batch_del = BOR_REALLOC_ARR(gng->batch_del, svo_gng_node_t *,
+                                         gng->batch_del_size);
+    }
+    gng->batch_del[gng->batch_del_len++] = n;
+}
+
 svo_gng_node_t *svoGNGNodeNewAtPos(svo_gng_t *gng, const void *is)
 {
     svo_gng_node_t *r, *n1, *n2;
-    svo_gng_edge_t *edge;
 
     gng->ops.nearest(is, &n1, &n2, gng->ops.nearest_data);
 
     r = gng->ops.new_node(is, gng->ops.new_node_data);
     svoGNGNodeAdd(gng, r);
 
-    edge = svoGNGEdgeNew(gng, r, n1);
-    edge->age = 0;
-    edge = svoGNGEdgeNew(gng, r, n2);
-    edge->age = 0;
+    svoGNGEdgeNew(gng, r, n1);
+    svoGNGEdgeNew(gng, r, n2);
 
     return r;
 }
@@ -438,8 +465,8 @@ svo_gng_edge_t *svoGNGEdgeNew(svo_gng_t *gng, svo_gng_node_t *n1,
 {
     svo_gng_edge_t *e;
 
-    e = BOR_ALLOC(svo_gng_edge_t);
-    e->age = 0;
+    e = svoPoolAlloc(&gng->edge_pool);
+    e->age_base = n1->wins + n2->wins;
 
     borNetAddEdge(gng->net, &e->edge, &n1->node, &n2->node);
 
@@ -449,7 +476,7 @@ svo_gng_edge_t *svoGNGEdgeNew(svo_gng_t *gng, svo_gng_node_t *n1,
 void svoGNGEdgeDel(svo_gng_t *gng, svo_gng_edge_t *e)
 {
     borNetRemoveEdge(gng->net, &e->edge);
-    BOR_FREE(e);
+    svoPoolRelease(&gng->edge_pool, e);
 }
 
 void svoGNGEdgeBetweenDel(svo_gng_t *gng,
@@ -471,18 +498,47 @@ static int errHeapLT(const bor_pairheap_node_t *_n1,
                      const bor_pairheap_node_t *_n2,
                      void *data)
 {
-    svo_gng_t *gng = (svo_gng_t *)data;
     svo_gng_node_t *n1, *n2;
 
     n1 = bor_container_of(_n1, svo_gng_node_t, err_heap);
     n2 = bor_container_of(_n2, svo_gng_node_t, err_heap);
 
-    svoGNGNodeFixError(gng, n1);
-    svoGNGNodeFixError(gng, n2);
     return n1->err > n2->err;
 }
 
 
+static int batchDelCmp(const void *a, const void *b)
+{
+    const svo_gng_node_t *n1 = *(const svo_gng_node_t **)a;
+    const svo_gng_node_t *n2 = *(const svo_gng_node_t **)b;
+
+    if (n1 < n2)
+        return -1;
+    if (n1 > n2)
+        return 1;
+    return 0;
+}
+
+static void batchDelIsolated(svo_gng_t *gng)
+{
+    svo_gng_node_t *n;
+    size_t i;
+
+    // the same node could become isolated several times
+    qsort(gng->batch_del, gng->batch_del_len, sizeof(svo_gng_node_t *),
+          batchDelCmp);
+
+    for (i = 0; i < gng->batch_del_len; i++){
+        n = gng->batch_del[i];
+        if (i > 0 && n == gng->batch_del[i - 1])
+            continue;
+
+        if (borNetNodeEdgesLen(&n->node) == 0)
+            svoGNGNodeDel(gng, n);
+    }
+    gng->batch_del_len = 0;
+}
+
 static void nodeFinalDel(bor_net_node_t *node, void *data)
 {
     svo_gng_t *gng = (svo_gng_t *)data;
@@ -494,5 +550,5 @@ static void nodeFinalDel(bor_net_node_t *node, void *data)
 
 static void delEdge(bor_net_edge_t *edge, void *data)
 {
-    BOR_FREE(edge);
+    // edges are released all at once with edge pool
 }
@@ -14,9 +14,12 @@
  *  See the License for more information.
  */
 
+#include <stdio.h>
 #include <boruvka/alloc.h>
 #include <boruvka/dbg.h>
 #include "gng/gsrm.h"
+#include "gng/snapshot.h"
+#include "gng/err-scale.h"
 
 /** Print progress */
 #define PR_PROGRESS(g) \
@@ -41,17 +44,25 @@
 struct _node_t {
     bor_vec3_t *v; /*!< Position of node (weight vector) */
 
-    bor_real_t err;               /*!< Error counter */
-    unsigned long err_cycle;      /*!< Last cycle in which were .err changed */
+    bor_real_t err;               /*!< Error counter (multiplied by
+                                       .err_scale if not unoptimized_err) */
     bor_pairheap_node_t err_heap; /*!< Connection into error heap */
+    svo_err_tree_el_t err_tree;   /*!< Connection into error tree */
 
     bor_mesh3_vertex_t vert; /*!< Vertex in mesh */
     bor_nn_el_t nn;          /*!< Struct for NN search */
+
+    unsigned long wins; /*!< Number of times node was a winner */
+
+    uint32_t id;   /*!< Unique id of node */
+    svo_adj_t adj; /*!< Neighbors keyed by .id (if params.compact_adj) */
 };
 typedef struct _node_t node_t;
 
 struct _edge_t {
-    int age;      /*!< Age of edge */
+    unsigned long age_base; /*!< Sum of .wins of both nodes when edge was
+                                 created or refreshed, age of edge is
+                                 current sum minus .age_base */
 
     bor_mesh3_edge_t edge; /*!< Edge in mesh */
 };
@@ -78,10 +89,21 @@ struct _svo_gsrm_cache_t {
 
     bor_real_t pp_min, pp_max; /*!< Min and max area2 of face - used in
                                     postprocessing */
+
+    uint32_t next_node_id; /*!< Id of next created node */
 };
 typedef struct _svo_gsrm_cache_t svo_gsrm_cache_t;
 
 
+/** Returns number of input signals */
+static size_t isLen(const svo_gsrm_t *g);
+/** (Re)builds .is_ptr and .is_order from point cloud .is (unshuffled) */
+static void isOrderInit(svo_gsrm_t *g);
+/** Shuffles .is_order */
+static void isOrderShuffle(svo_gsrm_t *g);
+/** Moves input signals from .is_pts to point cloud */
+static void isPtsToPC(svo_gsrm_t *g);
+
 /** Allocates and deallocates cache */
 static svo_gsrm_cache_t *cacheNew(void);
 static void cacheDel(svo_gsrm_cache_t *c);
@@ -94,8 +116,8 @@ static node_t *nodeNew(svo_gsrm_t *g, const bor_vec3_t *v);
 static void nodeDel(svo_gsrm_t *g, node_t *n);
 /** Deletes node - proposed for borMesh3Del2() function */
 static void nodeDel2(bor_mesh3_vertex_t *v, void *data);
-/** Fixes node's error counter, i.e. applies correct beta^(n * lambda) */
-_bor_inline void nodeFixError(svo_gsrm_t *gng, node_t *n);
+/** Propagates changed error counter into error heap/tree */
+_bor_inline void nodeErrUpdate(svo_gsrm_t *g, node_t *n);
 /** Increment error counter */
 _bor_inline void nodeIncError(svo_gsrm_t *gng, node_t *n, bor_real_t inc);
 /** Scales error counter */
@@ -109,6 +131,10 @@ static edge_t *edgeNew(svo_gsrm_t *g, node_t *n1, node_t *n2);
 static void edgeDel(svo_gsrm_t *g, edge_t *e);
 /** Deteles edge - proposed for borMesh3Del2() function */
 static void edgeDel2(bor_mesh3_edge_t *v, void *data);
+/** Returns edge connecting given vertices or NULL */
+_bor_inline bor_mesh3_edge_t *commonEdge(svo_gsrm_t *g,
+                                         bor_mesh3_vertex_t *v1,
+                                         bor_mesh3_vertex_t *v2);
 
 /** --- Face functions --- */
 static face_t *faceNew(svo_gsrm_t *g, edge_t *e, node_t *n);
@@ -116,7 +142,11 @@ static void faceDel(svo_gsrm_t *g, face_t *e);
 static void faceDel2(bor_mesh3_face_t *v, void *data);
 
 
-static int init(svo_gsrm_t *g);
+/** Initializes structures before run, if {restore} is true, generator
+ *  and order of input signals are left to be filled from snapshot */
+static int init(svo_gsrm_t *g, int restore);
+/** Writes snapshot into params.checkpoint */
+static void checkpoint(svo_gsrm_t *g);
 static void adapt(svo_gsrm_t *g);
 static void newNode(svo_gsrm_t *g);
 
@@ -128,7 +158,6 @@ static void drawInputPoint(svo_gsrm_t *g);
 static void echl(svo_gsrm_t *g);
 static void echlConnectNodes(svo_gsrm_t *g);
 static void echlMove(svo_gsrm_t *g);
-static void echlUpdate(svo_gsrm_t *g);
 /** Creates new node */
 static void createNewNode(svo_gsrm_t *g);
 
@@ -156,10 +185,9 @@ static void echlCreateFaces(svo_gsrm_t *g, edge_t *e);
 static void echlConnectNodes(svo_gsrm_t *g);
 /** Moves node towards input signal by given factor */
 _bor_inline void echlMoveNode(svo_gsrm_t *g, node_t *n, bor_real_t k);
-/** Move winner nodes towards input signal */
+/** Move winner nodes towards input signal and updates all edges
+ *  emitating from winning node */
 static void echlMove(svo_gsrm_t *g);
-/** Updates all edges emitating from winning node */
-static void echlUpdate(svo_gsrm_t *g);
 
 
 /** -- Create New Node functions --- */
@@ -238,6 +266,15 @@ void svoGSRMParamsInit(svo_gsrm_params_t *params)
     params->nn.linear.dim = 3;
 
     params->unoptimized_err = 0;
+    params->err_index = SVO_ERR_INDEX_HEAP;
+    params->compact_adj = 0;
+    params->edge_hash = 0;
+
+    params->perm_sampler = 0;
+    params->seed = 0L;
+
+    params->checkpoint = NULL;
+    params->checkpoint_period = 10000L;
 }
 
 svo_gsrm_t *svoGSRMNew(const svo_gsrm_params_t *params)
@@ -249,6 +286,7 @@ svo_gsrm_t *svoGSRMNew(const svo_gsrm_params_t *params)
 
     // initialize point cloude (input signals)
     g->is = borPCNew(3);
+    svoPtsInit(&g->is_pts);
 
     // init 3D mesh
     g->mesh = borMesh3New();
@@ -259,11 +297,25 @@ svo_gsrm_t *svoGSRMNew(const svo_gsrm_params_t *params)
 
     g->c = NULL;
 
-    g->beta_n = NULL;
-    g->beta_lambda_n = NULL;
-    g->beta_lambda_n_len = 0;
+    g->err_scale     = BOR_ONE;
+    g->err_scale_inc = BOR_ONE;
 
     g->err_heap = NULL;
+    g->err_tree = NULL;
+    g->edge_hash.keys = NULL;
+    g->sampler.runs = NULL;
+    g->sampler.len  = 0;
+    g->is_ptr = NULL;
+    g->is_order = NULL;
+    g->is_order_len = g->is_order_pos = 0;
+    svoRngInit(&g->rng, g->params.seed);
+
+    svoPoolInit(&g->node_pool, sizeof(node_t), 0);
+    svoPoolInit(&g->vec_pool, sizeof(bor_vec3_t), 0);
+    svoPoolInit(&g->edge_pool, sizeof(edge_t), 0);
+    svoPoolInit(&g->face_pool, sizeof(face_t), 0);
+
+    svoStatsReset(&g->stats);
 
     return g;
 }
@@ -275,7 +327,9 @@ void svoGSRMDel(svo_gsrm_t *g)
 
     if (g->is)
         borPCDel(g->is);
+    svoPtsClose(&g->is_pts);
 
+    // nodes, edges and faces are released wholesale with pools below
     if (g->mesh)
         borMesh3Del2(g->mesh, nodeDel2, (void *)g,
                               edgeDel2, (void *)g,
@@ -284,19 +338,92 @@ void svoGSRMDel(svo_gsrm_t *g)
     if (g->nn)
         borNNDel(g->nn);
 
-    if (g->beta_n)
-        BOR_FREE(g->beta_n);
-    if (g->beta_lambda_n)
-        BOR_FREE(g->beta_lambda_n);
     if (g->err_heap)
         borPairHeapDel(g->err_heap);
+    if (g->err_tree){
+        svoErrTreeFree(g->err_tree);
+        BOR_FREE(g->err_tree);
+    }
+    if (g->edge_hash.keys)
+        svoEdgeHashFree(&g->edge_hash);
+    svoSamplerFree(&g->sampler);
+    if (g->is_ptr)
+        BOR_FREE(g->is_ptr);
+    if (g->is_order)
+        BOR_FREE(g->is_order);
+
+    svoPoolFree(&g->node_pool);
+    svoPoolFree(&g->vec_pool);
+    svoPoolFree(&g->edge_pool);
+    svoPoolFree(&g->face_pool);
 
     BOR_FREE(g);
 }
 
 size_t svoGSRMAddInputSignals(svo_gsrm_t *g, const char *fn)
 {
-    return borPCAddFromFile(g->is, fn);
+    svo_pts_t pts;
+    size_t len;
+
+    if (svoPtsLoad(&pts, fn, 3, 0) != 0)
+        return 0;
+    len = pts.len;
+
+    // points are used in place only if they are the only input signals
+    // and memory layout of bor_vec3_t allows that
+    if (isLen(g) == 0 && sizeof(bor_vec3_t) == 3 * sizeof(bor_real_t)){
+        g->is_pts = pts;
+    }else{
+        isPtsToPC(g);
+        svoPtsAddToPC(&pts, g->is);
+        svoPtsClose(&pts);
+    }
+
+    return len;
+}
+
+static void isOrderInit(svo_gsrm_t *g)
+{
+    bor_pc_it_t it;
+    size_t i;
+
+    g->is_order_len = borPCLen(g->is);
+    g->is_ptr = BOR_REALLOC_ARR(g->is_ptr, bor_vec3_t *, g->is_order_len);
+    g->is_order = BOR_REALLOC_ARR(g->is_order, size_t, g->is_order_len);
+
+    borPCItInit(&it, g->is);
+    for (i = 0; !borPCItEnd(&it); i++, borPCItNext(&it)){
+        g->is_ptr[i] = (bor_vec3_t *)borPCItGet(&it);
+        g->is_order[i] = i;
+    }
+    g->is_order_pos = 0;
+}
+
+static void isOrderShuffle(svo_gsrm_t *g)
+{
+    size_t i, j, tmp;
+
+    // Fisher-Yates
+    for (i = g->is_order_len; i > 1; i--){
+        j = svoRngRange(&g->rng, i);
+        tmp = g->is_order[i - 1];
+        g->is_order[i - 1] = g->is_order[j];
+        g->is_order[j] = tmp;
+    }
+    g->is_order_pos = 0;
+}
+
+static size_t isLen(const svo_gsrm_t *g)
+{
+    return borPCLen(g->is) + g->is_pts.len;
+}
+
+static void isPtsToPC(svo_gsrm_t *g)
+{
+    if (g->is_pts.data){
+        svoPtsAddToPC(&g->is_pts, g->is);
+        svoPtsClose(&g->is_pts);
+    }
 }
 
 int svoGSRMRun(svo_gsrm_t *g)
@@ -304,7 +431,11 @@ int svoGSRMRun(svo_gsrm_t *g)
     size_t cycle;
 
     cycle = 0;
-    init(g);
+    if (borMesh3VerticesLen(g->mesh) == 0){
+        if (init(g, 0) != 0)
+            return -1;
+        meshInit(g);
+    }
 
     if (g->params.verbosity >= 1){
         PR_PROGRESS(g);
@@ -324,6 +455,13 @@ int svoGSRMRun(svo_gsrm_t *g)
         }
 
         g->cycle++;
+
+        // snapshot is taken after the counter is advanced, so that the
+        // resumed run starts with the next cycle
+        if (g->params.checkpoint && g->params.checkpoint_period > 0
+                && (g->cycle - 1) % g->params.checkpoint_period == 0){
+            checkpoint(g);
+        }
     } while (borMesh3VerticesLen(g->mesh) < g->params.max_nodes);
 
     if (g->params.verbosity >= 1){
@@ -332,7 +470,9 @@ int svoGSRMRun(svo_gsrm_t *g)
         fflush(stderr);
     }
 
+    SVO_STATS_START(&g->stats);
     learnTopology(g);
+    SVO_STATS_LAP(&g->stats, SVO_STATS_TOPOLOGY);
 
     return 0;
 }
@@ -342,6 +482,8 @@ int svoGSRMPostprocess(svo_gsrm_t *g)
 {
     bor_real_t min, max, avg;
 
+    SVO_STATS_START(&g->stats);
+
     // set up limits
     faceAreaStat(g, &min, &max, &avg);
     g->c->pp_min = min;
@@ -430,53 +572,52 @@ int svoGSRMPostprocess(svo_gsrm_t *g)
         fprintf(stderr, "\n");
     }
 
+    SVO_STATS_LAP(&g->stats, SVO_STATS_POSTPROCESS);
+
     return 0;
 }
 
 
-static int init(svo_gsrm_t *g)
+static int init(svo_gsrm_t *g, int restore)
 {
-    size_t i;
-    bor_real_t maxbeta;
     bor_real_t aabb[6];
 
     // check if there are some input signals
-    if (borPCLen(g->is) <= 3){
+    if (isLen(g) <= 3){
         DBG2("No input signals!");
         return -1;
     }
 
     g->cycle = 1L;
 
-    // initialize error heap
-    if (!g->params.unoptimized_err){
-        if (g->err_heap)
-            borPairHeapDel(g->err_heap);
-        g->err_heap = borPairHeapNew(errHeapLT, (void *)g);
+    // initialize error heap or tree
+    if (g->err_heap)
+        borPairHeapDel(g->err_heap);
+    g->err_heap = NULL;
+    if (g->err_tree){
+        svoErrTreeFree(g->err_tree);
+        BOR_FREE(g->err_tree);
     }
+    g->err_tree = NULL;
 
-    // precompute beta^n
-    if (g->beta_n)
-        BOR_FREE(g->beta_n);
-
-    g->beta_n = BOR_ALLOC_ARR(bor_real_t, g->params.lambda);
-    g->beta_n[0] = g->params.beta;
-    for (i = 1; i < g->params.lambda; i++){
-        g->beta_n[i] = g->beta_n[i - 1] * g->params.beta;
+    if (!g->params.unoptimized_err){
+        if (g->params.err_index == SVO_ERR_INDEX_TREE){
+            g->err_tree = BOR_ALLOC(svo_err_tree_t);
+            svoErrTreeInit(g->err_tree);
+        }else{
+            g->err_heap = borPairHeapNew(errHeapLT, (void *)g);
+        }
     }
 
-    // precompute beta^(n * lambda)
-    if (g->beta_lambda_n)
-        BOR_FREE(g->beta_lambda_n);
-
-    maxbeta = g->beta_n[g->params.lambda - 1];
+    // error counters
+    g->err_scale     = BOR_ONE;
+    g->err_scale_inc = BOR_ONE / g->params.beta;
 
-    g->beta_lambda_n_len = 1000;
-    g->beta_lambda_n = BOR_ALLOC_ARR(bor_real_t, g->beta_lambda_n_len);
-    g->beta_lambda_n[0] = maxbeta;
-    for (i = 1; i < g->beta_lambda_n_len; i++){
-        g->beta_lambda_n[i] = g->beta_lambda_n[i - 1] * maxbeta;
-    }
+    // initialize edge hash table
+    if (g->edge_hash.keys)
+        svoEdgeHashFree(&g->edge_hash);
+    if (g->params.edge_hash)
+        svoEdgeHashInit(&g->edge_hash);
 
     // initialize cache
     if (!g->c)
@@ -485,38 +626,400 @@ static int init(svo_gsrm_t *g)
     // initialize NN search structure
     if (g->nn)
         borNNDel(g->nn);
-    borPCAABB(g->is, aabb);
+    if (g->is_pts.data){
+        svoPtsAABB(&g->is_pts, aabb);
+    }else{
+        borPCAABB(g->is, aabb);
+    }
     g->params.nn.linear.dim = 3;
     g->params.nn.vptree.dim = 3;
     g->params.nn.gug.dim    = 3;
     g->params.nn.gug.aabb   = aabb;
     g->nn = borNNNew(&g->params.nn);
 
-    // first shuffle of all input signals
-    borPCPermutate(g->is);
-    // and initialize its iterator
-    borPCItInit(&g->isit, g->is);
+    svoSamplerFree(&g->sampler);
+    if (g->is_pts.data){
+        // mapped input signals can't be permutated
+        svoSamplerInitArr(&g->sampler, g->is_pts.data, g->is_pts.len, 3,
+                          g->params.seed);
+    }else if (g->params.perm_sampler){
+        svoSamplerInitPC(&g->sampler, g->is, g->params.seed);
+    }else{
+        isOrderInit(g);
+        if (!restore){
+            // first shuffle of all input signals
+            svoRngInit(&g->rng, g->params.seed);
+            isOrderShuffle(g);
+        }
+    }
 
 
     // start timer
     borTimerStart(&g->timer);
 
-    // initialize mesh with three random nodes
-    meshInit(g);
-
     return 0;
+}
+
+int svoGSRMSave(svo_gsrm_t *g, FILE *fout)
+{
+    svo_snapshot_t s;
+    bor_list_t *list, *item;
+    bor_mesh3_vertex_t *v;
+    bor_mesh3_vertex_t *vs[3];
+    bor_mesh3_edge_t *edge;
+    bor_mesh3_face_t *face;
+    node_t *n, *n2;
+    edge_t *e;
+    size_t i;
+
+    svoSnapshotWriteStart(&s, fout, SVO_SNAPSHOT_GSRM);
+
+    svoSnapshotWriteU64(&s, g->params.lambda);
+    svoSnapshotWriteReal(&s, g->params.eb);
+    svoSnapshotWriteReal(&s, g->params.en);
+    svoSnapshotWriteReal(&s, g->params.alpha);
+    svoSnapshotWriteReal(&s, g->params.beta);
+    svoSnapshotWriteU64(&s, g->params.age_max);
+    svoSnapshotWriteU64(&s, g->params.unoptimized_err);
+
+    svoSnapshotWriteReal(&s, g->err_scale);
+    svoSnapshotWriteReal(&s, g->err_scale_inc);
+    svoSnapshotWriteU64(&s, g->cycle);
+    svoSnapshotWriteU64(&s, g->c->next_node_id);
+    svoSnapshotWriteRng(&s, &g->rng);
+
+    // position of sampler
+    svoSnapshotWriteU64(&s, g->sampler.len);
+    if (g->sampler.len > 0)
+        svoSnapshotWriteU64(&s, svoSamplerTell(&g->sampler));
+
+    // order of point cloud reshuffled every epoch
+    svoSnapshotWriteU64(&s, g->is_order_len);
+    if (g->is_order_len > 0){
+        svoSnapshotWriteU64(&s, g->is_order_pos);
+        for (i = 0; i < g->is_order_len; i++)
+            svoSnapshotWriteU64(&s, g->is_order[i]);
+    }
+
+    svoSnapshotWriteU64(&s, borMesh3VerticesLen(g->mesh));
+    list = borMesh3Vertices(g->mesh);
+    BOR_LIST_FOR_EACH(list, item){
+        v = BOR_LIST_ENTRY(item, bor_mesh3_vertex_t, list);
+        n = bor_container_of(v, node_t, vert);
+
+        svoSnapshotWriteU64(&s, n->id);
+        svoSnapshotWriteU64(&s, n->wins);
+        svoSnapshotWriteReal(&s, n->err);
+        svoSnapshotWriteReal(&s, borVec3X(n->v));
+        svoSnapshotWriteReal(&s, borVec3Y(n->v));
+        svoSnapshotWriteReal(&s, borVec3Z(n->v));
+    }
+
+    svoSnapshotWriteU64(&s, borMesh3EdgesLen(g->mesh));
+    list = borMesh3Edges(g->mesh);
+    BOR_LIST_FOR_EACH(list, item){
+        edge = BOR_LIST_ENTRY(item, bor_mesh3_edge_t, list);
+        e  = bor_container_of(edge, edge_t, edge);
+        n  = bor_container_of(borMesh3EdgeVertex(edge, 0), node_t, vert);
+        n2 = bor_container_of(borMesh3EdgeVertex(edge, 1), node_t, vert);
+
+        svoSnapshotWriteU64(&s, n->id);
+        svoSnapshotWriteU64(&s, n2->id);
+        svoSnapshotWriteU64(&s, e->age_base);
+    }
+
+    svoSnapshotWriteU64(&s, borMesh3FacesLen(g->mesh));
+    list = borMesh3Faces(g->mesh);
+    BOR_LIST_FOR_EACH(list, item){
+        face = BOR_LIST_ENTRY(item, bor_mesh3_face_t, list);
+        borMesh3FaceVertices(face, vs);
+        for (i = 0; i < 3; i++){
+            n = bor_container_of(vs[i], node_t, vert);
+            svoSnapshotWriteU64(&s, n->id);
+        }
+    }
+
+    return svoSnapshotEnd(&s, "GSRM");
+}
+
+/** Node read from snapshot, see svoGSRMLoad() */
+struct _load_node_t {
+    uint64_t id;
+    unsigned long wins;
+    bor_real_t err;
+    bor_vec3_t v;
+};
+typedef struct _load_node_t load_node_t;
+
+/** Makes room for {i}'th element of array being read from snapshot, array
+ *  grows as it is read so that corrupted lengths can't request huge
+ *  allocations */
+static void *loadGrow(void *arr, size_t i, size_t *size, size_t el_size)
+{
+    if (i < *size)
+        return arr;
+    *size = (*size == 0 ? 64 : 2 * *size);
+    return BOR_REALLOC_ARR(arr, char, *size * el_size);
+}
+
+/** Builds mesh from nodes, edges (triplets id, id2, age_base) and faces
+ *  (triplets of ids) read from snapshot, returns -1 if they don't form
+ *  valid mesh */
+static int loadMesh(svo_gsrm_t *g, uint64_t next_id,
+                    const load_node_t *lnodes, size_t nodes_len,
+                    const uint64_t *ledges, size_t edges_len,
+                    const uint64_t *lfaces, size_t faces_len)
+{
+    node_t **nodes, *n, *ns[3];
+    edge_t *e;
+    bor_mesh3_edge_t *edge;
+    uint64_t id;
+    size_t i, j;
+    int ret = 0;
+
+    // nodes are addressed by their ids
+    nodes = BOR_ALLOC_ARR(node_t *, next_id);
+    for (id = 0; id < next_id; id++)
+        nodes[id] = NULL;
+
+    for (i = 0; i < nodes_len && ret == 0; i++){
+        if (nodes[lnodes[i].id]){
+            ret = -1;
+            break;
+        }
+
+        n = nodeNew(g, &lnodes[i].v);
+        n->id   = lnodes[i].id;
+        n->wins = lnodes[i].wins;
+        n->err  = lnodes[i].err;
+        if (g->err_tree || g->err_heap)
+            nodeErrUpdate(g, n);
+        nodes[n->id] = n;
+    }
+
+    for (i = 0; i < edges_len && ret == 0; i++){
+        if (!nodes[ledges[3 * i]] || !nodes[ledges[3 * i + 1]]){
+            ret = -1;
+            break;
+        }
+
+        e = edgeNew(g, nodes[ledges[3 * i]], nodes[ledges[3 * i + 1]]);
+        e->age_base = ledges[3 * i + 2];
+    }
+
+    for (i = 0; i < faces_len && ret == 0; i++){
+        for (j = 0; j < 3; j++){
+            ns[j] = nodes[lfaces[3 * i + j]];
+            if (!ns[j])
+                ret = -1;
+        }
+        if (ret != 0)
+            break;
+
+        edge = commonEdge(g, &ns[0]->vert, &ns[1]->vert);
+        if (!edge || !faceNew(g, bor_container_of(edge, edge_t, edge), ns[2]))
+            ret = -1;
+    }
+
+    BOR_FREE(nodes);
+    return ret;
+}
+
+int svoGSRMLoad(svo_gsrm_t *g, FILE *fin)
+{
+    svo_snapshot_t s;
+    svo_gsrm_params_t params, old_params;
+    svo_rng_t rng;
+    load_node_t *lnodes;
+    uint64_t *ledges, *lfaces, *order;
+    bor_list_t *list, *item, *itemtmp;
+    bor_real_t err_scale, err_scale_inc, x, y, z;
+    uint64_t drawn = 0, next_id, cycle, order_len, order_pos = 0;
+    size_t i, j, nodes_len, edges_len, faces_len, size;
+
+    if (borMesh3VerticesLen(g->mesh) != 0){
+        fprintf(stderr, "GSRM Error: Snapshot can be loaded only before"
+                        " mesh is created.\n");
+        return -1;
+    }
+
+    // whole snapshot is read into local storage first, so broken snapshot
+    // leaves {g} untouched
+    params = g->params;
+    rng = g->rng;
+
+    svoSnapshotReadStart(&s, fin, SVO_SNAPSHOT_GSRM);
+
+    params.lambda  = svoSnapshotReadU64(&s);
+    params.eb      = svoSnapshotReadReal(&s);
+    params.en      = svoSnapshotReadReal(&s);
+    params.alpha   = svoSnapshotReadReal(&s);
+    params.beta    = svoSnapshotReadReal(&s);
+    params.age_max = svoSnapshotReadU64(&s);
+    if (svoSnapshotReadU64(&s) != (uint64_t)params.unoptimized_err)
+        s.err = 1;
+
+    err_scale     = svoSnapshotReadReal(&s);
+    err_scale_inc = svoSnapshotReadReal(&s);
+    cycle         = svoSnapshotReadU64(&s);
+    next_id       = svoSnapshotReadU64(&s);
+    svoSnapshotReadRng(&s, &rng);
+    if (err_scale <= BOR_ZERO || params.beta <= BOR_ZERO
+            || next_id > UINT32_MAX)
+        s.err = 1;
+
+    // the same input signals must be already added
+    if (svoSnapshotReadU64(&s) != g->sampler.len)
+        s.err = 1;
+    if (g->sampler.len > 0)
+        drawn = svoSnapshotReadU64(&s);
+
+    // permutation of point cloud, its length is checked against point
+    // cloud once it is known (after init())
+    order = NULL;
+    size = 0;
+    order_len = svoSnapshotReadU64(&s);
+    if (order_len > 0){
+        order_pos = svoSnapshotReadU64(&s);
+        if (order_pos > order_len)
+            s.err = 1;
+    }
+    for (i = 0; i < order_len && !s.err; i++){
+        order = loadGrow(order, i, &size, sizeof(uint64_t));
+        order[i] = svoSnapshotReadU64(&s);
+        if (order[i] >= order_len)
+            s.err = 1;
+    }
+
+    lnodes = NULL;
+    size = 0;
+    nodes_len = svoSnapshotReadU64(&s);
+    for (i = 0; i < nodes_len && !s.err; i++){
+        lnodes = loadGrow(lnodes, i, &size, sizeof(load_node_t));
+        lnodes[i].id   = svoSnapshotReadU64(&s);
+        lnodes[i].wins = svoSnapshotReadU64(&s);
+        lnodes[i].err  = svoSnapshotReadReal(&s);
+        x = svoSnapshotReadReal(&s);
+        y = svoSnapshotReadReal(&s);
+        z = svoSnapshotReadReal(&s);
+        borVec3Set(&lnodes[i].v, x, y, z);
+        if (lnodes[i].id >= next_id)
+            s.err = 1;
+    }
+
+    ledges = NULL;
+    size = 0;
+    edges_len = svoSnapshotReadU64(&s);
+    for (i = 0; i < edges_len && !s.err; i++){
+        ledges = loadGrow(ledges, i, &size, 3 * sizeof(uint64_t));
+        for (j = 0; j < 3; j++)
+            ledges[3 * i + j] = svoSnapshotReadU64(&s);
+        if (ledges[3 * i] >= next_id || ledges[3 * i + 1] >= next_id)
+            s.err = 1;
+    }
+
+    lfaces = NULL;
+    size = 0;
+    faces_len = svoSnapshotReadU64(&s);
+    for (i = 0; i < faces_len && !s.err; i++){
+        lfaces = loadGrow(lfaces, i, &size, 3 * sizeof(uint64_t));
+        for (j = 0; j < 3; j++){
+            lfaces[3 * i + j] = svoSnapshotReadU64(&s);
+            if (lfaces[3 * i + j] >= next_id)
+                s.err = 1;
+        }
+    }
+
+    // structures are initialized with restored parameters and mesh is
+    // built, if the snapshot turns out to be inconsistent, mesh is
+    // emptied again and parameters are restored, so svoGSRMRun() starts
+    // from scratch
+    if (!s.err){
+        old_params = g->params;
+        g->params = params;
+
+        if (init(g, 1) != 0 || order_len != g->is_order_len){
+            s.err = 1;
+        }else{
+            g->err_scale     = err_scale;
+            g->err_scale_inc = err_scale_inc;
+            if (loadMesh(g, next_id, lnodes, nodes_len, ledges, edges_len,
+                         lfaces, faces_len) != 0)
+                s.err = 1;
+        }
 
+        if (s.err){
+            list = borMesh3Vertices(g->mesh);
+            BOR_LIST_FOR_EACH_SAFE(list, item, itemtmp){
+                nodeDel(g, bor_container_of(BOR_LIST_ENTRY(item,
+                                                bor_mesh3_vertex_t, list),
+                                            node_t, vert));
+            }
+            g->params = old_params;
+            if (g->c)
+                g->c->next_node_id = 0;
+        }else{
+            g->cycle = cycle;
+            g->c->next_node_id = next_id;
+            g->rng = rng;
+            g->is_order_pos = order_pos;
+            for (i = 0; i < order_len; i++)
+                g->is_order[i] = order[i];
+            if (g->sampler.len > 0)
+                svoSamplerSeek(&g->sampler, drawn);
+        }
+    }
+
+    if (order)
+        BOR_FREE(order);
+    if (lnodes)
+        BOR_FREE(lnodes);
+    if (ledges)
+        BOR_FREE(ledges);
+    if (lfaces)
+        BOR_FREE(lfaces);
+
+    return svoSnapshotEnd(&s, "GSRM");
+}
+
+static void checkpoint(svo_gsrm_t *g)
+{
+    char fn[1024];
+    FILE *fout;
+    int ret;
+
+    // snapshot is written aside and then renamed, so the previous one is
+    // kept untouched if the process is killed meanwhile
+    snprintf(fn, 1024, "%s.tmp", g->params.checkpoint);
+    fout = fopen(fn, "wb");
+    if (!fout){
+        fprintf(stderr, "GSRM Error: Can't open file `%s'.\n", fn);
+        return;
+    }
+
+    ret = svoGSRMSave(g, fout);
+    if (fclose(fout) != 0)
+        ret = -1;
+
+    if (ret != 0 || rename(fn, g->params.checkpoint) != 0){
+        fprintf(stderr, "GSRM Error: Can't write checkpoint `%s'.\n",
+                g->params.checkpoint);
+    }
 }
 
 static void adapt(svo_gsrm_t *g)
 {
+    SVO_STATS_START(&g->stats);
     drawInputPoint(g);
+    SVO_STATS_LAP(&g->stats, SVO_STATS_INPUT);
     echl(g);
 }
 
 static void newNode(svo_gsrm_t *g)
 {
+    SVO_STATS_START(&g->stats);
     createNewNode(g);
+    SVO_STATS_LAP(&g->stats, SVO_STATS_NEW_NODE);
 }
 
 static svo_gsrm_cache_t *cacheNew(void)
@@ -533,6 +1036,8 @@ static svo_gsrm_cache_t *cacheNew(void)
     c->err_counter_mark = 0;
     c->err_counter_scale = BOR_ONE;
 
+    c->next_node_id = 0;
+
     return c;
 }
 
@@ -549,8 +1054,9 @@ static node_t *nodeNew(svo_gsrm_t *g, const bor_vec3_t *v)
 {
     node_t *n;
 
-    n = BOR_ALLOC(node_t);
-    n->v = borVec3Clone(v);
+    n = svoPoolAlloc(&g->node_pool);
+    n->v = svoPoolAlloc(&g->vec_pool);
+    borVec3Copy(n->v, v);
 
     // initialize mesh's vertex struct with weight vector
     borMesh3VertexSetCoords(&n->vert, n->v);
@@ -563,10 +1069,16 @@ static node_t *nodeNew(svo_gsrm_t *g, const bor_vec3_t *v)
     // and add node into cells
     borNNAdd(g->nn, &n->nn);
 
+    n->wins = 0L;
+
+    n->id = g->c->next_node_id++;
+    svoAdjInit(&n->adj);
+
     // set error counter
     n->err = BOR_ZERO;
-    if (!g->params.unoptimized_err){
-        n->err_cycle = g->cycle;
+    if (g->err_tree){
+        svoErrTreeAdd(g->err_tree, &n->err_tree, n->err);
+    }else if (g->err_heap){
         borPairHeapAdd(g->err_heap, &n->err_heap);
     }
 
@@ -576,34 +1088,25 @@ static node_t *nodeNew(svo_gsrm_t *g, const bor_vec3_t *v)
     return n;
 }
 
-_bor_inline void nodeFixError(svo_gsrm_t *g, node_t *n)
+_bor_inline void nodeErrUpdate(svo_gsrm_t *g, node_t *n)
 {
-    unsigned long diff;
-
-    diff = g->cycle - n->err_cycle;
-    if (diff > 0 && diff <= g->beta_lambda_n_len){
-        n->err *= g->beta_lambda_n[diff - 1];
-    }else if (diff > 0){
-        n->err *= g->beta_lambda_n[g->params.lambda - 1];
-
-        diff = diff - g->beta_lambda_n_len;
-        n->err *= pow(g->beta_n[g->params.lambda - 1], diff);
+    if (g->err_tree){
+        svoErrTreeUpdate(g->err_tree, &n->err_tree, n->err);
+    }else{
+        borPairHeapUpdate(g->err_heap, &n->err_heap);
     }
-    n->err_cycle = g->cycle;
 }
 
 _bor_inline void nodeIncError(svo_gsrm_t *g, node_t *n, bor_real_t inc)
 {
-    nodeFixError(g, n);
-    n->err += inc;
-    borPairHeapUpdate(g->err_heap, &n->err_heap);
+    n->err += inc * g->err_scale;
+    nodeErrUpdate(g, n);
 }
 
 _bor_inline void nodeScaleError(svo_gsrm_t *g, node_t *n, bor_real_t scale)
 {
-    nodeFixError(g, n);
     n->err *= scale;
-    borPairHeapUpdate(g->err_heap, &n->err_heap);
+    nodeErrUpdate(g, n);
 }
 
 static void nodeDel(svo_gsrm_t *g, node_t *n)
@@ -632,32 +1135,36 @@ static void nodeDel(svo_gsrm_t *g, node_t *n)
         exit(-1);
     }
 
-    borVec3Del(n->v);
+    svoPoolRelease(&g->vec_pool, n->v);
 
     // remove node from cells
     borNNRemove(g->nn, &n->nn);
 
-    // remove from error heap
-    if (!g->params.unoptimized_err){
+    // remove from error heap or tree
+    if (g->err_tree){
+        svoErrTreeRemove(g->err_tree, &n->err_tree);
+    }else if (g->err_heap){
         borPairHeapRemove(g->err_heap, &n->err_heap);
     }
 
+    if (g->params.compact_adj)
+        svoAdjFree(&n->adj);
+
     // Note: no need of deallocation of .vert and .cells
-    BOR_FREE(n);
+    svoPoolRelease(&g->node_pool, n);
 }
 
 static void nodeDel2(bor_mesh3_vertex_t *v, void *data)
 {
     svo_gsrm_t *g = (svo_gsrm_t *)data;
     node_t *n;
-    n = bor_container_of(v, node_t, vert);
-
-    borVec3Del(n->v);
 
-    // remove node from cells
-    borNNRemove(g->nn, &n->nn);
-
-    BOR_FREE(n);
+    // node and its weight vector are released with pools and cells
+    // are deleted as a whole, only spilled adjacency is owned by node
+    if (g->params.compact_adj){
+        n = bor_container_of(v, node_t, vert);
+        svoAdjFree(&n->adj);
+    }
 }
 
 
@@ -667,11 +1174,18 @@ static edge_t *edgeNew(svo_gsrm_t *g, node_t *n1, node_t *n2)
 {
     edge_t *e;
 
-    e = BOR_ALLOC(edge_t);
-    e->age = 0;
+    e = svoPoolAlloc(&g->edge_pool);
+    e->age_base = n1->wins + n2->wins;
 
     borMesh3AddEdge(g->mesh, &e->edge, &n1->vert, &n2->vert);
 
+    if (g->params.compact_adj){
+        svoAdjAdd(&n1->adj, n2->id, e);
+        svoAdjAdd(&n2->adj, n1->id, e);
+    }
+    if (g->params.edge_hash)
+        svoEdgeHashAdd(&g->edge_hash, n1->id, n2->id, e);
+
     //DBG("e: %lx, edge: %lx", (long)e, (long)&e->edge);
 
     return e;
@@ -680,6 +1194,7 @@ static edge_t *edgeNew(svo_gsrm_t *g, node_t *n1, node_t *n2)
 static void edgeDel(svo_gsrm_t *g, edge_t *e)
 {
     bor_mesh3_face_t *face;
+    node_t *n1, *n2;
     int res;
 
     // first remove incidenting faces
@@ -687,6 +1202,17 @@ static void edgeDel(svo_gsrm_t *g, edge_t *e)
         faceDel(g, bor_container_of(face, face_t, face));
     }
 
+    if (g->params.compact_adj || g->params.edge_hash){
+        n1 = bor_container_of(borMesh3EdgeVertex(&e->edge, 0), node_t, vert);
+        n2 = bor_container_of(borMesh3EdgeVertex(&e->edge, 1), node_t, vert);
+        if (g->params.compact_adj){
+            svoAdjRemove(&n1->adj, n2->id);
+            svoAdjRemove(&n2->adj, n1->id);
+        }
+        if (g->params.edge_hash)
+            svoEdgeHashRemove(&g->edge_hash, n1->id, n2->id);
+    }
+
     // then remove edge itself
     res = borMesh3RemoveEdge(g->mesh, &e->edge);
     if (bor_unlikely(res != 0)){
@@ -694,14 +1220,33 @@ static void edgeDel(svo_gsrm_t *g, edge_t *e)
         exit(-1);
     }
 
-    BOR_FREE(e);
+    svoPoolRelease(&g->edge_pool, e);
 }
 
 static void edgeDel2(bor_mesh3_edge_t *edge, void *data)
 {
+    // edges are released all at once with edge pool
+}
+
+_bor_inline bor_mesh3_edge_t *commonEdge(svo_gsrm_t *g,
+                                         bor_mesh3_vertex_t *v1,
+                                         bor_mesh3_vertex_t *v2)
+{
+    node_t *n1, *n2;
     edge_t *e;
-    e = bor_container_of(edge, edge_t, edge);
-    BOR_FREE(e);
+
+    if (g->params.edge_hash || g->params.compact_adj){
+        n1 = bor_container_of(v1, node_t, vert);
+        n2 = bor_container_of(v2, node_t, vert);
+        if (g->params.edge_hash){
+            e = svoEdgeHashFind(&g->edge_hash, n1->id, n2->id);
+        }else{
+            e = svoAdjFind(&n1->adj, n2->id);
+        }
+        return (e ? &e->edge : NULL);
+    }
+
+    return borMesh3VertexCommonEdge(v1, v2);
 }
 
 
@@ -714,19 +1259,19 @@ static face_t *faceNew(svo_gsrm_t *g, edge_t *e, node_t *n)
     bor_mesh3_edge_t *e2, *e3;
     int res;
 
-    e2 = borMesh3VertexCommonEdge(borMesh3EdgeVertex(&e->edge, 0), &n->vert);
-    e3 = borMesh3VertexCommonEdge(borMesh3EdgeVertex(&e->edge, 1), &n->vert);
+    e2 = commonEdge(g, borMesh3EdgeVertex(&e->edge, 0), &n->vert);
+    e3 = commonEdge(g, borMesh3EdgeVertex(&e->edge, 1), &n->vert);
     if (bor_unlikely(!e2 || !e3)){
         DBG2("Can't create face because *the* three nodes are not connected "
              " - this shouldn't happen!");
         return NULL;
     }
 
-    f = BOR_ALLOC(face_t);
+    f = svoPoolAlloc(&g->face_pool);
 
     res = borMesh3AddFace(g->mesh, &f->face, &e->edge, e2, e3);
     if (bor_unlikely(res != 0)){
-        BOR_FREE(f);
+        svoPoolRelease(&g->face_pool, f);
         return NULL;
     }
 
@@ -738,14 +1283,12 @@ static face_t *faceNew(svo_gsrm_t *g, edge_t *e, node_t *n)
 static void faceDel(svo_gsrm_t *g, face_t *f)
 {
     borMesh3RemoveFace(g->mesh, &f->face);
-    BOR_FREE(f);
+    svoPoolRelease(&g->face_pool, f);
 }
 
 static void faceDel2(bor_mesh3_face_t *face, void *data)
 {
-    face_t *f;
-    f = bor_container_of(face, face_t, face);
-    BOR_FREE(f);
+    // faces are released all at once with face pool
 }
 
 
@@ -753,31 +1296,29 @@ static void faceDel2(bor_mesh3_face_t *face, void *data)
 
 static void meshInit(svo_gsrm_t *g)
 {
-    bor_vec3_t *v;
     size_t i;
 
     for (i = 0; i < 3; i++){
         // obtain input signal
-        v = (bor_vec3_t *)borPCItGet(&g->isit);
+        drawInputPoint(g);
 
         // create new node
-        nodeNew(g, v);
-
-        // move to next point
-        borPCItNext(&g->isit);
+        nodeNew(g, g->c->is);
     }
 }
 
 static void drawInputPoint(svo_gsrm_t *g)
 {
-    if (borPCItEnd(&g->isit)){
-        // if iterator is at the end permutate point cloud again
-        borPCPermutate(g->is);
-        // and re-initialize iterator
-        borPCItInit(&g->isit, g->is);
+    if (g->sampler.len > 0){
+        g->c->is = (bor_vec3_t *)svoSamplerNext(&g->sampler);
+        return;
+    }
+
+    if (g->is_order_pos == g->is_order_len){
+        // all input signals were used, shuffle them again
+        isOrderShuffle(g);
     }
-    g->c->is = (bor_vec3_t *)borPCItGet(&g->isit);
-    borPCItNext(&g->isit);
+    g->c->is = g->is_ptr[g->is_order[g->is_order_pos++]];
 }
 
 
@@ -789,6 +1330,26 @@ static void decreaseAllErrors(svo_gsrm_t *g)
     bor_mesh3_vertex_t *v;
     node_t *n;
 
+    if (!g->params.unoptimized_err){
+        // only common factor of error counters is increased, counters
+        // themselves are renormalised once the factor gets too big (order
+        // of nodes in error heap doesn't change)
+        g->err_scale *= g->err_scale_inc;
+        if (bor_likely(g->err_scale <= SVO_ERR_SCALE_MAX))
+            return;
+
+        list = borMesh3Vertices(g->mesh);
+        BOR_LIST_FOR_EACH(list, item){
+            v = BOR_LIST_ENTRY(item, bor_mesh3_vertex_t, list);
+            n = bor_container_of(v, node_t, vert);
+            n->err /= g->err_scale;
+            if (g->err_tree)
+                svoErrTreeUpdate(g->err_tree, &n->err_tree, n->err);
+        }
+        g->err_scale = BOR_ONE;
+        return;
+    }
+
     list = borMesh3Vertices(g->mesh);
     BOR_LIST_FOR_EACH(list, item){
         v = BOR_LIST_ENTRY(item, bor_mesh3_vertex_t, list);
@@ -806,19 +1367,18 @@ static void echl(svo_gsrm_t *g)
     borNNNearest(g->nn, (const bor_vec_t *)g->c->is, 2, el);
     g->c->nearest[0] = bor_container_of(el[0], node_t, nn);
     g->c->nearest[1] = bor_container_of(el[1], node_t, nn);
+    SVO_STATS_LAP(&g->stats, SVO_STATS_NEAREST);
 
     // 2. Connect winning nodes
     echlConnectNodes(g);
+    SVO_STATS_LAP(&g->stats, SVO_STATS_HEBBIAN);
 
     // 3. Move winning node and its neighbors towards input signal
+    // + 4. Update all edges emitating from winning node
     echlMove(g);
 
-    // 4. Update all edges emitating from winning node
-    echlUpdate(g);
-
-    if (g->params.unoptimized_err){
-        decreaseAllErrors(g);
-    }
+    decreaseAllErrors(g);
+    SVO_STATS_LAP(&g->stats, SVO_STATS_ERR);
 }
 
 static void echlCommonNeighbors(svo_gsrm_t *g, node_t *n1, node_t *n2)
@@ -897,7 +1457,7 @@ static void echlRemoveNeighborsEdges(svo_gsrm_t *g)
 
     for (i = 0; i < len; i++){
         for (j = i + 1; j < len; j++){
-            edge = borMesh3VertexCommonEdge(&ns[i]->vert, &ns[j]->vert);
+            edge = commonEdge(g, &ns[i]->vert, &ns[j]->vert);
             if (edge != NULL){
                 e = bor_container_of(edge, edge_t, edge);
                 edgeDel(g, e);
@@ -929,7 +1489,7 @@ static void echlConnectNodes(svo_gsrm_t *g)
 
     // get edge connecting n1 and n2
     e = NULL;
-    edge = borMesh3VertexCommonEdge(&n1->vert, &n2->vert);
+    edge = commonEdge(g, &n1->vert, &n2->vert);
     if (edge){
         e = bor_container_of(edge, edge_t, edge);
     }
@@ -941,7 +1501,7 @@ static void echlConnectNodes(svo_gsrm_t *g)
         //DBG2("Nodes are connected");
 
         // set age of edge to zero
-        e->age = 0;
+        e->age_base = n1->wins + n2->wins;
 
         // Remove edge if opposite node lies inside thales sphere
         echlRemoveThales(g, e, n1, n2);
@@ -969,18 +1529,22 @@ _bor_inline void echlMoveNode(svo_gsrm_t *g, node_t *n, bor_real_t k)
 
     // move node
     borVec3Add(n->v, &v);
+    SVO_STATS_LAP(&g->stats, SVO_STATS_MOVE);
 
     // update node in search structure
     borNNUpdate(g->nn, &n->nn);
+    SVO_STATS_LAP(&g->stats, SVO_STATS_NN_UPDATE);
 }
 
 static void echlMove(svo_gsrm_t *g)
 {
-    bor_list_t *list, *item;
+    bor_list_t *list, *item, *tmp_item;
     bor_mesh3_edge_t *edge;
     bor_mesh3_vertex_t *wvert, *vert;
-    node_t *wn;
+    node_t *wn, *n;
+    edge_t *e;
     bor_real_t err;
+    unsigned long age;
 
     wn = g->c->nearest[0];
     wvert = &wn->vert;
@@ -991,59 +1555,45 @@ static void echlMove(svo_gsrm_t *g)
     // increase error counter
     if (!g->params.unoptimized_err){
         err  = borVec3Dist2(wn->v, g->c->is);
-        err *= g->beta_n[g->params.lambda - g->step];
         nodeIncError(g, wn, err);
     }else{
         wn->err += borVec3Dist2(wn->v, g->c->is);
     }
+    SVO_STATS_LAP(&g->stats, SVO_STATS_ERR);
 
-    // move nodes connected with the winner
-    list = borMesh3VertexEdges(wvert);
-    BOR_LIST_FOR_EACH(list, item){
-        edge = borMesh3EdgeFromVertexList(item);
-        vert = borMesh3EdgeOtherVertex(edge, wvert);
-
-        echlMoveNode(g, bor_container_of(vert, node_t, vert), g->params.en);
-    }
-}
-
-static void echlUpdate(svo_gsrm_t *g)
-{
-    node_t *wn;
-    edge_t *e;
-    bor_list_t *list, *item, *tmp_item;
-    bor_mesh3_edge_t *edge;
-    bor_mesh3_vertex_t *vert;
+    // all edges emitating from winning node get older by one
+    ++wn->wins;
 
-    wn = g->c->nearest[0];
-
-    list = borMesh3VertexEdges(&wn->vert);
+    // move nodes connected with the winner and remove edges that are too
+    // old
+    list = borMesh3VertexEdges(wvert);
     BOR_LIST_FOR_EACH_SAFE(list, item, tmp_item){
         edge = borMesh3EdgeFromVertexList(item);
-        e = bor_container_of(edge, edge_t, edge);
+        e    = bor_container_of(edge, edge_t, edge);
+        vert = borMesh3EdgeOtherVertex(edge, wvert);
+        n    = bor_container_of(vert, node_t, vert);
 
-        // increment age of edge
-        e->age++;
+        echlMoveNode(g, n, g->params.en);
 
         // if age of edge is above treshold remove edge and nodes which
         // remain unconnected
-        if (e->age > g->params.age_max){
-            // get other node than winning one
-            vert = borMesh3EdgeOtherVertex(edge, &wn->vert);
-
+        age = wn->wins + n->wins - e->age_base;
+        if (age > (unsigned long)g->params.age_max){
             // delete edge
             edgeDel(g, e);
 
             // check if n is connected in mesh, if not delete it
             if (borMesh3VertexEdgesLen(vert) == 0){
-                nodeDel(g, bor_container_of(vert, node_t, vert));
+                nodeDel(g, n);
             }
+            SVO_STATS_LAP(&g->stats, SVO_STATS_PRUNE);
         }
     }
 
     // check if winning node remains connected
-    if (borMesh3VertexEdgesLen(&wn->vert) == 0){
+    if (borMesh3VertexEdgesLen(wvert) == 0){
         nodeDel(g, wn);
+        SVO_STATS_LAP(&g->stats, SVO_STATS_PRUNE);
     }
 }
 
@@ -1079,12 +1629,18 @@ static node_t *nodeWithHighestErrCounterLinear(svo_gsrm_t *g)
 static node_t *nodeWithHighestErrCounter(svo_gsrm_t *g)
 {
     bor_pairheap_node_t *max;
+    svo_err_tree_el_t *el;
     node_t *maxn;
 
     if (g->params.unoptimized_err){
         return nodeWithHighestErrCounterLinear(g);
     }
 
+    if (g->err_tree){
+        el = svoErrTreeMax(g->err_tree);
+        return bor_container_of(el, node_t, err_tree);
+    }
+
     max  = borPairHeapMin(g->err_heap);
     maxn = bor_container_of(max, node_t, err_heap);
 
@@ -1108,10 +1664,6 @@ static node_t *nodesNeighborWithHighestErrCounter(svo_gsrm_t *g, node_t *sq)
         other_vert = borMesh3EdgeOtherVertex(edge, &sq->vert);
         n = bor_container_of(other_vert, node_t, vert);
 
-        if (!g->params.unoptimized_err){
-            nodeFixError(g, n);
-        }
-
         if (n->err > max_err){
             max_err = n->err;
             max_n   = n;
@@ -1153,7 +1705,7 @@ static void createNewNode(svo_gsrm_t *g)
     //DBG("sq: %lx, sf: %lx", (long)sq, (long)sf);
 
     // delete common edge of sq and sf
-    edge = borMesh3VertexCommonEdge(&sq->vert, &sf->vert);
+    edge = commonEdge(g, &sq->vert, &sf->vert);
     if (edge){
         edgeDel(g, bor_container_of(edge, edge_t, edge));
     }
@@ -1167,8 +1719,7 @@ static void createNewNode(svo_gsrm_t *g)
         nodeScaleError(g, sf, g->params.alpha);
         sr->err  = sq->err + sf->err;
         sr->err /= BOR_REAL(2.);
-        sr->err_cycle = g->cycle;
-        borPairHeapUpdate(g->err_heap, &sr->err_heap);
+        nodeErrUpdate(g, sr);
     }else{
         sq->err *= g->params.alpha;
         sf->err *= g->params.alpha;
@@ -1185,25 +1736,34 @@ static void createNewNode(svo_gsrm_t *g)
 
 
 /** --- Topology learning --- */
+static void learnTopologyPoint(svo_gsrm_t *g, const bor_vec_t *is)
+{
+    bor_nn_el_t *el[2];
+
+    // 1. Find two nearest nodes
+    borNNNearest(g->nn, is, 2, el);
+    g->c->nearest[0] = bor_container_of(el[0], node_t, nn);
+    g->c->nearest[1] = bor_container_of(el[1], node_t, nn);
+
+    // 2. Connect winning nodes
+    echlConnectNodes(g);
+}
+
 static void learnTopology(svo_gsrm_t *g)
 {
-    bor_vec_t *is;
     bor_pc_it_t pcit;
-    bor_nn_el_t *el[2];
+    size_t i;
 
     // for each input point
+    if (g->is_pts.data){
+        for (i = 0; i < g->is_pts.len; i++)
+            learnTopologyPoint(g, svoPtsGet(&g->is_pts, i));
+        return;
+    }
+
     borPCItInit(&pcit, g->is);
     while (!borPCItEnd(&pcit)){
-        is = borPCItGet(&pcit);
-
-        // 1. Find two nearest nodes
-        borNNNearest(g->nn, is, 2, el);
-        g->c->nearest[0] = bor_container_of(el[0], node_t, nn);
-        g->c->nearest[1] = bor_container_of(el[1], node_t, nn);
-
-        // 2. Connect winning nodes
-        echlConnectNodes(g);
-
+        learnTopologyPoint(g, borPCItGet(&pcit));
         borPCItNext(&pcit);
     }
 }
@@ -1485,11 +2045,11 @@ static void finishSurfaceEmbedTriangles(svo_gsrm_t *g)
         for (i = 0; i < g->c->common_neighb_len; i++){
             n[2] = g->c->common_neighb[i];
 
-            es[1] = borMesh3VertexCommonEdge(vs[0], &n[2]->vert);
+            es[1] = commonEdge(g, vs[0], &n[2]->vert);
             if (!es[1] || borMesh3EdgeFacesLen(es[1]) != 1)
                 continue;
 
-            es[2] = borMesh3VertexCommonEdge(vs[1], &n[2]->vert);
+            es[2] = commonEdge(g, vs[1], &n[2]->vert);
             if (!es[2] || borMesh3EdgeFacesLen(es[2]) != 1)
                 continue;
 
@@ -1603,8 +2163,8 @@ static int finishSurfaceTriangle(svo_gsrm_t *g, edge_t *e)
                 continue;
 
             // check if face can be created inside triplet of edges
-            es[0] = borMesh3VertexCommonEdge(vs[0], &s->vert);
-            es[1] = borMesh3VertexCommonEdge(vs[1], &s->vert);
+            es[0] = commonEdge(g, vs[0], &s->vert);
+            es[1] = commonEdge(g, vs[1], &s->vert);
             if ((es[0] && borMesh3EdgeFacesLen(es[0]) == 2)
                     || (es[1] && borMesh3EdgeFacesLen(es[1]) == 2))
                 continue;
@@ -1679,7 +2239,7 @@ static int finishSurfaceNewFace(svo_gsrm_t *g, edge_t *e)
         ns2[1] = bor_container_of(vs[1], node_t, vert);
 
         e_new = NULL;
-        edge = borMesh3VertexCommonEdge(&ns[0]->vert, &ns2[1]->vert);
+        edge = commonEdge(g, &ns[0]->vert, &ns2[1]->vert);
         if (edge){
             e2 = bor_container_of(edge, edge_t, edge);
         }else{
@@ -1692,7 +2252,7 @@ static int finishSurfaceNewFace(svo_gsrm_t *g, edge_t *e)
         }
 
         e_new = NULL;
-        if (!borMesh3VertexCommonEdge(&ns2[0]->vert, &ns2[1]->vert)){
+        if (!commonEdge(g, &ns2[0]->vert, &ns2[1]->vert)){
             e_new = edgeNew(g, ns2[0], ns2[1]);
         }
 
@@ -1708,7 +2268,7 @@ static int finishSurfaceNewFace(svo_gsrm_t *g, edge_t *e)
         ns2[0] = bor_container_of(vs[0], node_t, vert);
 
         e_new = NULL;
-        edge = borMesh3VertexCommonEdge(&ns[1]->vert, &ns2[0]->vert);
+        edge = commonEdge(g, &ns[1]->vert, &ns2[0]->vert);
         if (!edge){
             e_new = edgeNew(g, ns[1], ns2[0]);
         }
@@ -1724,7 +2284,7 @@ static int finishSurfaceNewFace(svo_gsrm_t *g, edge_t *e)
         ns2[1] = bor_container_of(vs[1], node_t, vert);
 
         e_new = NULL;
-        edge = borMesh3VertexCommonEdge(&ns[0]->vert, &ns2[1]->vert);
+        edge = commonEdge(g, &ns[0]->vert, &ns2[1]->vert);
         if (!edge){
             e_new = edgeNew(g, ns[0], ns2[1]);
         }
@@ -1744,13 +2304,10 @@ static int errHeapLT(const bor_pairheap_node_t *_n1,
                      const bor_pairheap_node_t *_n2,
                      void *data)
 {
-    svo_gsrm_t *g = (svo_gsrm_t *)data;
     node_t *n1, *n2;
 
     n1 = bor_container_of(_n1, node_t, err_heap);
     n2 = bor_container_of(_n2, node_t, err_heap);
 
-    nodeFixError(g, n1);
-    nodeFixError(g, n2);
     return n1->err > n2->err;
 }
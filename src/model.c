@@ -0,0 +1,469 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <boruvka/alloc.h>
+#include "gng/model.h"
+#include "gng/parallel.h"
+
+#define ENDIAN 0x01020304u
+/** Alignment of sections */
+#define ALIGN 64
+
+/** Rounds offset up to ALIGN */
+#define ALIGN_UP(off) (((off) + ALIGN - 1) & ~(uint64_t)(ALIGN - 1))
+
+struct _build_t {
+    int dim;
+    const bor_real_t **w; /*!< Weight vectors by original indices */
+    uint32_t *perm;       /*!< Original indices in order of kd-tree */
+    uint32_t *axis;       /*!< Split axes */
+};
+typedef struct _build_t build_t;
+
+/** Value of {axis}'th element of weight of node at position {i} */
+#define W(b, i, axis) ((b)->w[(b)->perm[i]][axis])
+
+/** Finds axis with the widest spread of nodes from [lo, hi) */
+static uint32_t buildAxis(build_t *b, size_t lo, size_t hi)
+{
+    bor_real_t min, max, v, best;
+    uint32_t axis;
+    size_t i;
+    int d;
+
+    axis = 0;
+    best = -BOR_ONE;
+    for (d = 0; d < b->dim; d++){
+        min = max = W(b, lo, d);
+        for (i = lo + 1; i < hi; i++){
+            v = W(b, i, d);
+            if (v < min)
+                min = v;
+            if (v > max)
+                max = v;
+        }
+
+        if (max - min > best){
+            best = max - min;
+            axis = d;
+        }
+    }
+
+    return axis;
+}
+
+/** Reorders .perm[lo, hi) so that the node at position {k} is at its
+ *  sorted position along {axis} (quickselect) */
+static void buildSelect(build_t *b, size_t lo, size_t hi, size_t k,
+                        uint32_t axis)
+{
+    bor_real_t pivot;
+    size_t i, j;
+    uint32_t tmp;
+
+    hi = hi - 1;
+    while (lo < hi){
+        pivot = W(b, lo + (hi - lo) / 2, axis);
+        i = lo;
+        j = hi;
+        while (i <= j){
+            while (W(b, i, axis) < pivot)
+                i++;
+            while (W(b, j, axis) > pivot)
+                j--;
+            if (i <= j){
+                tmp = b->perm[i];
+                b->perm[i] = b->perm[j];
+                b->perm[j] = tmp;
+                i++;
+                if (j == 0)
+                    break;
+                j--;
+            }
+        }
+
+        if (k <= j){
+            hi = j;
+        }else if (k >= i){
+            lo = i;
+        }else{
+            break;
+        }
+    }
+}
+
+static void build(build_t *b, size_t lo, size_t hi)
+{
+    size_t mid;
+    uint32_t axis;
+
+    if (hi - lo <= SVO_MODEL_LEAF)
+        return;
+
+    axis = buildAxis(b, lo, hi);
+    mid  = lo + (hi - lo) / 2;
+    buildSelect(b, lo, hi, mid, axis);
+    b->axis[mid] = axis;
+
+    build(b, lo, mid);
+    build(b, mid + 1, hi);
+}
+
+/** Writes {size} bytes at offset {off} (padding by zeros from {*pos}) */
+static int writeSection(FILE *fout, uint64_t *pos, uint64_t off,
+                        const void *buf, size_t size)
+{
+    static const char zeros[ALIGN] = { 0 };
+
+    if (off > *pos && fwrite(zeros, 1, off - *pos, fout) != off - *pos)
+        return -1;
+    if (size > 0 && fwrite(buf, 1, size, fout) != size)
+        return -1;
+    *pos = off + size;
+    return 0;
+}
+
+int svoModelWrite(const char *fn, int dim, size_t len, const bor_real_t **w,
+                  size_t edges_len, const uint32_t *edges, uint32_t *order)
+{
+    svo_model_header_t h;
+    build_t b;
+    FILE *fout;
+    bor_real_t *ws;
+    uint64_t *adj_ptr, pos;
+    uint32_t *adj, *pos_of, n1, n2;
+    size_t i;
+    int ret;
+
+    // order nodes by kd-tree
+    b.dim  = dim;
+    b.w    = w;
+    b.perm = BOR_ALLOC_ARR(uint32_t, len + 1);
+    b.axis = BOR_ALLOC_ARR(uint32_t, len + 1);
+    for (i = 0; i < len; i++){
+        b.perm[i] = i;
+        b.axis[i] = 0;
+    }
+    build(&b, 0, len);
+
+    pos_of = (order ? order : BOR_ALLOC_ARR(uint32_t, len + 1));
+    ws = BOR_ALLOC_ARR(bor_real_t, len * dim + 1);
+    for (i = 0; i < len; i++){
+        pos_of[b.perm[i]] = i;
+        memcpy(ws + i * dim, w[b.perm[i]], sizeof(bor_real_t) * dim);
+    }
+
+    // adjacency in CSR form
+    adj_ptr = BOR_ALLOC_ARR(uint64_t, len + 1);
+    adj     = BOR_ALLOC_ARR(uint32_t, 2 * edges_len + 1);
+    memset(adj_ptr, 0, sizeof(uint64_t) * (len + 1));
+    for (i = 0; i < edges_len; i++){
+        adj_ptr[pos_of[edges[2 * i]] + 1]++;
+        adj_ptr[pos_of[edges[2 * i + 1]] + 1]++;
+    }
+    for (i = 0; i < len; i++)
+        adj_ptr[i + 1] += adj_ptr[i];
+    for (i = 0; i < edges_len; i++){
+        n1 = pos_of[edges[2 * i]];
+        n2 = pos_of[edges[2 * i + 1]];
+        adj[adj_ptr[n1]++] = n2;
+        adj[adj_ptr[n2]++] = n1;
+    }
+    // offsets were shifted by filling, move them back
+    for (i = len; i > 0; i--)
+        adj_ptr[i] = adj_ptr[i - 1];
+    adj_ptr[0] = 0;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SVO_MODEL_MAGIC, sizeof(SVO_MODEL_MAGIC));
+    h.endian      = ENDIAN;
+    h.dim         = dim;
+    h.elsize      = sizeof(bor_real_t);
+    h.leaf        = SVO_MODEL_LEAF;
+    h.len         = len;
+    h.edges_len   = edges_len;
+    h.weights_off = ALIGN_UP(sizeof(h));
+    h.adj_ptr_off = ALIGN_UP(h.weights_off + sizeof(bor_real_t) * len * dim);
+    h.adj_off     = h.adj_ptr_off + sizeof(uint64_t) * (len + 1);
+    h.axis_off    = ALIGN_UP(h.adj_off + sizeof(uint32_t) * 2 * edges_len);
+    h.size        = h.axis_off + sizeof(uint32_t) * len;
+
+    ret = -1;
+    fout = fopen(fn, "wb");
+    if (fout){
+        pos = 0;
+        ret = 0;
+        ret |= writeSection(fout, &pos, 0, &h, sizeof(h));
+        ret |= writeSection(fout, &pos, h.weights_off, ws,
+                            sizeof(bor_real_t) * len * dim);
+        ret |= writeSection(fout, &pos, h.adj_ptr_off, adj_ptr,
+                            sizeof(uint64_t) * (len + 1));
+        ret |= writeSection(fout, &pos, h.adj_off, adj,
+                            sizeof(uint32_t) * 2 * edges_len);
+        ret |= writeSection(fout, &pos, h.axis_off, b.axis,
+                            sizeof(uint32_t) * len);
+        if (fclose(fout) != 0)
+            ret = -1;
+    }
+    if (ret != 0)
+        fprintf(stderr, "Model Error: Can't write file `%s'.\n", fn);
+
+    BOR_FREE(b.perm);
+    BOR_FREE(b.axis);
+    if (!order)
+        BOR_FREE(pos_of);
+    BOR_FREE(ws);
+    BOR_FREE(adj_ptr);
+    BOR_FREE(adj);
+
+    return ret;
+}
+
+/** Returns true if {num} elements of {elsize} bytes each starting at
+ *  offset {off} aligned to {align} fit into file of {size} bytes */
+static int sectionValid(uint64_t off, uint64_t num, uint64_t elsize,
+                        uint64_t align, uint64_t size)
+{
+    if (off % align != 0 || off > size)
+        return 0;
+    return num <= (size - off) / elsize;
+}
+
+/** Returns true if split axes and adjacency of model {m} refer only to
+ *  existing dimensions and nodes */
+static int contentsValid(const svo_model_t *m)
+{
+    size_t i;
+
+    if (m->adj_ptr[0] != 0 || m->adj_ptr[m->len] != 2 * m->edges_len)
+        return 0;
+
+    for (i = 0; i < m->len; i++){
+        if (m->axis[i] >= (uint32_t)m->dim
+                || m->adj_ptr[i + 1] < m->adj_ptr[i])
+            return 0;
+    }
+
+    for (i = 0; i < 2 * m->edges_len; i++){
+        if (m->adj[i] >= m->len)
+            return 0;
+    }
+
+    return 1;
+}
+
+int svoModelOpen(svo_model_t *m, const char *fn)
+{
+    const svo_model_header_t *h;
+    struct stat st;
+    const char *base;
+    int fd;
+
+    memset(m, 0, sizeof(*m));
+
+    fd = open(fn, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0){
+        fprintf(stderr, "Model Error: Can't open file `%s'.\n", fn);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    m->map_size = st.st_size;
+    if (m->map_size >= sizeof(svo_model_header_t)){
+        // shared mapping, so all processes use the same pages
+        m->map = mmap(NULL, m->map_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (m->map == MAP_FAILED)
+            m->map = NULL;
+    }
+    close(fd);
+
+    if (!m->map){
+        fprintf(stderr, "Model Error: Can't map file `%s'.\n", fn);
+        return -1;
+    }
+
+    h = (const svo_model_header_t *)m->map;
+    if (memcmp(h->magic, SVO_MODEL_MAGIC, sizeof(SVO_MODEL_MAGIC)) != 0
+            || h->endian != ENDIAN
+            || h->elsize != sizeof(bor_real_t)
+            || h->dim == 0
+            || h->size > m->map_size){
+        fprintf(stderr, "Model Error: `%s' isn't valid model (or it was"
+                        " written with different precision).\n", fn);
+        svoModelClose(m);
+        return -1;
+    }
+
+    // all sections must lie within the file
+    if (h->len == 0
+            || h->len > UINT32_MAX
+            || h->leaf == 0
+            || !sectionValid(h->weights_off, h->len,
+                             (uint64_t)h->dim * sizeof(bor_real_t),
+                             sizeof(bor_real_t), h->size)
+            || !sectionValid(h->adj_ptr_off, h->len + 1, sizeof(uint64_t),
+                             sizeof(uint64_t), h->size)
+            || !sectionValid(h->adj_off, h->edges_len, 2 * sizeof(uint32_t),
+                             sizeof(uint32_t), h->size)
+            || !sectionValid(h->axis_off, h->len, sizeof(uint32_t),
+                             sizeof(uint32_t), h->size)){
+        fprintf(stderr, "Model Error: `%s' is empty or corrupted (sections"
+                        " don't fit into the file).\n", fn);
+        svoModelClose(m);
+        return -1;
+    }
+
+    base = (const char *)m->map;
+    m->dim       = h->dim;
+    m->len       = h->len;
+    m->edges_len = h->edges_len;
+    m->leaf      = h->leaf;
+    m->w         = (const bor_real_t *)(base + h->weights_off);
+    m->adj_ptr   = (const uint64_t *)(base + h->adj_ptr_off);
+    m->adj       = (const uint32_t *)(base + h->adj_off);
+    m->axis      = (const uint32_t *)(base + h->axis_off);
+
+    // one pass over contents, so that corrupted file can't make lookups
+    // read outside of the mapping or the query vector
+    if (!contentsValid(m)){
+        fprintf(stderr, "Model Error: `%s' is corrupted (invalid split axis"
+                        " or adjacency).\n", fn);
+        svoModelClose(m);
+        return -1;
+    }
+
+    // kd-tree is traversed rather randomly
+    madvise(m->map, m->map_size, MADV_RANDOM);
+
+    return 0;
+}
+
+void svoModelClose(svo_model_t *m)
+{
+    if (m->map)
+        munmap(m->map, m->map_size);
+    memset(m, 0, sizeof(*m));
+}
+
+_bor_inline bor_real_t distSq(int dim, const bor_real_t *a, const bor_real_t *b)
+{
+    bor_real_t d, dist;
+    int i;
+
+    dist = BOR_ZERO;
+    for (i = 0; i < dim; i++){
+        d = a[i] - b[i];
+        dist += d * d;
+    }
+    return dist;
+}
+
+static void nearest(const svo_model_t *m, const bor_real_t *v,
+                    size_t lo, size_t hi, size_t *best, bor_real_t *best_dist)
+{
+    const bor_real_t *w;
+    bor_real_t d, diff;
+    size_t i, mid;
+
+    while (hi - lo > m->leaf){
+        mid = lo + (hi - lo) / 2;
+        w = svoModelWeight(m, mid);
+        d = distSq(m->dim, v, w);
+        if (d < *best_dist){
+            *best = mid;
+            *best_dist = d;
+        }
+
+        // descend into the side of split where {v} lies, the other side
+        // is visited only if it can contain nearer node
+        diff = v[m->axis[mid]] - w[m->axis[mid]];
+        if (diff < BOR_ZERO){
+            nearest(m, v, lo, mid, best, best_dist);
+            if (diff * diff >= *best_dist)
+                return;
+            lo = mid + 1;
+        }else{
+            nearest(m, v, mid + 1, hi, best, best_dist);
+            if (diff * diff >= *best_dist)
+                return;
+            hi = mid;
+        }
+    }
+
+    for (i = lo; i < hi; i++){
+        d = distSq(m->dim, v, svoModelWeight(m, i));
+        if (d < *best_dist){
+            *best = i;
+            *best_dist = d;
+        }
+    }
+}
+
+size_t svoModelNearest(const svo_model_t *m, const bor_real_t *v,
+                       bor_real_t *dist2)
+{
+    size_t best;
+    bor_real_t best_dist;
+
+    best = 0;
+    best_dist = BOR_REAL_MAX;
+    nearest(m, v, 0, m->len, &best, &best_dist);
+
+    if (dist2)
+        *dist2 = best_dist;
+    return best;
+}
+
+
+struct _quantize_t {
+    const svo_model_t *m;
+    const bor_real_t *vs;
+    uint32_t *ids;
+    bor_real_t *dist2;
+};
+typedef struct _quantize_t quantize_t;
+
+static void quantize(size_t from, size_t to, int thread_id, void *data)
+{
+    quantize_t *q = (quantize_t *)data;
+    bor_real_t d;
+    size_t i;
+
+    for (i = from; i < to; i++){
+        q->ids[i] = svoModelNearest(q->m, q->vs + i * q->m->dim, &d);
+        if (q->dist2)
+            q->dist2[i] = d;
+    }
+}
+
+void svoModelQuantize(const svo_model_t *m, const bor_real_t *vs, size_t len,
+                      uint32_t *ids, bor_real_t *dist2, int num_threads)
+{
+    quantize_t q;
+
+    q.m     = m;
+    q.vs    = vs;
+    q.ids   = ids;
+    q.dist2 = dist2;
+    svoParallelFor(num_threads, len, quantize, &q);
+}
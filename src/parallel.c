@@ -0,0 +1,243 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <boruvka/alloc.h>
+#include "gng/parallel.h"
+
+struct _chunk_t {
+    pthread_t th;
+    size_t from, to;
+    int id;
+    svo_parallel_fn fn;
+    void *data;
+};
+typedef struct _chunk_t chunk_t;
+
+struct _worker_t {
+    pthread_t th;
+    int id;
+    svo_parallel_pool_t *pool;
+};
+typedef struct _worker_t worker_t;
+
+struct _svo_parallel_pool_t {
+    int num_threads;
+    worker_t *workers;    /*!< Workers 1 .. num_threads - 1 */
+
+    pthread_mutex_t run_lock; /*!< Serializes svoParallelPoolFor() */
+    pthread_mutex_t lock;
+    pthread_cond_t job_cond;  /*!< Signaled when new job is posted */
+    pthread_cond_t done_cond; /*!< Signaled when last worker finishes */
+    unsigned long job;    /*!< Sequence number of current job */
+    int pending;          /*!< Number of workers still on current job */
+    int quit;
+
+    size_t len;           /*!< Current job */
+    int chunks;
+    svo_parallel_fn fn;
+    void *data;
+};
+
+static void *chunkRun(void *arg)
+{
+    chunk_t *c = (chunk_t *)arg;
+    c->fn(c->from, c->to, c->id, c->data);
+    return NULL;
+}
+
+/** Computes range of i'th of {num} chunks of [0, len) */
+static void chunkRange(size_t len, int num, int i, size_t *from, size_t *to)
+{
+    size_t size, rem;
+
+    size = len / num;
+    rem  = len % num;
+    *from = size * i + ((size_t)i < rem ? (size_t)i : rem);
+    *to   = *from + size + ((size_t)i < rem ? 1 : 0);
+}
+
+static void *workerRun(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    svo_parallel_pool_t *pool = w->pool;
+    unsigned long job = 0;
+    size_t from, to;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1){
+        while (!pool->quit && pool->job == job)
+            pthread_cond_wait(&pool->job_cond, &pool->lock);
+        if (pool->quit)
+            break;
+        job = pool->job;
+
+        if (w->id < pool->chunks){
+            pthread_mutex_unlock(&pool->lock);
+            chunkRange(pool->len, pool->chunks, w->id, &from, &to);
+            pool->fn(from, to, w->id, pool->data);
+            pthread_mutex_lock(&pool->lock);
+        }
+
+        if (--pool->pending == 0)
+            pthread_cond_signal(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+void svoParallelFor(int num_threads, size_t len,
+                    svo_parallel_fn fn, void *data)
+{
+    chunk_t *chunks;
+    int i;
+
+    if (num_threads > (int)len)
+        num_threads = (int)len;
+
+    if (num_threads <= 1){
+        if (len > 0)
+            fn(0, len, 0, data);
+        return;
+    }
+
+    chunks = BOR_ALLOC_ARR(chunk_t, num_threads);
+
+    for (i = 0; i < num_threads; i++){
+        chunkRange(len, num_threads, i, &chunks[i].from, &chunks[i].to);
+        chunks[i].id   = i;
+        chunks[i].fn   = fn;
+        chunks[i].data = data;
+    }
+
+    for (i = 1; i < num_threads; i++){
+        if (pthread_create(&chunks[i].th, NULL, chunkRun, &chunks[i]) != 0){
+            fprintf(stderr, "Parallel Error: Can't create thread.\n");
+            exit(-1);
+        }
+    }
+
+    chunkRun(&chunks[0]);
+
+    for (i = 1; i < num_threads; i++){
+        pthread_join(chunks[i].th, NULL);
+    }
+
+    BOR_FREE(chunks);
+}
+
+svo_parallel_pool_t *svoParallelPoolNew(int num_threads)
+{
+    svo_parallel_pool_t *pool;
+    int i;
+
+    pool = BOR_ALLOC(svo_parallel_pool_t);
+    pool->num_threads = (num_threads > 1 ? num_threads : 1);
+    pool->workers = NULL;
+    pool->job = 0;
+    pool->pending = 0;
+    pool->quit = 0;
+    pool->len = 0;
+    pool->chunks = 0;
+    pool->fn = NULL;
+    pool->data = NULL;
+
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->job_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    if (pool->num_threads > 1){
+        pool->workers = BOR_ALLOC_ARR(worker_t, pool->num_threads);
+        for (i = 1; i < pool->num_threads; i++){
+            pool->workers[i].id   = i;
+            pool->workers[i].pool = pool;
+            if (pthread_create(&pool->workers[i].th, NULL, workerRun,
+                               &pool->workers[i]) != 0){
+                fprintf(stderr, "Parallel Error: Can't create thread.\n");
+                exit(-1);
+            }
+        }
+    }
+
+    return pool;
+}
+
+void svoParallelPoolDel(svo_parallel_pool_t *pool)
+{
+    int i;
+
+    if (pool->workers){
+        pthread_mutex_lock(&pool->lock);
+        pool->quit = 1;
+        pthread_cond_broadcast(&pool->job_cond);
+        pthread_mutex_unlock(&pool->lock);
+
+        for (i = 1; i < pool->num_threads; i++)
+            pthread_join(pool->workers[i].th, NULL);
+        BOR_FREE(pool->workers);
+    }
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->job_cond);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+    BOR_FREE(pool);
+}
+
+void svoParallelPoolFor(svo_parallel_pool_t *pool, size_t len,
+                        svo_parallel_fn fn, void *data)
+{
+    size_t from, to;
+    int chunks;
+
+    chunks = pool->num_threads;
+    if (chunks > (int)len)
+        chunks = (int)len;
+
+    if (chunks <= 1){
+        if (len > 0)
+            fn(0, len, 0, data);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->run_lock);
+
+    // post job, all workers are woken up and those without chunk only
+    // report back
+    pthread_mutex_lock(&pool->lock);
+    pool->len     = len;
+    pool->chunks  = chunks;
+    pool->fn      = fn;
+    pool->data    = data;
+    pool->pending = pool->num_threads - 1;
+    ++pool->job;
+    pthread_cond_broadcast(&pool->job_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    chunkRange(len, chunks, 0, &from, &to);
+    fn(from, to, 0, data);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->run_lock);
+}
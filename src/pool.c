@@ -0,0 +1,65 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <boruvka/alloc.h>
+#include "gng/pool.h"
+
+/** Elements are aligned to this number of bytes */
+#define POOL_ALIGN 16
+
+void svoPoolInit(svo_pool_t *pool, size_t el_size, size_t slab_els)
+{
+    if (el_size < sizeof(void *))
+        el_size = sizeof(void *);
+    pool->el_size = (el_size + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+    pool->slab_els = (slab_els > 0 ? slab_els : SVO_POOL_SLAB_ELS);
+
+    pool->slabs = NULL;
+    pool->slabs_len = pool->slabs_size = 0;
+    pool->cur = NULL;
+    pool->cur_left = 0;
+    pool->free = NULL;
+    pool->len = 0;
+}
+
+void svoPoolFree(svo_pool_t *pool)
+{
+    size_t i;
+
+    for (i = 0; i < pool->slabs_len; i++)
+        BOR_FREE(pool->slabs[i]);
+    if (pool->slabs)
+        BOR_FREE(pool->slabs);
+
+    pool->slabs = NULL;
+    pool->slabs_len = pool->slabs_size = 0;
+    pool->cur = NULL;
+    pool->cur_left = 0;
+    pool->free = NULL;
+    pool->len = 0;
+}
+
+void __svoPoolGrow(svo_pool_t *pool)
+{
+    if (pool->slabs_len == pool->slabs_size){
+        pool->slabs_size = (pool->slabs_size == 0 ? 16 : 2 * pool->slabs_size);
+        pool->slabs = BOR_REALLOC_ARR(pool->slabs, void *, pool->slabs_size);
+    }
+
+    pool->cur = BOR_ALLOC_ARR(char, pool->el_size * pool->slab_els);
+    pool->cur_left = pool->slab_els;
+    pool->slabs[pool->slabs_len++] = pool->cur;
+}
@@ -0,0 +1,548 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <boruvka/alloc.h>
+#include "gng/pts.h"
+#include "gng/parallel.h"
+
+/** Minimal size of part of text file parsed by one thread */
+#define TEXT_PART_MIN_SIZE (1 << 20)
+
+/** Part of text file parsed by one thread */
+struct _text_part_t {
+    const char *from, *to; /*!< Range of text */
+    bor_real_t *data;      /*!< Parsed vectors */
+    size_t len, size;      /*!< Number of parsed and allocated vectors */
+    bor_real_t *aabb;      /*!< Bounding box of parsed vectors */
+};
+typedef struct _text_part_t text_part_t;
+
+struct _text_t {
+    text_part_t *parts;
+    int dim;
+};
+typedef struct _text_t text_t;
+
+static void textPart(size_t from, size_t to, int thread_id, void *data);
+static int writeHeader(FILE *fout, int dim, int elsize, size_t len);
+static int writeVec(FILE *fout, const bor_real_t *v, int dim, int elsize);
+
+void svoPtsInit(svo_pts_t *pts)
+{
+    pts->dim  = 0;
+    pts->len  = 0;
+    pts->data = NULL;
+    pts->map  = NULL;
+    pts->map_size = 0;
+    pts->conv = NULL;
+    pts->aabb = NULL;
+}
+
+static int headerCheck(const svo_pts_header_t *h)
+{
+    return memcmp(h->magic, SVO_PTS_MAGIC, sizeof(SVO_PTS_MAGIC)) == 0;
+}
+
+int svoPtsIsBinary(const char *fn)
+{
+    svo_pts_header_t h;
+    FILE *fin;
+    int ret;
+
+    fin = fopen(fn, "rb");
+    if (!fin)
+        return 0;
+
+    ret = (fread(&h, sizeof(h), 1, fin) == 1 && headerCheck(&h));
+    fclose(fin);
+
+    return ret;
+}
+
+int svoPtsOpen(svo_pts_t *pts, const char *fn)
+{
+    const svo_pts_header_t *h;
+    struct stat st;
+    size_t i, num;
+    int fd;
+
+    svoPtsInit(pts);
+
+    fd = open(fn, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0){
+        fprintf(stderr, "Pts Error: Can't open file `%s'.\n", fn);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    pts->map_size = st.st_size;
+    if (pts->map_size >= sizeof(svo_pts_header_t)){
+        pts->map = mmap(NULL, pts->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (pts->map == MAP_FAILED)
+            pts->map = NULL;
+    }
+    close(fd);
+
+    if (!pts->map){
+        fprintf(stderr, "Pts Error: Can't map file `%s'.\n", fn);
+        return -1;
+    }
+
+    h = (const svo_pts_header_t *)pts->map;
+    if (!headerCheck(h) || h->endian != SVO_PTS_ENDIAN
+            || (h->elsize != 4 && h->elsize != 8) || h->dim == 0
+            || (pts->map_size - sizeof(*h)) / h->elsize / h->dim < h->len){
+        fprintf(stderr, "Pts Error: `%s' isn't valid binary point cloud.\n", fn);
+        svoPtsClose(pts);
+        return -1;
+    }
+
+    pts->dim = h->dim;
+    pts->len = h->len;
+    num = pts->len * pts->dim;
+
+    if (h->elsize == sizeof(bor_real_t)){
+        pts->data = (const bor_real_t *)(h + 1);
+
+        // points are read mostly randomly
+        madvise(pts->map, pts->map_size, MADV_RANDOM);
+    }else{
+        pts->conv = BOR_ALLOC_ARR(bor_real_t, num);
+        if (h->elsize == 4){
+            for (i = 0; i < num; i++)
+                pts->conv[i] = ((const float *)(h + 1))[i];
+        }else{
+            for (i = 0; i < num; i++)
+                pts->conv[i] = ((const double *)(h + 1))[i];
+        }
+        pts->data = pts->conv;
+
+        munmap(pts->map, pts->map_size);
+        pts->map = NULL;
+        pts->map_size = 0;
+    }
+
+    return 0;
+}
+
+int svoPtsLoadText(svo_pts_t *pts, const char *fn, int dim, int num_threads)
+{
+    text_t text;
+    text_part_t *part;
+    const char *str, *end;
+    struct stat st;
+    size_t size, len, i;
+    int fd, num, j, d;
+
+    svoPtsInit(pts);
+    pts->dim = dim;
+
+    fd = open(fn, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0){
+        fprintf(stderr, "Pts Error: Can't open file `%s'.\n", fn);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    size = st.st_size;
+    str  = NULL;
+    if (size > 0){
+        str = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (str == MAP_FAILED){
+            fprintf(stderr, "Pts Error: Can't map file `%s'.\n", fn);
+            close(fd);
+            return -1;
+        }
+        madvise((void *)str, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    // split file into parts at line boundaries
+    if (num_threads <= 0)
+        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    num = size / TEXT_PART_MIN_SIZE + 1;
+    if (num > num_threads)
+        num = num_threads;
+    if (num < 1)
+        num = 1;
+
+    text.dim   = dim;
+    text.parts = BOR_ALLOC_ARR(text_part_t, num);
+    end = str;
+    for (j = 0; j < num; j++){
+        part = text.parts + j;
+        part->from = end;
+        if (j == num - 1){
+            end = str + size;
+        }else{
+            end = str + (size / num) * (j + 1);
+            if (end < part->from)
+                end = part->from;
+            end = memchr(end, '\n', str + size - end);
+            end = (end ? end + 1 : str + size);
+        }
+        part->to   = end;
+        part->data = NULL;
+        part->len  = part->size = 0;
+        part->aabb = BOR_ALLOC_ARR(bor_real_t, 2 * dim);
+    }
+
+    svoParallelFor(num, num, textPart, &text);
+
+    // concatenate parts
+    len = 0;
+    for (j = 0; j < num; j++)
+        len += text.parts[j].len;
+
+    pts->len  = len;
+    pts->conv = BOR_ALLOC_ARR(bor_real_t, len * dim + 1);
+    pts->aabb = BOR_ALLOC_ARR(bor_real_t, 2 * dim);
+    for (d = 0; d < dim; d++){
+        pts->aabb[2 * d]     = BOR_REAL_MAX;
+        pts->aabb[2 * d + 1] = -BOR_REAL_MAX;
+    }
+
+    i = 0;
+    for (j = 0; j < num; j++){
+        part = text.parts + j;
+        if (part->len > 0){
+            memcpy(pts->conv + i, part->data,
+                   sizeof(bor_real_t) * part->len * dim);
+            i += part->len * dim;
+        }
+
+        for (d = 0; d < dim; d++){
+            pts->aabb[2 * d]     = BOR_MIN(pts->aabb[2 * d], part->aabb[2 * d]);
+            pts->aabb[2 * d + 1] = BOR_MAX(pts->aabb[2 * d + 1],
+                                           part->aabb[2 * d + 1]);
+        }
+
+        if (part->data)
+            BOR_FREE(part->data);
+        BOR_FREE(part->aabb);
+    }
+    BOR_FREE(text.parts);
+    pts->data = pts->conv;
+
+    if (str)
+        munmap((void *)str, size);
+
+    return 0;
+}
+
+int svoPtsLoad(svo_pts_t *pts, const char *fn, int dim, int num_threads)
+{
+    if (!svoPtsIsBinary(fn))
+        return svoPtsLoadText(pts, fn, dim, num_threads);
+
+    if (svoPtsOpen(pts, fn) != 0)
+        return -1;
+    if (pts->dim != dim){
+        fprintf(stderr, "Pts Error: `%s' contains %d-D points instead of"
+                        " %d-D.\n", fn, pts->dim, dim);
+        svoPtsClose(pts);
+        return -1;
+    }
+    return 0;
+}
+
+void svoPtsClose(svo_pts_t *pts)
+{
+    if (pts->map)
+        munmap(pts->map, pts->map_size);
+    if (pts->conv)
+        BOR_FREE(pts->conv);
+    if (pts->aabb)
+        BOR_FREE(pts->aabb);
+    svoPtsInit(pts);
+}
+
+void svoPtsAABB(const svo_pts_t *pts, bor_real_t *aabb)
+{
+    const bor_real_t *v;
+    size_t i;
+    int d;
+
+    if (pts->aabb){
+        memcpy(aabb, pts->aabb, sizeof(bor_real_t) * 2 * pts->dim);
+        return;
+    }
+
+    for (d = 0; d < pts->dim; d++){
+        aabb[2 * d]     = BOR_REAL_MAX;
+        aabb[2 * d + 1] = -BOR_REAL_MAX;
+    }
+
+    for (i = 0; i < pts->len; i++){
+        v = svoPtsGet(pts, i);
+        for (d = 0; d < pts->dim; d++){
+            if (v[d] < aabb[2 * d])
+                aabb[2 * d] = v[d];
+            if (v[d] > aabb[2 * d + 1])
+                aabb[2 * d + 1] = v[d];
+        }
+    }
+}
+
+size_t svoPtsAddToPC(const svo_pts_t *pts, bor_pc_t *pc)
+{
+    size_t i;
+
+    for (i = 0; i < pts->len; i++)
+        borPCAdd(pc, (bor_vec_t *)svoPtsGet(pts, i));
+    return pts->len;
+}
+
+int svoPtsWrite(const svo_pts_t *pts, const char *fn, int elsize)
+{
+    FILE *fout;
+    size_t i;
+    int ok;
+
+    fout = fopen(fn, "wb");
+    if (!fout){
+        fprintf(stderr, "Pts Error: Can't open file `%s'.\n", fn);
+        return -1;
+    }
+
+    ok = writeHeader(fout, pts->dim, elsize, pts->len);
+    for (i = 0; ok && i < pts->len; i++)
+        ok = writeVec(fout, svoPtsGet(pts, i), pts->dim, elsize);
+
+    if (fclose(fout) != 0)
+        ok = 0;
+    if (!ok){
+        fprintf(stderr, "Pts Error: Can't write into file `%s'.\n", fn);
+        return -1;
+    }
+
+    return 0;
+}
+
+int svoPtsWritePC(bor_pc_t *pc, const char *fn, int elsize)
+{
+    bor_pc_it_t it;
+    FILE *fout;
+    int ok;
+
+    fout = fopen(fn, "wb");
+    if (!fout){
+        fprintf(stderr, "Pts Error: Can't open file `%s'.\n", fn);
+        return -1;
+    }
+
+    ok = writeHeader(fout, borPCDim(pc), elsize, borPCLen(pc));
+
+    borPCItInit(&it, pc);
+    while (ok && !borPCItEnd(&it)){
+        ok = writeVec(fout, borPCItGet(&it), borPCDim(pc), elsize);
+        borPCItNext(&it);
+    }
+
+    if (fclose(fout) != 0)
+        ok = 0;
+    if (!ok){
+        fprintf(stderr, "Pts Error: Can't write into file `%s'.\n", fn);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int writeHeader(FILE *fout, int dim, int elsize, size_t len)
+{
+    svo_pts_header_t h;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SVO_PTS_MAGIC, sizeof(SVO_PTS_MAGIC));
+    h.endian = SVO_PTS_ENDIAN;
+    h.dim    = dim;
+    h.elsize = (elsize == 0 ? (int)sizeof(bor_real_t) : elsize);
+    h.len    = len;
+    return fwrite(&h, sizeof(h), 1, fout) == 1;
+}
+
+static int writeVec(FILE *fout, const bor_real_t *v, int dim, int elsize)
+{
+    float f;
+    double d;
+    int i;
+
+    if (elsize == 0)
+        elsize = sizeof(bor_real_t);
+
+    for (i = 0; i < dim; i++){
+        if (elsize == 4){
+            f = v[i];
+            if (fwrite(&f, sizeof(f), 1, fout) != 1)
+                return 0;
+        }else{
+            d = v[i];
+            if (fwrite(&d, sizeof(d), 1, fout) != 1)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+
+
+/** Powers of ten that are exactly representable by double */
+static const double pow10tab[] = {
+    1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, 1E10, 1E11,
+    1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18, 1E19, 1E20, 1E21, 1E22
+};
+
+_bor_inline int isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/** Parses number at *s, returns 0 on success and moves *s behind it.
+ *  The number is parsed as decimal mantissa of at most 19 digits scaled
+ *  by power of ten, which is exact (as strtod()) whenever the mantissa
+ *  fits into double and the exponent is at most 22. */
+static int parseReal(const char **_s, const char *end, bor_real_t *out)
+{
+    const char *s = *_s, *t;
+    uint64_t mant;
+    int neg, eneg, exp, e, digits;
+    double val;
+
+    neg = 0;
+    if (s < end && (*s == '-' || *s == '+')){
+        neg = (*s == '-');
+        s++;
+    }
+
+    mant = 0;
+    exp = digits = 0;
+    for (; s < end && isDigit(*s); s++, digits++){
+        if (mant < UINT64_C(1000000000000000000)){
+            mant = mant * 10 + (*s - '0');
+        }else{
+            exp++;
+        }
+    }
+    if (s < end && *s == '.'){
+        for (s++; s < end && isDigit(*s); s++, digits++){
+            if (mant < UINT64_C(1000000000000000000)){
+                mant = mant * 10 + (*s - '0');
+                exp--;
+            }
+        }
+    }
+    if (digits == 0)
+        return -1;
+
+    if (s < end && (*s == 'e' || *s == 'E')){
+        t = s + 1;
+        eneg = 0;
+        if (t < end && (*t == '-' || *t == '+')){
+            eneg = (*t == '-');
+            t++;
+        }
+        if (t < end && isDigit(*t)){
+            for (e = 0; t < end && isDigit(*t); t++){
+                if (e < 10000)
+                    e = e * 10 + (*t - '0');
+            }
+            exp += (eneg ? -e : e);
+            s = t;
+        }
+    }
+
+    val = (double)mant;
+    if (exp < 0){
+        val /= (exp >= -22 ? pow10tab[-exp] : pow(10., -exp));
+    }else if (exp > 0){
+        val *= (exp <= 22 ? pow10tab[exp] : pow(10., exp));
+    }
+
+    *out = (neg ? -val : val);
+    *_s = s;
+    return 0;
+}
+
+/** Parses one line, returns 0 if {dim} numbers were read into {v}. */
+static int parseLine(const char **_s, const char *end, int dim,
+                     bor_real_t *v)
+{
+    const char *s = *_s;
+    int d, ret;
+
+    ret = 0;
+    for (d = 0; d < dim && ret == 0; d++){
+        while (s < end && (*s == ' ' || *s == '\t' || *s == '\r'))
+            s++;
+        ret = parseReal(&s, end, v + d);
+    }
+
+    // skip rest of line
+    s = memchr(s, '\n', end - s);
+    *_s = (s ? s + 1 : end);
+
+    return ret;
+}
+
+static void textPart(size_t from, size_t to, int thread_id, void *data)
+{
+    text_t *text = (text_t *)data;
+    text_part_t *part;
+    const char *s;
+    bor_real_t *v;
+    size_t i;
+    int d, dim;
+
+    dim = text->dim;
+    for (i = from; i < to; i++){
+        part = text->parts + i;
+        for (d = 0; d < dim; d++){
+            part->aabb[2 * d]     = BOR_REAL_MAX;
+            part->aabb[2 * d + 1] = -BOR_REAL_MAX;
+        }
+
+        s = part->from;
+        while (s < part->to){
+            if (part->len == part->size){
+                part->size = (part->size == 0 ? 1024 : 2 * part->size);
+                part->data = BOR_REALLOC_ARR(part->data, bor_real_t,
+                                             part->size * dim);
+            }
+
+            v = part->data + part->len * dim;
+            if (parseLine(&s, part->to, dim, v) != 0)
+                continue;
+            part->len++;
+
+            for (d = 0; d < dim; d++){
+                if (v[d] < part->aabb[2 * d])
+                    part->aabb[2 * d] = v[d];
+                if (v[d] > part->aabb[2 * d + 1])
+                    part->aabb[2 * d + 1] = v[d];
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include "gng/rng.h"
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z;
+
+    z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+void svoRngInit(svo_rng_t *r, uint64_t seed)
+{
+    int i;
+
+    // splitmix64 never gives all-zero state
+    for (i = 0; i < 4; i++)
+        r->s[i] = splitmix64(&seed);
+}
+
+void svoRngInitStream(svo_rng_t *r, uint64_t seed, unsigned long stream)
+{
+    unsigned long i;
+
+    svoRngInit(r, seed);
+    for (i = 0; i < stream; i++)
+        svoRngJump(r);
+}
+
+void svoRngJump(svo_rng_t *r)
+{
+    static const uint64_t jump[4] = {
+        UINT64_C(0x180EC6D33CFD0ABA), UINT64_C(0xD5A61266F0C9392C),
+        UINT64_C(0xA9582618E03FC9AA), UINT64_C(0x39ABDC4529B1661C)
+    };
+    uint64_t s[4] = { 0, 0, 0, 0 };
+    int i, b, j;
+
+    for (i = 0; i < 4; i++){
+        for (b = 0; b < 64; b++){
+            if (jump[i] & (UINT64_C(1) << b)){
+                for (j = 0; j < 4; j++)
+                    s[j] ^= r->s[j];
+            }
+            svoRngU64(r);
+        }
+    }
+
+    for (j = 0; j < 4; j++)
+        r->s[j] = s[j];
+}
@@ -0,0 +1,158 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <boruvka/alloc.h>
+#include "gng/sampler.h"
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z;
+
+    z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+void svoPermInit(svo_perm_t *p, uint64_t n, uint64_t seed)
+{
+    int bits, k;
+
+    // number of bits needed for n - 1
+    for (bits = 1; bits < 64 && (UINT64_C(1) << bits) < n; bits++);
+
+    p->n = n;
+    p->half_bits = (bits + 1) / 2;
+    p->half_mask = (UINT64_C(1) << p->half_bits) - 1;
+    for (k = 0; k < SVO_PERM_ROUNDS; k++)
+        p->keys[k] = splitmix64(&seed);
+}
+
+
+
+static void runsAdd(svo_sampler_t *s, size_t *size,
+                    size_t from, const bor_real_t *data)
+{
+    if (s->runs_len == *size){
+        *size = (*size == 0 ? 8 : 2 * *size);
+        s->runs = BOR_REALLOC_ARR(s->runs, svo_sampler_run_t, *size);
+    }
+    s->runs[s->runs_len].from = from;
+    s->runs[s->runs_len].data = data;
+    s->runs_len++;
+}
+
+static uint64_t epochSeed(const svo_sampler_t *s, unsigned long epoch)
+{
+    if (epoch == 0)
+        return s->seed;
+    return s->seed ^ __svoPermRound(epoch, UINT64_C(0x6A09E667F3BCC909));
+}
+
+static void samplerStart(svo_sampler_t *s, uint64_t seed)
+{
+    if (s->len == 0){
+        fprintf(stderr, "Sampler Error: No input signals.\n");
+        exit(-1);
+    }
+
+    s->seed = seed;
+    svoSamplerSeek(s, 0);
+}
+
+void svoSamplerInitPC(svo_sampler_t *s, bor_pc_t *pc, uint64_t seed)
+{
+    bor_pc_it_t it;
+    const bor_real_t *v, *prev;
+    size_t i, size;
+
+    s->runs = NULL;
+    s->runs_len = size = 0;
+    s->stride = borPCDim(pc);
+    s->len = borPCLen(pc);
+
+    // points within one chunk of point cloud are equally spaced, so
+    // spacing is taken from first two points and new run starts wherever
+    // the next point isn't where it is expected
+    prev = NULL;
+    borPCItInit(&it, pc);
+    for (i = 0; !borPCItEnd(&it); i++){
+        v = borPCItGet(&it);
+        if (i == 1 && s->runs_len == 1 && v > prev)
+            s->stride = v - prev;
+
+        if (!prev || v != prev + s->stride)
+            runsAdd(s, &size, i, v);
+
+        prev = v;
+        borPCItNext(&it);
+    }
+
+    samplerStart(s, seed);
+}
+
+void svoSamplerInitArr(svo_sampler_t *s, const bor_real_t *arr,
+                       size_t len, int dim, uint64_t seed)
+{
+    size_t size;
+
+    s->runs = NULL;
+    s->runs_len = size = 0;
+    s->stride = dim;
+    s->len = len;
+    runsAdd(s, &size, 0, arr);
+
+    samplerStart(s, seed);
+}
+
+void svoSamplerFree(svo_sampler_t *s)
+{
+    if (s->runs)
+        BOR_FREE(s->runs);
+    s->runs = NULL;
+    s->runs_len = s->len = 0;
+}
+
+uint64_t svoSamplerTell(const svo_sampler_t *s)
+{
+    return (uint64_t)s->epoch * s->len + s->pos - SVO_SAMPLER_AHEAD;
+}
+
+void svoSamplerSeek(svo_sampler_t *s, uint64_t drawn)
+{
+    unsigned int i;
+
+    s->epoch = drawn / s->len;
+    s->pos   = drawn % s->len;
+    svoPermInit(&s->perm, s->len, epochSeed(s, s->epoch));
+
+    // fill signals ahead
+    s->ahead_pos = 0;
+    for (i = 0; i < SVO_SAMPLER_AHEAD; i++){
+        if (s->pos == s->len)
+            __svoSamplerNextEpoch(s);
+        s->ahead[i] = svoSamplerGet(s, svoPermGet(&s->perm, s->pos++));
+    }
+}
+
+void __svoSamplerNextEpoch(svo_sampler_t *s)
+{
+    s->epoch++;
+    svoPermInit(&s->perm, s->len, epochSeed(s, s->epoch));
+    s->pos = 0;
+}
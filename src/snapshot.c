@@ -0,0 +1,92 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <string.h>
+#include "gng/snapshot.h"
+
+struct _header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t real_size;
+    uint32_t endian;
+};
+typedef struct _header_t header_t;
+
+#define ENDIAN 0x01020304u
+
+void svoSnapshotWriteStart(svo_snapshot_t *s, FILE *fout, uint32_t kind)
+{
+    header_t h;
+
+    s->f   = fout;
+    s->err = 0;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SVO_SNAPSHOT_MAGIC, sizeof(SVO_SNAPSHOT_MAGIC));
+    h.version   = SVO_SNAPSHOT_VERSION;
+    h.kind      = kind;
+    h.real_size = sizeof(bor_real_t);
+    h.endian    = ENDIAN;
+    svoSnapshotWrite(s, &h, sizeof(h));
+}
+
+void svoSnapshotReadStart(svo_snapshot_t *s, FILE *fin, uint32_t kind)
+{
+    header_t h;
+
+    s->f   = fin;
+    s->err = 0;
+
+    svoSnapshotRead(s, &h, sizeof(h));
+    if (memcmp(h.magic, SVO_SNAPSHOT_MAGIC, sizeof(SVO_SNAPSHOT_MAGIC)) != 0
+            || h.version != SVO_SNAPSHOT_VERSION
+            || h.kind != kind
+            || h.real_size != sizeof(bor_real_t)
+            || h.endian != ENDIAN){
+        s->err = 1;
+    }
+}
+
+void svoSnapshotWrite(svo_snapshot_t *s, const void *buf, size_t size)
+{
+    if (s->err)
+        return;
+    if (fwrite(buf, 1, size, s->f) != size)
+        s->err = 1;
+}
+
+void svoSnapshotRead(svo_snapshot_t *s, void *buf, size_t size)
+{
+    if (s->err){
+        memset(buf, 0, size);
+        return;
+    }
+    if (fread(buf, 1, size, s->f) != size){
+        memset(buf, 0, size);
+        s->err = 1;
+    }
+}
+
+int svoSnapshotEnd(svo_snapshot_t *s, const char *who)
+{
+    if (s->err){
+        fprintf(stderr, "%s Error: Can't write or read snapshot"
+                        " (or snapshot is incompatible).\n", who);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/***
+ * Svoboda
+ * --------
+ * Copyright (c)2011 Daniel Fiser <danfis@danfis.cz>
+ *
+ *  This file is part of Svoboda.
+ *
+ *  Distributed under the OSI-approved BSD License (the "License");
+ *  see accompanying file BDS-LICENSE for details or see
+ *  <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ *  This software is distributed WITHOUT ANY WARRANTY; without even the
+ *  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the License for more information.
+ */
+
+#include <string.h>
+#include "gng/stats.h"
+
+static const char *names[SVO_STATS_LEN] = {
+    "input",
+    "nearest",
+    "hebbian",
+    "err",
+    "move",
+    "nn-update",
+    "prune",
+    "new-node",
+    "topology",
+    "postprocess"
+};
+
+void svoStatsReset(svo_stats_t *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+const char *svoStatsName(int phase)
+{
+    if (phase < 0 || phase >= SVO_STATS_LEN)
+        return "unknown";
+    return names[phase];
+}
+
+void svoStatsPrint(const svo_stats_t *s, FILE *out)
+{
+    const svo_stats_phase_t *p;
+    int i;
+
+    for (i = 0; i < SVO_STATS_LEN; i++){
+        p = &s->phase[i];
+        if (p->calls == 0)
+            continue;
+
+        fprintf(out, "%-12s %12llu %16llu %10.1f\n", names[i],
+                (unsigned long long)p->calls, (unsigned long long)p->ns,
+                (double)p->ns / (double)p->calls);
+    }
+}